@@ -0,0 +1,101 @@
+# Embedding files into the binary as `constexpr` byte arrays.
+#
+# embed_files(<target> <header> <name> <file> [<name> <file> ...])
+#
+# Adds a custom target generating <header>, which defines `arci::
+# embedded_assets`: one `arci::embedded_asset` (see embedded-assets.hxx)
+# per file, found by <name>. The header is regenerated whenever a file
+# changes.
+#
+# In script mode (cmake -P) generates the header from the manifest
+# written by embed_files, the script is not meant to be run by hand.
+
+if(CMAKE_SCRIPT_MODE_FILE)
+    file(STRINGS ${MANIFEST} ENTRIES)
+
+    # CMake regular expressions have no repetition counts.
+    string(REPEAT "0x[0-9a-f][0-9a-f], " 15 LINE_PATTERN)
+    set(LINE_PATTERN "(${LINE_PATTERN}0x[0-9a-f][0-9a-f],) ")
+
+    set(ARRAYS "")
+    set(TABLE "")
+    set(INDEX 0)
+
+    foreach(ENTRY ${ENTRIES})
+        string(FIND "${ENTRY}" "\t" SEPARATOR)
+        string(SUBSTRING "${ENTRY}" 0 ${SEPARATOR} NAME)
+        math(EXPR SEPARATOR "${SEPARATOR} + 1")
+        string(SUBSTRING "${ENTRY}" ${SEPARATOR} -1 FILE)
+
+        file(READ ${FILE} CONTENT HEX)
+        file(SIZE ${FILE} SIZE)
+
+        # 16 bytes per line, a trailing zero byte keeps empty files valid
+        # and text files null-terminated.
+        string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " CONTENT
+                             "${CONTENT}")
+        string(REGEX REPLACE "${LINE_PATTERN}" "\\1\n        " CONTENT
+                             "${CONTENT}")
+
+        string(APPEND ARRAYS
+               "    // ${NAME}\n"
+               "    inline constexpr std::uint8_t file_${INDEX}[] = {\n"
+               "        ${CONTENT}0x00\n"
+               "    };\n\n")
+        string(APPEND TABLE
+               "        { \"${NAME}\", embedded_data::file_${INDEX}, ${SIZE} },\n")
+
+        math(EXPR INDEX "${INDEX} + 1")
+    endforeach()
+
+    file(
+        WRITE ${OUTPUT}
+        "// Generated by cmake/modules/EmbedFiles.cmake, do not edit.\n\n"
+        "#pragma once\n\n"
+        "#include \"embedded-assets.hxx\"\n\n"
+        "#include <array>\n"
+        "#include <cstdint>\n\n"
+        "namespace arci::embedded_data\n{\n"
+        "${ARRAYS}"
+        "} // namespace arci::embedded_data\n\n"
+        "namespace arci\n{\n"
+        "    inline constexpr std::array<embedded_asset, ${INDEX}> "
+        "embedded_assets { {\n"
+        "${TABLE}"
+        "    } };\n"
+        "} // namespace arci\n")
+
+    return()
+endif()
+
+set(EMBED_FILES_SCRIPT ${CMAKE_CURRENT_LIST_FILE})
+
+function(embed_files TARGET HEADER)
+    set(FILES ${ARGN})
+    list(LENGTH FILES FILES_LENGTH)
+    math(EXPR LAST "${FILES_LENGTH} - 1")
+
+    set(MANIFEST_CONTENT "")
+    set(DEPENDENCIES "")
+
+    foreach(INDEX RANGE 0 ${LAST} 2)
+        math(EXPR FILE_INDEX "${INDEX} + 1")
+        list(GET FILES ${INDEX} NAME)
+        list(GET FILES ${FILE_INDEX} FILE)
+
+        string(APPEND MANIFEST_CONTENT "${NAME}\t${FILE}\n")
+        list(APPEND DEPENDENCIES ${FILE})
+    endforeach()
+
+    set(MANIFEST "${HEADER}.files")
+    file(GENERATE OUTPUT ${MANIFEST} CONTENT "${MANIFEST_CONTENT}")
+
+    add_custom_command(
+        OUTPUT ${HEADER}
+        COMMAND ${CMAKE_COMMAND} -DMANIFEST=${MANIFEST} -DOUTPUT=${HEADER} -P
+                ${EMBED_FILES_SCRIPT}
+        DEPENDS ${EMBED_FILES_SCRIPT} ${MANIFEST} ${DEPENDENCIES}
+        VERBATIM)
+
+    add_custom_target(${TARGET} DEPENDS ${HEADER})
+endfunction()
@@ -19,6 +19,7 @@
 #include "imgui_impl_opengl.hxx"
 
 #include "opengl-debug.hxx"
+#include "opengl-stream-buffer.hxx"
 
 #ifdef __ANDROID__
 /* clang-format off */
@@ -46,7 +47,7 @@ static int g_ShaderHandle = 0, g_VertHandle = 0, g_FragHandle = 0;
 static int g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0;
 static int g_AttribLocationPosition = 0, g_AttribLocationUV = 0,
            g_AttribLocationColor = 0;
-static unsigned int g_VboHandle = 0, g_VaoHandle = 0, g_ElementsHandle = 0;
+static unsigned int g_VaoHandle = 0;
 
 // This is the main rendering function that you have to implement and provide to
 // ImGui (via setting up 'RenderDrawListsFn' in the ImGuiIO structure)
@@ -56,100 +57,104 @@ static unsigned int g_VboHandle = 0, g_VaoHandle = 0, g_ElementsHandle = 0;
 // If text or lines are blurry when integrating ImGui in your engine: in your
 // Render function, try translating your projection matrix by (0.5f,0.5f) or
 // (0.375f,0.375f)
-void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data)
+void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data,
+                                      arci::opengl_stream_buffer& vertex_stream,
+                                      arci::opengl_stream_buffer& index_stream)
 {
     // Avoid rendering when minimized, scale coordinates for retina displays
-    // (screen coordinates != framebuffer coordinates)
-    ImGuiIO& io = ImGui::GetIO();
-    int fb_width = (int)(io.DisplaySize.x * io.DisplayFramebufferScale.x);
-    int fb_height = (int)(io.DisplaySize.y * io.DisplayFramebufferScale.y);
+    // (screen coordinates != framebuffer coordinates).
+    // Only draw_data is used, it may be a copy drawn on another thread.
+    const ImVec2 display_size = draw_data->DisplaySize;
+    const ImVec2 fb_scale = draw_data->FramebufferScale;
+    int fb_width = (int)(display_size.x * fb_scale.x);
+    int fb_height = (int)(display_size.y * fb_scale.y);
     if (fb_width == 0 || fb_height == 0)
         return;
-    draw_data->ScaleClipRects(io.DisplayFramebufferScale);
+    draw_data->ScaleClipRects(fb_scale);
 
-    arci::opengl_check();
+    opengl_check();
     // Backup GL state
     GLenum last_active_texture;
     glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
-    arci::opengl_check();
+    opengl_check();
     glActiveTexture(GL_TEXTURE0);
-    arci::opengl_check();
+    opengl_check();
     GLint last_program;
     glGetIntegerv(GL_CURRENT_PROGRAM, &last_program);
-    arci::opengl_check();
+    opengl_check();
     GLint last_texture;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
-    arci::opengl_check();
+    opengl_check();
     GLint last_sampler;
     glGetIntegerv(GL_SAMPLER_BINDING, &last_sampler);
-    arci::opengl_check();
+    opengl_check();
     GLint last_array_buffer;
     glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
-    arci::opengl_check();
+    opengl_check();
     GLint last_element_array_buffer;
     glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &last_element_array_buffer);
-    arci::opengl_check();
+    opengl_check();
     GLint last_vertex_array;
     glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
-    arci::opengl_check();
+    opengl_check();
     // GLint last_polygon_mode[2]; open gl 4?
     // glGetIntegerv(GL_POLYGON_MODE, last_polygon_mode);
-    arci::opengl_check();
+    opengl_check();
     GLint last_viewport[4];
     glGetIntegerv(GL_VIEWPORT, last_viewport);
-    arci::opengl_check();
+    opengl_check();
     GLint last_scissor_box[4];
     glGetIntegerv(GL_SCISSOR_BOX, last_scissor_box);
-    arci::opengl_check();
+    opengl_check();
     GLenum last_blend_src_rgb;
     glGetIntegerv(GL_BLEND_SRC_RGB, (GLint*)&last_blend_src_rgb);
-    arci::opengl_check();
+    opengl_check();
     GLenum last_blend_dst_rgb;
     glGetIntegerv(GL_BLEND_DST_RGB, (GLint*)&last_blend_dst_rgb);
-    arci::opengl_check();
+    opengl_check();
     GLenum last_blend_src_alpha;
     glGetIntegerv(GL_BLEND_SRC_ALPHA, (GLint*)&last_blend_src_alpha);
-    arci::opengl_check();
+    opengl_check();
     GLenum last_blend_dst_alpha;
     glGetIntegerv(GL_BLEND_DST_ALPHA, (GLint*)&last_blend_dst_alpha);
-    arci::opengl_check();
+    opengl_check();
     GLenum last_blend_equation_rgb;
     glGetIntegerv(GL_BLEND_EQUATION_RGB, (GLint*)&last_blend_equation_rgb);
-    arci::opengl_check();
+    opengl_check();
     GLenum last_blend_equation_alpha;
     glGetIntegerv(GL_BLEND_EQUATION_ALPHA, (GLint*)&last_blend_equation_alpha);
-    arci::opengl_check();
+    opengl_check();
     GLboolean last_enable_blend = glIsEnabled(GL_BLEND);
-    arci::opengl_check();
+    opengl_check();
     GLboolean last_enable_cull_face = glIsEnabled(GL_CULL_FACE);
-    arci::opengl_check();
+    opengl_check();
     GLboolean last_enable_depth_test = glIsEnabled(GL_DEPTH_TEST);
-    arci::opengl_check();
+    opengl_check();
     GLboolean last_enable_scissor_test = glIsEnabled(GL_SCISSOR_TEST);
-    arci::opengl_check();
+    opengl_check();
     // Setup render state: alpha-blending enabled, no face culling, no depth
     // testing, scissor enabled, polygon fill
     glEnable(GL_BLEND);
-    arci::opengl_check();
+    opengl_check();
     glBlendEquation(GL_FUNC_ADD);
-    arci::opengl_check();
+    opengl_check();
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    arci::opengl_check();
+    opengl_check();
     glDisable(GL_CULL_FACE);
-    arci::opengl_check();
+    opengl_check();
     glDisable(GL_DEPTH_TEST);
-    arci::opengl_check();
+    opengl_check();
     glEnable(GL_SCISSOR_TEST);
-    arci::opengl_check();
+    opengl_check();
     // no in opengl es 2.0
     // glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    arci::opengl_check();
+    opengl_check();
 
     // Setup viewport, orthographic projection matrix
     glViewport(0, 0, (GLsizei)fb_width, (GLsizei)fb_height);
     const float ortho_projection[4][4] = {
-        { 2.0f / io.DisplaySize.x, 0.0f, 0.0f, 0.0f },
-        { 0.0f, 2.0f / -io.DisplaySize.y, 0.0f, 0.0f },
+        { 2.0f / display_size.x, 0.0f, 0.0f, 0.0f },
+        { 0.0f, 2.0f / -display_size.y, 0.0f, 0.0f },
         { 0.0f, 0.0f, -1.0f, 0.0f },
         { -1.0f, 1.0f, 0.0f, 1.0f },
     };
@@ -158,60 +163,63 @@ void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data)
     glUniformMatrix4fv(
         g_AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
 
-    arci::opengl_check();
+    opengl_check();
 
+    // Vertices and indices of all draw lists are streamed through the
+    // engine ring buffers, so attribute pointers are set up at offset 0
+    // and every draw list is selected with the base vertex.
     glBindVertexArray(g_VaoHandle);
-    arci::opengl_check();
+    opengl_check();
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_stream.get_buffer_id());
+    opengl_check();
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_stream.get_buffer_id());
+    opengl_check();
+
+    glEnableVertexAttribArray(g_AttribLocationPosition);
+    opengl_check();
+    glEnableVertexAttribArray(g_AttribLocationUV);
+    opengl_check();
+    glEnableVertexAttribArray(g_AttribLocationColor);
+    opengl_check();
+
+    glVertexAttribPointer(g_AttribLocationPosition,
+                          2,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(ImDrawVert),
+                          (GLvoid*)IM_OFFSETOF(ImDrawVert, pos));
+    opengl_check();
+    glVertexAttribPointer(g_AttribLocationUV,
+                          2,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(ImDrawVert),
+                          (GLvoid*)IM_OFFSETOF(ImDrawVert, uv));
+    opengl_check();
+    glVertexAttribPointer(g_AttribLocationColor,
+                          4,
+                          GL_UNSIGNED_BYTE,
+                          GL_TRUE,
+                          sizeof(ImDrawVert),
+                          (GLvoid*)IM_OFFSETOF(ImDrawVert, col));
+    opengl_check();
 
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
         const ImDrawList* cmd_list = draw_data->CmdLists[n];
-        const ImDrawIdx* idx_buffer_offset = 0;
-
-        glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
-        arci::opengl_check();
-        glBufferData(GL_ARRAY_BUFFER,
-                     (GLsizeiptr)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert),
-                     (const GLvoid*)cmd_list->VtxBuffer.Data,
-                     GL_STREAM_DRAW);
-        arci::opengl_check();
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_ElementsHandle);
-        arci::opengl_check();
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                     (GLsizeiptr)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx),
-                     (const GLvoid*)cmd_list->IdxBuffer.Data,
-                     GL_STREAM_DRAW);
-        arci::opengl_check();
-
-        glEnableVertexAttribArray(g_AttribLocationPosition);
-        arci::opengl_check();
-        glEnableVertexAttribArray(g_AttribLocationUV);
-        arci::opengl_check();
-        glEnableVertexAttribArray(g_AttribLocationColor);
-        arci::opengl_check();
-
-        glVertexAttribPointer(g_AttribLocationPosition,
-                              2,
-                              GL_FLOAT,
-                              GL_FALSE,
-                              sizeof(ImDrawVert),
-                              (GLvoid*)IM_OFFSETOF(ImDrawVert, pos));
-        arci::opengl_check();
-        glVertexAttribPointer(g_AttribLocationUV,
-                              2,
-                              GL_FLOAT,
-                              GL_FALSE,
-                              sizeof(ImDrawVert),
-                              (GLvoid*)IM_OFFSETOF(ImDrawVert, uv));
-        arci::opengl_check();
-        glVertexAttribPointer(g_AttribLocationColor,
-                              4,
-                              GL_UNSIGNED_BYTE,
-                              GL_TRUE,
-                              sizeof(ImDrawVert),
-                              (GLvoid*)IM_OFFSETOF(ImDrawVert, col));
-        arci::opengl_check();
+
+        const std::size_t vertices_offset = vertex_stream.push(
+            cmd_list->VtxBuffer.Data,
+            (std::size_t)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert),
+            sizeof(ImDrawVert));
+        const std::size_t indices_offset = index_stream.push(
+            cmd_list->IdxBuffer.Data,
+            (std::size_t)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx),
+            sizeof(ImDrawIdx));
+
+        const GLint base_vertex
+            = (GLint)(vertices_offset / sizeof(ImDrawVert));
+        const char* idx_buffer_offset = (const char*)indices_offset;
 
         for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
         {
@@ -223,31 +231,33 @@ void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data)
             else
             {
                 glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->TextureId);
-                arci::opengl_check();
+                opengl_check();
                 glScissor((int)pcmd->ClipRect.x,
                           (int)(fb_height - pcmd->ClipRect.w),
                           (int)(pcmd->ClipRect.z - pcmd->ClipRect.x),
                           (int)(pcmd->ClipRect.w - pcmd->ClipRect.y));
-                arci::opengl_check();
-                glDrawElements(GL_TRIANGLES,
-                               (GLsizei)pcmd->ElemCount,
-                               sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT
-                                                      : GL_UNSIGNED_INT,
-                               idx_buffer_offset);
-                arci::opengl_check();
+                opengl_check();
+                glDrawElementsBaseVertex(GL_TRIANGLES,
+                                         (GLsizei)pcmd->ElemCount,
+                                         sizeof(ImDrawIdx) == 2
+                                             ? GL_UNSIGNED_SHORT
+                                             : GL_UNSIGNED_INT,
+                                         idx_buffer_offset,
+                                         base_vertex);
+                opengl_check();
             }
-            idx_buffer_offset += pcmd->ElemCount;
+            idx_buffer_offset += pcmd->ElemCount * sizeof(ImDrawIdx);
         }
     }
 
     // Restore modified GL state
     glUseProgram(last_program);
-    arci::opengl_check();
+    opengl_check();
     glBindTexture(GL_TEXTURE_2D, last_texture);
-    arci::opengl_check();
+    opengl_check();
     // glBindSampler(0, last_sampler);
     glActiveTexture(last_active_texture);
-    arci::opengl_check();
+    opengl_check();
     // glBindVertexArray(last_vertex_array);
     glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, last_element_array_buffer);
@@ -256,7 +266,7 @@ void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data)
                         last_blend_dst_rgb,
                         last_blend_src_alpha,
                         last_blend_dst_alpha);
-    arci::opengl_check();
+    opengl_check();
     if (last_enable_blend)
         glEnable(GL_BLEND);
     else
@@ -274,20 +284,20 @@ void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data)
     else
         glDisable(GL_SCISSOR_TEST);
 
-    arci::opengl_check();
+    opengl_check();
     // no in opengl es 2.0
     // glPolygonMode(GL_FRONT_AND_BACK, last_polygon_mode[0]);
-    arci::opengl_check();
+    opengl_check();
     glViewport(last_viewport[0],
                last_viewport[1],
                (GLsizei)last_viewport[2],
                (GLsizei)last_viewport[3]);
-    arci::opengl_check();
+    opengl_check();
     glScissor(last_scissor_box[0],
               last_scissor_box[1],
               (GLsizei)last_scissor_box[2],
               (GLsizei)last_scissor_box[3]);
-    arci::opengl_check();
+    opengl_check();
 }
 
 static const char* ImGui_ImplSdlGL3_GetClipboardText(void*)
@@ -361,17 +371,17 @@ void ImGui_ImplSdlGL3_CreateFontsTexture()
     // Upload texture to graphics system
     GLint last_texture;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
-    arci::opengl_check();
+    opengl_check();
     glGenTextures(1, &g_FontTexture);
-    arci::opengl_check();
+    opengl_check();
     glBindTexture(GL_TEXTURE_2D, g_FontTexture);
-    arci::opengl_check();
+    opengl_check();
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    arci::opengl_check();
+    opengl_check();
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    arci::opengl_check();
+    opengl_check();
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    arci::opengl_check();
+    opengl_check();
     glTexImage2D(GL_TEXTURE_2D,
                  0,
                  GL_RGBA,
@@ -381,14 +391,14 @@ void ImGui_ImplSdlGL3_CreateFontsTexture()
                  GL_RGBA,
                  GL_UNSIGNED_BYTE,
                  pixels);
-    arci::opengl_check();
+    opengl_check();
 
     // Store our identifier
     io.Fonts->TexID = (void*)(intptr_t)g_FontTexture;
 
     // Restore state
     glBindTexture(GL_TEXTURE_2D, last_texture);
-    arci::opengl_check();
+    opengl_check();
 }
 
 bool ImGui_ImplSdlGL3_CreateDeviceObjects()
@@ -396,11 +406,11 @@ bool ImGui_ImplSdlGL3_CreateDeviceObjects()
     // Backup GL state
     GLint last_texture, last_array_buffer, last_vertex_array;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
-    arci::opengl_check();
+    opengl_check();
     glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
-    arci::opengl_check();
+    opengl_check();
     glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
-    arci::opengl_check();
+    opengl_check();
 
     const GLchar* vertex_shader =
         //"#version 150\n"
@@ -435,25 +445,25 @@ bool ImGui_ImplSdlGL3_CreateDeviceObjects()
         "}\n";
 
     g_ShaderHandle = glCreateProgram();
-    arci::opengl_check();
+    opengl_check();
     g_VertHandle = glCreateShader(GL_VERTEX_SHADER);
-    arci::opengl_check();
+    opengl_check();
     g_FragHandle = glCreateShader(GL_FRAGMENT_SHADER);
-    arci::opengl_check();
+    opengl_check();
     glShaderSource(g_VertHandle, 1, &vertex_shader, 0);
-    arci::opengl_check();
+    opengl_check();
     glShaderSource(g_FragHandle, 1, &fragment_shader, 0);
-    arci::opengl_check();
+    opengl_check();
     glCompileShader(g_VertHandle);
-    arci::opengl_check();
+    opengl_check();
     glCompileShader(g_FragHandle);
-    arci::opengl_check();
+    opengl_check();
     glAttachShader(g_ShaderHandle, g_VertHandle);
-    arci::opengl_check();
+    opengl_check();
     glAttachShader(g_ShaderHandle, g_FragHandle);
-    arci::opengl_check();
+    opengl_check();
     glLinkProgram(g_ShaderHandle);
-    arci::opengl_check();
+    opengl_check();
 
     g_AttribLocationTex = glGetUniformLocation(g_ShaderHandle, "Texture");
     g_AttribLocationProjMtx = glGetUniformLocation(g_ShaderHandle, "ProjMtx");
@@ -461,56 +471,19 @@ bool ImGui_ImplSdlGL3_CreateDeviceObjects()
     g_AttribLocationUV = glGetAttribLocation(g_ShaderHandle, "UV");
     g_AttribLocationColor = glGetAttribLocation(g_ShaderHandle, "Color");
 
-    arci::opengl_check();
-
-    glGenBuffers(1, &g_VboHandle);
-    arci::opengl_check();
-    glGenBuffers(1, &g_ElementsHandle);
-    arci::opengl_check();
+    opengl_check();
 
+    // Buffers are provided by the engine on every render call.
     glGenVertexArrays(1, &g_VaoHandle);
-    arci::opengl_check();
-    glBindVertexArray(g_VaoHandle);
-    arci::opengl_check();
-    glBindBuffer(GL_ARRAY_BUFFER, g_VboHandle);
-    arci::opengl_check();
-
-    glEnableVertexAttribArray(g_AttribLocationPosition);
-    arci::opengl_check();
-    glEnableVertexAttribArray(g_AttribLocationUV);
-    arci::opengl_check();
-    glEnableVertexAttribArray(g_AttribLocationColor);
-    arci::opengl_check();
-
-    glVertexAttribPointer(g_AttribLocationPosition,
-                          2,
-                          GL_FLOAT,
-                          GL_FALSE,
-                          sizeof(ImDrawVert),
-                          (GLvoid*)IM_OFFSETOF(ImDrawVert, pos));
-    arci::opengl_check();
-    glVertexAttribPointer(g_AttribLocationUV,
-                          2,
-                          GL_FLOAT,
-                          GL_FALSE,
-                          sizeof(ImDrawVert),
-                          (GLvoid*)IM_OFFSETOF(ImDrawVert, uv));
-    arci::opengl_check();
-    glVertexAttribPointer(g_AttribLocationColor,
-                          4,
-                          GL_UNSIGNED_BYTE,
-                          GL_TRUE,
-                          sizeof(ImDrawVert),
-                          (GLvoid*)IM_OFFSETOF(ImDrawVert, col));
-    arci::opengl_check();
+    opengl_check();
 
     ImGui_ImplSdlGL3_CreateFontsTexture();
 
     // Restore modified GL state
     glBindTexture(GL_TEXTURE_2D, last_texture);
-    arci::opengl_check();
+    opengl_check();
     glBindBuffer(GL_ARRAY_BUFFER, last_array_buffer);
-    arci::opengl_check();
+    opengl_check();
     // glBindVertexArray(last_vertex_array);
 
     return true;
@@ -522,11 +495,7 @@ void ImGui_ImplSdlGL3_InvalidateDeviceObjects()
     {
         //   glDeleteVertexArrays(1, &g_VaoHandle);
     }
-    if (g_VboHandle)
-        glDeleteBuffers(1, &g_VboHandle);
-    if (g_ElementsHandle)
-        glDeleteBuffers(1, &g_ElementsHandle);
-    g_VaoHandle = g_VboHandle = g_ElementsHandle = 0;
+    g_VaoHandle = 0;
 
     if (g_ShaderHandle && g_VertHandle)
         glDetachShader(g_ShaderHandle, g_VertHandle);
@@ -18,6 +18,11 @@
 
 #include "imgui.h"
 
+namespace arci
+{
+    class opengl_stream_buffer;
+}
+
 struct SDL_Window;
 typedef union SDL_Event SDL_Event;
 
@@ -25,7 +30,10 @@ bool ImGui_ImplSdlGL3_Init(SDL_Window* window);
 void ImGui_ImplSdlGL3_Shutdown();
 void ImGui_ImplSdlGL3_NewFrame(SDL_Window* window);
 bool ImGui_ImplSdlGL3_ProcessEvent(SDL_Event* event);
-void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data);
+// Vertices and indices are streamed through the engine ring buffers.
+void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data,
+                                      arci::opengl_stream_buffer& vertex_stream,
+                                      arci::opengl_stream_buffer& index_stream);
 
 // Use if you want to reset your rendering device without losing ImGui state.
 void ImGui_ImplSdlGL3_InvalidateDeviceObjects();
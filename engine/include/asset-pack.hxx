@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Read-only bytes of an asset, owned by whoever gave them out.
+    struct asset_span
+    {
+        const std::uint8_t* data { nullptr };
+        std::size_t size {};
+
+        bool empty() const noexcept
+        {
+            return data == nullptr;
+        }
+    };
+
+    // Layout of a pack file (built by engine/tools/arci-pack.cxx), all
+    // fields are little-endian:
+    //   header
+    //   entry data, every entry starts at a multiple of asset_pack_alignment
+    //   index: entries_number of asset_pack_entry
+    //   names of the entries, not null-terminated
+    struct asset_pack_header
+    {
+        char magic[4] { 'A', 'R', 'P', 'K' };
+        std::uint32_t version {};
+        std::uint32_t entries_number {};
+        std::uint32_t reserved {};
+        std::uint64_t index_offset {};
+    };
+
+    struct asset_pack_entry
+    {
+        std::uint64_t offset {};
+        std::uint64_t size {};
+        std::uint32_t name_offset {};
+        std::uint32_t name_size {};
+    };
+
+    static_assert(sizeof(asset_pack_header) == 24);
+    static_assert(sizeof(asset_pack_entry) == 24);
+
+    inline constexpr std::uint32_t asset_pack_version { 1 };
+    // Enough for any SIMD load or GL upload of the entry data.
+    inline constexpr std::size_t asset_pack_alignment { 64 };
+
+    // Pack file mapped into memory. Entries are found by the path the
+    // file had in the build directory (e.g. "res/ball.png") and given out
+    // as spans into the mapping, so nothing is copied or read until the
+    // data is touched.
+    class asset_pack final
+    {
+    public:
+        asset_pack() = default;
+        ~asset_pack();
+        asset_pack(const asset_pack&) = delete;
+        asset_pack(asset_pack&&) = delete;
+        asset_pack& operator=(const asset_pack&) = delete;
+        asset_pack& operator=(asset_pack&&) = delete;
+
+        // Returns false if the file is missing or is not a valid pack.
+        bool open(const std::string& path);
+        // Spans given out before become dangling.
+        void close();
+
+        bool is_open() const noexcept;
+
+        // Returns an empty span if there is no such entry.
+        asset_span find(const std::string_view name) const;
+
+        std::size_t get_entries_number() const noexcept;
+
+    private:
+        bool map_file(const std::string& path);
+        void unmap_file();
+        bool read_index();
+
+        const std::uint8_t* m_data { nullptr };
+        std::size_t m_size {};
+#ifdef _WIN32
+        void* m_file { nullptr };
+        void* m_mapping { nullptr };
+#endif
+
+        // Names point into the mapping.
+        std::unordered_map<std::string_view, asset_span> m_entries {};
+    };
+
+    // Pack the engine loads assets from. It is mounted on engine init
+    // before any resource is loaded and unmounted on uninit, in between
+    // loaders on any thread may look entries up. Assets missing in the
+    // pack (or every asset, if there is no pack) are read from files.
+    bool mount_asset_pack(const std::string& path);
+    void unmount_asset_pack();
+    asset_span find_packed_asset(const std::string_view name);
+
+    // Assets embedded into the binary first (see embedded-assets.hxx),
+    // then the mounted pack. Returns an empty span if the asset should be
+    // read from its file.
+    asset_span find_asset(const std::string_view name);
+
+    // "arcanoid.pack" in the working directory, as loose assets, or
+    // ARCI_ASSET_PACK environment variable. Empty string (no pack) if
+    // ARCI_ASSET_PACK is set to "off".
+    std::string get_default_asset_pack_path();
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "engine.hxx"
+#include "spsc-queue.hxx"
+
+#include <SDL3/SDL.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    class audio_stream;
+
+    // Samples already converted to the format and rate of the audio
+    // device, mono or stereo. Streamed sounds have no samples in memory,
+    // voices read them from the stream.
+    struct audio_samples
+    {
+        const std::uint8_t* data { nullptr };
+        std::size_t frames {};
+        std::uint8_t channels { 1 };
+        audio_stream* stream { nullptr };
+    };
+
+    // Mixes sounds in the audio callback. The game thread never touches
+    // mixer state directly: it sends commands through a wait-free queue,
+    // which the callback applies before mixing, so neither thread ever
+    // waits for the other. The only exception is `release`, called when
+    // a sound is destroyed, which locks the audio device.
+    //
+    // Every play takes one of a fixed number of voices, so the same sound
+    // may play several times at once. When all voices are busy, one is
+    // stolen according to the voice stealing policy. Voices are mixed in
+    // float with their gain and pan and written as stereo frames of the
+    // device format (S16 or F32). A stream plays on one voice only, so a
+    // new play of a stream stops its voice.
+    class audio_mixer final
+    {
+    public:
+        static constexpr std::size_t voices_max { 32 };
+
+        // `frames_max` - frames mixed at once, larger device buffers are
+        // mixed in several steps.
+        audio_mixer(const SDL_AudioFormat format, const std::size_t frames_max);
+        audio_mixer(const audio_mixer&) = delete;
+        audio_mixer(audio_mixer&&) = delete;
+        audio_mixer& operator=(const audio_mixer&) = delete;
+        audio_mixer& operator=(audio_mixer&&) = delete;
+
+        // Game thread. Commands are dropped if the callback is so far
+        // behind that the queue is full. `sound_gain` is the gain of the
+        // samples for all their voices.
+        voice_id play(const audio_samples* samples,
+                      const bool looped,
+                      const float sound_gain,
+                      const voice_parameters& parameters);
+        void stop(const audio_samples* samples);
+        void stop(const voice_id voice);
+        void set_gain(const audio_samples* samples, const float sound_gain);
+        void set_voice_parameters(const voice_id voice,
+                                  const voice_parameters& parameters);
+        void set_voice_stealing(const voice_stealing policy);
+
+        // Game thread. Returns when the callback doesn't use the samples
+        // anymore, so they may be freed. Queued commands are executed
+        // right away with the device locked, so it doesn't matter if
+        // the device is paused (e.g. Android app in the background).
+        void release(const audio_samples* samples);
+
+        // Game thread. Device whose callback mixes, 0 if there is none.
+        void set_device(const SDL_AudioDeviceID device);
+
+        std::size_t get_dropped_commands_number() const noexcept;
+
+        // Audio callback.
+        void mix(std::uint8_t* stream, const std::size_t length);
+
+    private:
+        enum class command_type : std::uint8_t
+        {
+            play,
+            stop_samples,
+            stop_voice,
+            set_gain,
+            set_voice_parameters,
+            set_voice_stealing
+        };
+
+        struct command
+        {
+            command_type type { command_type::play };
+            bool looped {};
+            voice_stealing stealing { voice_stealing::oldest };
+            voice_id voice {};
+            float sound_gain {};
+            voice_parameters parameters {};
+            const audio_samples* samples { nullptr };
+        };
+
+        struct voice
+        {
+            const audio_samples* samples { nullptr };
+            voice_id id {};
+            bool looped {};
+            float sound_gain {};
+            voice_parameters parameters {};
+            std::size_t position {};
+            // Order of plays, the smallest is the oldest voice.
+            std::uint64_t start {};
+
+            float get_gain() const noexcept;
+        };
+
+        static constexpr std::size_t commands_max { 256 };
+
+        bool push(const command& new_command);
+        void execute_commands();
+        void execute(const command& current);
+
+        void start_voice(const command& current);
+        // Index in m_active_voices, voices_max if there is no such voice.
+        std::size_t find_active_voice(const voice_id id) const;
+        // Index in m_active_voices of the voice the new sound takes,
+        // voices_max if the sound shouldn't be played.
+        std::size_t find_voice_to_steal(const voice_parameters& parameters) const;
+        void remove_active_voice(const std::size_t index);
+
+        // Returns false when the voice has finished.
+        bool mix_voice(voice& current, const std::size_t frames);
+        bool mix_stream_voice(voice& current, const std::size_t frames);
+        // Adds `frames` frames of `input` starting at `first_frame`.
+        void accumulate(const voice& current,
+                        const audio_samples& input,
+                        const std::size_t first_frame,
+                        const std::size_t frames,
+                        float* output) const;
+        template <typename T>
+        void accumulate(const voice& current,
+                        const audio_samples& input,
+                        const std::size_t first_frame,
+                        const std::size_t frames,
+                        float* output) const;
+        void write_output(std::uint8_t* stream, const std::size_t frames) const;
+
+        SDL_AudioFormat m_format {};
+        std::size_t m_frames_max {};
+
+        // Game thread.
+        std::size_t m_dropped_commands {};
+        voice_id m_last_voice_id {};
+        SDL_AudioDeviceID m_device {};
+
+        spsc_queue<command, commands_max> m_commands {};
+
+        // Audio callback only.
+        voice_stealing m_voice_stealing { voice_stealing::oldest };
+        std::uint64_t m_starts_number {};
+        std::array<voice, voices_max> m_voices {};
+        // Indices in m_voices of playing voices and of free ones.
+        std::array<std::uint8_t, voices_max> m_active_voices {};
+        std::size_t m_active_voices_number {};
+        std::array<std::uint8_t, voices_max> m_free_voices {};
+        std::size_t m_free_voices_number {};
+        // Stereo frames.
+        std::vector<float> m_mix_buffer {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
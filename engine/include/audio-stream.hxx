@@ -0,0 +1,148 @@
+#pragma once
+
+#include "audio-mixer.hxx"
+
+#include <SDL3/SDL.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Audio data read in order from the beginning, e.g. of a file. A
+    // source is used by one thread at a time.
+    struct audio_source
+    {
+        virtual ~audio_source() = default;
+
+        // Returns the number of bytes read, whole frames only, 0 at the
+        // end of the data.
+        virtual std::size_t read(std::uint8_t* data, const std::size_t size) = 0;
+        virtual void rewind() = 0;
+        // Bytes of all the data, as `read` gives it out.
+        virtual std::size_t get_size() const = 0;
+
+        SDL_AudioFormat format {};
+        std::uint8_t channels {};
+        int freq {};
+    };
+
+    // PCM (8, 16, 32 bits) or float WAVE file, from the embedded assets,
+    // the asset pack or the file system. Returns nullptr if there is no
+    // such file or the data is in some other encoding.
+    std::unique_ptr<audio_source> open_wav_source(const std::string_view path);
+    // QOA file (see qoa.hxx), decoded frame by frame as it is read.
+    std::unique_ptr<audio_source> open_qoa_source(const std::string_view path);
+
+    // The compressed version of `res/name.wav` is `res/name.qoa` (see
+    // res/CMakeLists.txt), it is preferred when it is there.
+    std::unique_ptr<audio_source> open_audio_source(const std::string_view path);
+
+    // Plays a long sound without keeping it all in memory. A streaming
+    // thread reads the source in chunks, converts them to the device
+    // format and rate and writes them into a ring buffer of a fixed size,
+    // the mixer reads the ring buffer in the audio callback. Neither
+    // thread waits for the other: if the streaming thread is late, the
+    // voice plays silence.
+    //
+    // A stream plays on one voice at a time, every start plays it again
+    // from the beginning.
+    class audio_stream final
+    {
+    public:
+        // About 0.7 s at 48 kHz.
+        static constexpr std::size_t ring_frames { 32768 };
+
+        audio_stream(std::unique_ptr<audio_source> source,
+                     const SDL_AudioFormat format,
+                     const int freq);
+        ~audio_stream();
+        audio_stream(const audio_stream&) = delete;
+        audio_stream(audio_stream&&) = delete;
+        audio_stream& operator=(const audio_stream&) = delete;
+        audio_stream& operator=(audio_stream&&) = delete;
+
+        // Game thread. The next frames read are the first ones again.
+        void start(const bool looped);
+        // Game thread. Joins the streaming thread, the source isn't read
+        // anymore and the stream plays nothing new. Called on engine
+        // uninit before the asset pack the source reads is unmapped.
+        void stop();
+
+        // Audio callback. Up to `frames_max` frames following each other
+        // in the ring buffer, none if the streaming thread is late or the
+        // stream has ended.
+        audio_samples read(const std::size_t frames_max);
+        void consume(const std::size_t frames);
+        // True when all frames of the last start are consumed and the
+        // stream isn't looped.
+        bool has_ended() const;
+
+        // Mono streams stay mono, as other sounds.
+        std::uint8_t get_channels() const noexcept;
+        // Ring buffer and the chunk read from the source.
+        std::size_t get_memory_size() const noexcept;
+
+    private:
+        void run();
+        // Returns false if there is nothing to do until the mixer
+        // consumes frames or the stream is started again.
+        bool produce();
+        // Returns false if the source and the converter are drained.
+        bool feed_converter();
+
+        std::unique_ptr<audio_source> m_source {};
+        SDL_AudioStream* m_converter { nullptr };
+        std::uint8_t m_channels {};
+        std::size_t m_frame_size {};
+
+        // Game thread writes, the others read. Starts are counted from 1,
+        // 0 means the stream has never been started.
+        std::atomic<std::uint32_t> m_requested_start {};
+        std::atomic<bool> m_requested_looped {};
+
+        // Streaming thread only.
+        std::uint32_t m_current_start {};
+        bool m_looped {};
+        bool m_flushed {};
+        bool m_drained {};
+        std::vector<std::uint8_t> m_chunk {};
+
+        // Written by the streaming thread: the start the ring buffer is
+        // filled for, where its frames begin, and the start whose last
+        // frame has been written.
+        std::atomic<std::uint32_t> m_ready_start {};
+        std::atomic<std::size_t> m_ready_head {};
+        std::atomic<std::uint32_t> m_ended_start {};
+
+        // Audio callback only.
+        std::uint32_t m_consumed_start {};
+
+        // Frame indices grow forever, as in spsc_queue.
+        alignas(64) std::atomic<std::size_t> m_head {};
+        alignas(64) std::atomic<std::size_t> m_tail {};
+        std::vector<std::uint8_t> m_ring {};
+
+        bool m_stopping { false };
+        std::mutex m_mutex {};
+        std::condition_variable m_wake {};
+        std::thread m_thread {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
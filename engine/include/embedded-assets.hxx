@@ -0,0 +1,33 @@
+#pragma once
+
+#include "asset-pack.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // File compiled into the binary (see `embed_files` in
+    // cmake/modules/EmbedFiles.cmake), named by the path the engine loads
+    // it by. Data has a trailing zero byte not counted in the size.
+    struct embedded_asset
+    {
+        std::string_view name {};
+        const std::uint8_t* data { nullptr };
+        std::size_t size {};
+    };
+
+    // Returns an empty span if the asset isn't embedded.
+    asset_span find_embedded_asset(const std::string_view name);
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -1,13 +1,16 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <string>
 #include <string_view>
 #include <utility>
 #include <vector>
 
 #include <glm/ext/matrix_float2x2_precision.hpp>
+#include <glm/ext/matrix_float3x3_precision.hpp>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -18,7 +21,26 @@ namespace arci
 
     class iengine;
 
-    iengine* engine_create();
+    enum class engine_backend
+    {
+        // Window, GL ES context and audio device through SDL.
+        sdl,
+        // No window, GPU or audio work, only counts what would be drawn
+        // and played. For benchmarks on machines without a display.
+        null,
+        // Real GL path without a display: SDL offscreen video driver
+        // (EGL pbuffer context, works with Mesa llvmpipe), frames are
+        // rendered into a framebuffer object, audio goes to the dummy
+        // driver.
+        offscreen
+    };
+
+    // Backend chosen by ARCI_ENGINE environment variable
+    // ("sdl", "null" or "offscreen"), SDL if it is not set.
+    engine_backend get_default_engine_backend();
+
+    iengine* engine_create(const engine_backend backend
+                           = get_default_engine_backend());
 
     ///////////////////////////////////////////////////////////////////////////////
 
@@ -62,6 +84,8 @@ namespace arci
         button3_released,
         escape_button_pressed,
         escape_button_released,
+        profiler_button_pressed,
+        profiler_button_released,
     };
 
     enum class keys
@@ -75,7 +99,8 @@ namespace arci
         reduce,
         button1,
         button2,
-        exit
+        exit,
+        profiler
     };
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -103,6 +128,68 @@ namespace arci
         float ty {};
     };
 
+    // Compact vertex for 2D sprites (16 bytes instead of 36 of `vertex`).
+    // Texture coordinates and colour are normalized integers: 65535 (255)
+    // is read by the shader as 1.0.
+    struct sprite_vertex
+    {
+        float x {};
+        float y {};
+        std::uint16_t tx {};
+        std::uint16_t ty {};
+        std::uint8_t r {};
+        std::uint8_t g {};
+        std::uint8_t b {};
+        std::uint8_t a {};
+    };
+
+    static_assert(sizeof(sprite_vertex) == 16,
+                  "sprite_vertex should take exactly 16 bytes");
+
+    sprite_vertex make_sprite_vertex(const float x,
+                                     const float y,
+                                     const float tx,
+                                     const float ty,
+                                     const float r = 1.f,
+                                     const float g = 1.f,
+                                     const float b = 1.f,
+                                     const float a = 1.f);
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    enum class attribute_type
+    {
+        float32,
+        uint16,
+        uint8
+    };
+
+    struct vertex_attribute
+    {
+        std::uint32_t location {};
+        std::uint32_t components {};
+        attribute_type type { attribute_type::float32 };
+        // Integer values are mapped to [0, 1] range.
+        bool normalized { false };
+        std::size_t offset {};
+    };
+
+    // Describes how vertex attributes are laid out in the vertex buffer.
+    // Attribute locations match `location` layout qualifiers in shaders:
+    // 0 - position, 1 - colour, 2 - texture coordinates.
+    struct vertex_layout
+    {
+        std::vector<vertex_attribute> attributes {};
+        std::size_t stride {};
+    };
+
+    // Position of `vertex` has 3 components, `z` is used as a layer
+    // of the texture array.
+    const vertex_layout& get_vertex_layout();
+    const vertex_layout& get_sprite_vertex_layout();
+
+    ///////////////////////////////////////////////////////////////////////////////
+
     struct triangle
     {
         triangle() = default;
@@ -119,6 +206,12 @@ namespace arci
         virtual ~ivertex_buffer() = default;
         virtual void bind() = 0;
         virtual std::size_t get_vertices_number() const = 0;
+
+        // Overwrite a range of vertices in place (glBufferSubData).
+        // Vertices should have the layout the buffer was created with.
+        virtual void update(const std::size_t first_vertex,
+                            const void* vertices,
+                            const std::size_t vertices_number) = 0;
     };
 
     class i_index_buffer
@@ -138,10 +231,56 @@ namespace arci
         virtual ~itexture() = default;
         virtual void load(const std::string_view path) = 0;
         virtual void bind() = 0;
+        // GPU memory of the texture, 0 until it is uploaded.
+        virtual std::size_t get_memory_size() const = 0;
+    };
+
+    // Texture backed by GL_TEXTURE_2D_ARRAY. Every image of a same-sized
+    // sprite family (bricks, blocks, bonuses, ...) becomes a separate layer,
+    // so sprites using different images of the family can be drawn with one
+    // draw call. Layer index is passed through the `z` component of the
+    // vertex position.
+    class itexture_array
+    {
+    public:
+        virtual ~itexture_array() = default;
+        virtual void load(const std::vector<std::string_view>& paths) = 0;
+        virtual void bind() = 0;
+        virtual std::size_t get_layers_number() const = 0;
+        // GPU memory of all layers, 0 until they are uploaded.
+        virtual std::size_t get_memory_size() const = 0;
     };
 
     ///////////////////////////////////////////////////////////////////////////////
 
+    // Sounds are played by a fixed number of voices, every play takes
+    // one. Ids are never reused, 0 is not a valid id.
+    using voice_id = std::uint32_t;
+
+    struct voice_parameters
+    {
+        // From 0 (silence) to 1 (as recorded), multiplied by the gain of
+        // the sound.
+        float gain { 1.f };
+        // From -1 (left only) to 1 (right only).
+        float pan {};
+        // See voice_stealing::priority.
+        std::uint8_t priority {};
+    };
+
+    // Which voice a new sound takes when all voices are playing.
+    enum class voice_stealing
+    {
+        // The one playing for the longest time.
+        oldest,
+        // The one with the lowest gain.
+        quietest,
+        // The oldest one with the lowest priority, unless its priority is
+        // higher than the priority of the new sound, then the new sound
+        // isn't played.
+        priority
+    };
+
     struct iaudio_buffer
     {
         virtual ~iaudio_buffer() = default;
@@ -152,7 +291,162 @@ namespace arci
             for_ever
         };
 
-        virtual void play(const running_mode mode) = 0;
+        // Starts a new voice, voices of the sound already playing go on.
+        // Long sounds (e.g. music) are streamed and play on one voice at
+        // a time, so for them it starts the sound again.
+        virtual voice_id play(const running_mode mode,
+                              const voice_parameters& parameters = {}) = 0;
+        // Stops all voices of the sound.
+        virtual void stop() = 0;
+        // Does nothing if the voice has already finished.
+        virtual void stop(const voice_id voice) = 0;
+        // From 0 (silence) to 1 (as recorded), for all voices of the sound.
+        virtual void set_gain(const float gain) = 0;
+        virtual void set_voice_parameters(
+            const voice_id voice,
+            const voice_parameters& parameters) = 0;
+        // Memory of the decoded samples, or of the stream buffers.
+        virtual std::size_t get_memory_size() const = 0;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // 2D camera. World units are pixels with the origin at the top left
+    // corner and `y` axis pointing down. The camera looks at the center
+    // point, `zoom` > 1 magnifies and `rotation` is in radians.
+    struct camera2d
+    {
+        float center_x {};
+        float center_y {};
+        float zoom { 1.f };
+        float rotation {};
+        float viewport_width {};
+        float viewport_height {};
+    };
+
+    // Matrix which converts world coordinates to NDC.
+    glm::mediump_mat3 get_view_projection(const camera2d& camera);
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // How a material is combined with what is already drawn. Opaque
+    // commands are drawn first front-to-back with blending off and
+    // depth writes on, so the depth test rejects hidden fragments
+    // before shading. Blended ones are drawn back-to-front after them.
+    enum class blend_mode : std::uint8_t
+    {
+        opaque,
+        // Opaque, but fragments with alpha below 0.5 are discarded, for
+        // sprites which are solid except for a thin edge (e.g. bricks).
+        // Such sprites in front of an opaque background hide it from
+        // shading.
+        alpha_test,
+        // src * src_alpha + dst * (1 - src_alpha)
+        alpha,
+        // src * src_alpha + dst
+        additive
+    };
+
+    // Alpha and additive commands are drawn in the blended pass.
+    bool is_translucent(const blend_mode blend);
+
+    // Sprite submitted to the engine render queue. Queued commands are
+    // sorted once per frame by (opacity, layer, program, texture, depth)
+    // and drawn in batches with minimum state changes. Submission order
+    // is kept only for commands with equal keys, so blended sprites of one
+    // layer should not rely on it when they overlap.
+    struct sprite_command
+    {
+        // Top left corner and size in world units.
+        float x {};
+        float y {};
+        float width {};
+        float height {};
+
+        // Texture rectangle, (0, 0) is the bottom left corner of the image.
+        float u0 {};
+        float v0 {};
+        float u1 { 1.f };
+        float v1 { 1.f };
+
+        itexture* texture { nullptr };
+        // Used instead of `texture`, see itexture_array.
+        itexture_array* texture_array { nullptr };
+        std::uint32_t texture_layer {};
+
+        // Higher layers are drawn on top of lower ones.
+        std::uint8_t layer {};
+        // [0, 1] inside the layer, 0 is the nearest to the viewer.
+        float depth {};
+        blend_mode blend { blend_mode::alpha };
+    };
+
+    // Persistent mesh of `vertex` vertices textured by the texture array
+    // (e.g. brick field), submitted to the render queue.
+    struct mesh_command
+    {
+        ivertex_buffer* vertex_buffer { nullptr };
+        i_index_buffer* ebo { nullptr };
+        itexture_array* texture_array { nullptr };
+
+        std::uint8_t layer {};
+        float depth {};
+        blend_mode blend { blend_mode::alpha };
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    struct render_stats
+    {
+        std::size_t draw_calls {};
+        // Every index of an indexed draw call is counted.
+        std::size_t vertices {};
+
+        // Program and texture switches of the render queue if it was drawn
+        // in submission order and in sorted order.
+        std::size_t queue_state_changes_unsorted {};
+        std::size_t queue_state_changes_sorted {};
+
+        // GL state changing calls issued and skipped as redundant
+        // by the engine state cache.
+        std::size_t state_calls_issued {};
+        std::size_t state_calls_avoided {};
+
+        // Memory taken by all alive textures, both engines count it. The
+        // SDL engine counts the data uploaded to GL: RGBA8 for PNG, the
+        // compressed size of all mip levels for KTX. The null engine
+        // counts every texture as RGBA8, as if it was loaded from PNG.
+        std::size_t texture_bytes {};
+        // Counted by the null engine only: sounds started during the
+        // frame.
+        std::size_t sounds_played {};
+
+        // CPU time the render thread spent issuing GL calls of the frame,
+        // without waiting for the buffer swap. Not measured by the null
+        // engine.
+        float submit_time_ms {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Rolling statistics of a named render pass over the last frames.
+    struct gpu_pass_timing
+    {
+        std::string name {};
+        float average_ms {};
+        float median_ms {};
+        float p95_ms {};
+        float max_ms {};
+    };
+
+    struct gpu_timings
+    {
+        // False if GPU timer queries are not supported and passes are
+        // timed on CPU (time to issue their GL calls).
+        bool is_gpu_timer {};
+        // Frames whose results were not ready in time or were disjoint.
+        std::size_t dropped_frames {};
+        std::vector<gpu_pass_timing> passes {};
     };
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -167,6 +461,11 @@ namespace arci
         virtual void imgui_new_frame() = 0;
         virtual void imgui_render() = 0;
 
+        // All vertex positions are in world units and are transformed by
+        // the camera on GPU. By default the camera shows the whole screen.
+        virtual void set_camera(const camera2d& camera) = 0;
+        virtual camera2d get_camera() const noexcept = 0;
+
         /* clang-format off */
         virtual void render(ivertex_buffer* vertex_buffer,
                             i_index_buffer* ebo,    
@@ -175,11 +474,35 @@ namespace arci
         virtual void render(ivertex_buffer* vertex_buffer,
                     i_index_buffer* ebo,
                     itexture* const texture) = 0;
+        virtual void render(ivertex_buffer* vertex_buffer,
+                    i_index_buffer* ebo,
+                    itexture_array* const texture_array) = 0;
+
+        // Geometry which lives only for the current frame. It is streamed
+        // through the engine ring buffer, no buffer objects are created.
+        virtual void render(const std::vector<sprite_vertex>& vertices,
+                            const std::vector<uint32_t>& indices,
+                            itexture* const texture) = 0;
+        virtual void render(const std::vector<vertex>& vertices,
+                            const std::vector<uint32_t>& indices,
+                            itexture_array* const texture_array) = 0;
+
+        // Queued commands are drawn by execute_render_queue() (at the
+        // latest by swap_buffers()), after that the queue is empty.
+        virtual void submit(const sprite_command& command) = 0;
+        virtual void submit(const mesh_command& command) = 0;
+        virtual void execute_render_queue() = 0;
 
         virtual ivertex_buffer* create_vertex_buffer(
             const std::vector<triangle>& triangles) = 0;
         virtual ivertex_buffer* create_vertex_buffer(
             const std::vector<vertex>& vertices) = 0;
+        virtual ivertex_buffer* create_vertex_buffer(
+            const std::vector<sprite_vertex>& vertices) = 0;
+        virtual ivertex_buffer* create_vertex_buffer(
+            const void* vertices,
+            const std::size_t vertices_number,
+            const vertex_layout& layout) = 0;
         virtual void destroy_vertex_buffer(
             ivertex_buffer* buffer) = 0;
 
@@ -191,15 +514,33 @@ namespace arci
             const std::string_view path) = 0;
         virtual void destroy_texture(const itexture* const texture) = 0;
 
+        virtual itexture_array* create_texture_array(
+            const std::vector<std::string_view>& paths) = 0;
+        virtual void destroy_texture_array(
+            const itexture_array* const texture_array) = 0;
+
         virtual iaudio_buffer* create_audio_buffer(
             const std::string_view audio_file_name) = 0;
         virtual void destroy_audio_buffer(iaudio_buffer* buffer) = 0;
         /* clang-format on */
 
+        // voice_stealing::oldest by default.
+        virtual void set_voice_stealing(const voice_stealing policy) = 0;
+
         virtual void uninit() = 0;
         virtual void imgui_uninit() = 0;
         virtual void swap_buffers() = 0;
         virtual std::pair<size_t, size_t> get_screen_resolution() const noexcept = 0;
+
+        // Statistics of the last finished frame.
+        virtual render_stats get_render_stats() const noexcept = 0;
+
+        // Queued commands are timed per layer, the layer name (e.g.
+        // "bricks") becomes the name of its render pass. ImGui is timed
+        // as "imgui" pass.
+        virtual void set_layer_name(const std::uint8_t layer,
+                                    const std::string_view name) = 0;
+        virtual gpu_timings get_gpu_timings() const = 0;
     };
 
     ///////////////////////////////////////////////////////////////////////////////
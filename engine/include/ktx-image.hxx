@@ -0,0 +1,76 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // GPU texture formats of KTX files the engine knows about.
+    enum class ktx_format_family
+    {
+        uncompressed,
+        etc2,
+        astc
+    };
+
+    // One mip level, for all layers of an array.
+    struct ktx_level
+    {
+        std::uint32_t width {};
+        std::uint32_t height {};
+        std::size_t offset {};
+        std::size_t size {};
+    };
+
+    // 2D image or 2D array with its mip chain from a KTX 1.1 or KTX2 file.
+    // Cube maps, 3D images and supercompressed KTX2 files are not supported.
+    // Images are expected to be stored bottom row first (as GL samples
+    // them), the converter flips them.
+    struct ktx_image
+    {
+        ktx_format_family family { ktx_format_family::uncompressed };
+        GLenum internal_format {};
+        // Zero for compressed formats.
+        GLenum format {};
+        GLenum type {};
+        std::uint32_t width {};
+        std::uint32_t height {};
+        std::uint32_t layers { 1 };
+        std::vector<ktx_level> levels {};
+        // Whole file, levels point into it. It is either owned by the
+        // image (`storage`) or by someone else, e.g. a mapped asset pack.
+        const std::uint8_t* content { nullptr };
+        std::size_t content_size {};
+        std::vector<std::uint8_t> storage {};
+
+        bool is_compressed() const noexcept
+        {
+            return format == 0;
+        }
+
+        const std::uint8_t* get_level_data(const std::size_t level) const
+        {
+            return content + levels[level].offset;
+        }
+    };
+
+    // Returns false if the content isn't a supported KTX file.
+    bool parse_ktx(std::vector<std::uint8_t> content, ktx_image& image);
+    // The content isn't copied, it should outlive the image.
+    bool parse_ktx(const std::uint8_t* content,
+                   const std::size_t size,
+                   ktx_image& image);
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
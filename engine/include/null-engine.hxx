@@ -0,0 +1,22 @@
+#pragma once
+
+#include "engine.hxx"
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Engine which accepts every call without touching GPU, window or
+    // audio device. Render queue is still sorted and batched the same way
+    // as by the SDL engine, so draw call and vertex counters match what
+    // would be sent to GL. Used to benchmark game logic headless.
+    iengine* create_null_engine();
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -1,20 +1,22 @@
 #pragma once
 
-#include <helper.hxx>
-
 #include <glad/glad.h>
 
-#ifndef __ANDROID__
-/* clang-format off */
-#include <fmt/core.h>
-/* clang-format on */
+#include <cstddef>
+#include <string_view>
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Highest GL diagnostics tier compiled in (see gl_diagnostics_tier):
+// 0 - off, 1 - debug callback, 2 - per-frame check, 3 - per-call check.
+// With 0 all checks compile to nothing.
+#ifndef ARCI_GL_DIAGNOSTICS
+#ifdef RELEASE
+#define ARCI_GL_DIAGNOSTICS 0
 #else
-/* clang-format off */
-#include <android/log.h>
-/* clang-format on */
+#define ARCI_GL_DIAGNOSTICS 3
+#endif
 #endif
-
-#include <string>
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -23,266 +25,80 @@ namespace arci
 
     ///////////////////////////////////////////////////////////////////////////////
 
-    static std::string source_msg_enum_to_string(const GLenum source_msg);
-
-    static std::string type_msg_enum_to_string(const GLenum type_msg);
-
-    static std::string severity_msg_enum_to_string(const GLenum severity_msg);
-
-    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glDebugMessageCallback.xhtml
-    [[maybe_unused]] static void APIENTRY opengl_message_callback(
-        GLenum source,
-        GLenum type,
-        GLuint id,
-        GLenum severity,
-        GLsizei length,
-        const GLchar* message,
-        [[maybe_unused]] const void* userParam)
-    {
-        if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
-        {
-            return;
-        }
-
-        CHECK(length < GL_MAX_DEBUG_MESSAGE_LENGTH);
-
-#ifndef __ANDROID__
-        fmt::print("Message id: {}\n", id);
-        fmt::print(source_msg_enum_to_string(source));
-        fmt::print(type_msg_enum_to_string(type));
-        fmt::print(severity_msg_enum_to_string(severity));
-        fmt::print(message);
-#else
-        const std::string src = source_msg_enum_to_string(source);
-        const std::string type_msg = type_msg_enum_to_string(type);
-        const std::string severity_msg = severity_msg_enum_to_string(severity);
-
-        __android_log_print(ANDROID_LOG_ERROR, "ARCI", "Message id: %u\n"
-                                                       "%s\n%s\n%s\n%s\n",
-                            id,
-                            src.c_str(),
-                            type_msg.c_str(),
-                            severity_msg.c_str(),
-                            message);
-#endif
-    }
-
-    static std::string source_msg_enum_to_string(const GLenum source_msg)
+    enum class gl_diagnostics_tier
     {
-        std::string result { "Message source: " };
-
-        switch (source_msg)
-        {
-        case GL_DEBUG_SOURCE_API:
-            result += "calls to the OpenGL API\n";
-            break;
-        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
-            result += "calls to a window-system API\n";
-            break;
-        case GL_DEBUG_SOURCE_SHADER_COMPILER:
-            result += "a compiler for a shading language\n";
-            break;
-        case GL_DEBUG_SOURCE_THIRD_PARTY:
-            result += "a third party application associated with OpenGL\n";
-            break;
-        case GL_DEBUG_SOURCE_APPLICATION:
-            result += "a source application associated with OpenGL\n";
-            break;
-        case GL_DEBUG_SOURCE_OTHER:
-            result += "some other source\n";
-            break;
-        default:
-            result += "unknown source\n";
-            break;
-        }
-
-        return result;
-    }
-
-    static std::string type_msg_enum_to_string(const GLenum type_msg)
+        off,
+        // GL_KHR_debug messages only, reported asynchronously.
+        debug_callback,
+        // Plus glGetError() once per frame.
+        per_frame,
+        // Plus glGetError() after every checked call and synchronous
+        // debug messages, so they point at the call.
+        per_call
+    };
+
+    // Tier in effect. Picked by init_gl_diagnostics(), only read by
+    // the thread which owns the GL context.
+    inline gl_diagnostics_tier current_gl_diagnostics_tier {
+        static_cast<gl_diagnostics_tier>(ARCI_GL_DIAGNOSTICS)
+    };
+
+    // Reads ARCI_GL_DIAGNOSTICS environment variable ("off", "callback",
+    // "frame" or "call"), the tier is limited by the one compiled in.
+    // Sets up the debug callback, so GL should be loaded already.
+    void init_gl_diagnostics();
+
+    // Place of a check in the source, counts errors found there.
+    struct gl_call_site
     {
-        std::string result { "Message type: " };
+        gl_call_site(const char* file, const int line);
 
-        switch (type_msg)
-        {
-        case GL_DEBUG_TYPE_ERROR:
-            result += "an error, typically from the API\n";
-            break;
-        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
-            result += "some behavior marked deprecated has been used\n";
-            break;
-        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
-            result += "something has invoked undefined behavior\n";
-            break;
-        case GL_DEBUG_TYPE_PORTABILITY:
-            result
-                += "some functionality the user relies upon is not portable\n";
-            break;
-        case GL_DEBUG_TYPE_PERFORMANCE:
-            result += "code has triggered possible performance issues\n";
-            break;
-        case GL_DEBUG_TYPE_MARKER:
-            result += "command stream annotation\n";
-            break;
-        case GL_DEBUG_TYPE_PUSH_GROUP:
-            result += "group pushing\n";
-            break;
-        case GL_DEBUG_TYPE_POP_GROUP:
-            result += "group popping\n";
-            break;
-        case GL_DEBUG_TYPE_OTHER:
-            result += "some other type\n";
-            break;
-        default:
-            result += "unknown type\n";
-            break;
-        }
+        const char* file { nullptr };
+        int line {};
+        std::size_t errors {};
+        gl_call_site* next { nullptr };
+    };
 
-        return result;
-    }
+    // Drains glGetError(), every error is counted for the site and the
+    // first one of the site is printed.
+    void check_gl_errors(gl_call_site& site);
 
-    static std::string severity_msg_enum_to_string(const GLenum severity_msg)
-    {
-        std::string result { "Message severity: " };
+    // Sites which have got errors so far.
+    void print_gl_error_report();
 
-        switch (severity_msg)
-        {
-        case GL_DEBUG_SEVERITY_HIGH:
-            result += "HIGH. All OpenGL Errors, shader compilation/linking"
-                      " errors, or highly-dangerous undefined behavior\n";
-            break;
-        case GL_DEBUG_SEVERITY_MEDIUM:
-            result += "MEDIUM. Major performance warnings, "
-                      "shader compilation/linking warnings, "
-                      "or the use of deprecated functionality\n";
-            break;
-        case GL_DEBUG_SEVERITY_LOW:
-            result += "LOW. Redundant state change performance warning, "
-                      "or unimportant undefined behavior\n";
-            break;
-        case GL_DEBUG_SEVERITY_NOTIFICATION:
-            result += "NOTIFICATION. Anything that isn't an error or"
-                      " performance issue\n";
-            break;
-        default:
-            result += "UNKNOWN\n";
-            break;
-        }
+    // Whether the current context exposes the extension.
+    bool has_gl_extension(const std::string_view name);
 
-        return result;
-    }
-
-    inline static void opengl_check()
-    {
-        const GLenum error = glGetError();
+    ///////////////////////////////////////////////////////////////////////////////
 
-        if (error == GL_NO_ERROR)
-        {
-            return;
-        }
+} // namespace arci
 
-        switch (error)
-        {
-        case GL_INVALID_ENUM:
-#ifndef __ANDROID__
-            fmt::print("An unacceptable value is specified"
-                       " for an enumerated argument\n");
-#else
-            __android_log_print(ANDROID_LOG_ERROR,
-                                "ARCI",
-                                "An unacceptable value is specified"
-                                " for an enumerated argument\n");
-#endif
-            break;
-        case GL_INVALID_VALUE:
-#ifndef __ANDROID__
-            fmt::print("A numeric argument is out of range\n");
-#else
-            __android_log_print(ANDROID_LOG_ERROR,
-                                "ARCI",
-                                "A numeric argument is out of range\n");
+///////////////////////////////////////////////////////////////////////////////
 
-#endif
-            break;
-        case GL_INVALID_OPERATION:
-#ifndef __ANDROID__
-            fmt::print("The specified operation is not"
-                       " allowed in the current state\n");
-#else
-            __android_log_print(ANDROID_LOG_ERROR,
-                                "ARCI",
-                                "The specified operation is not"
-                                " allowed in the current state\n");
-#endif
-            break;
-        case GL_INVALID_FRAMEBUFFER_OPERATION:
-#ifndef __ANDROID__
-            fmt::print("The framebuffer object is not complete\n");
-#else
-            __android_log_print(ANDROID_LOG_ERROR,
-                                "ARCI",
-                                "The framebuffer object is not complete\n");
-#endif
-            break;
-        case GL_OUT_OF_MEMORY:
-#ifndef __ANDROID__
-            fmt::print("There is not enough memory left to execute"
-                       " the command\n");
+#define ARCI_GL_CHECK_SITE(tier)                                         \
+    do                                                                   \
+    {                                                                    \
+        if (::arci::current_gl_diagnostics_tier >= (tier))               \
+        {                                                                \
+            static ::arci::gl_call_site arci_site { __FILE__, __LINE__ }; \
+            ::arci::check_gl_errors(arci_site);                          \
+        }                                                                \
+    } while (false)
+
+// Checks errors of the preceding GL call in per-call tier.
+#if ARCI_GL_DIAGNOSTICS >= 3
+#define opengl_check() \
+    ARCI_GL_CHECK_SITE(::arci::gl_diagnostics_tier::per_call)
 #else
-            __android_log_print(ANDROID_LOG_ERROR,
-                                "ARCI",
-                                "There is not enough memory left to execute"
-                                " the command\n");
+#define opengl_check() static_cast<void>(0)
 #endif
-            break;
-        case GL_STACK_UNDERFLOW:
-#ifndef __ANDROID__
-            fmt::print("An attempt has been made to perform"
-                       " an operation that would cause an internal"
-                       " stack to underflow\n");
-#else
-            __android_log_print(ANDROID_LOG_ERROR,
-                                "ARCI",
-                                "An attempt has been made to perform"
-                                " an operation that would cause an internal"
-                                " stack to underflow\n");
-#endif
-            break;
-        case GL_STACK_OVERFLOW:
-#ifndef __ANDROID__
-            fmt::print("An attempt has been made to perform"
-                       " an operation that would cause an internal"
-                       " stack to overflow\n");
-#else
-            __android_log_print(ANDROID_LOG_ERROR,
-                                "ARCI",
-                                "An attempt has been made to perform"
-                                " an operation that would cause an internal"
-                                " stack to overflow\n");
-#endif
-            break;
-        default:
-#ifndef __ANDROID__
-            fmt::print("Undefined opengl error type\n");
-#else
-            __android_log_print(ANDROID_LOG_ERROR,
-                                "ARCI",
-                                "Undefined opengl error type\n");
-#endif
-            break;
-        }
 
-#ifndef __ANDROID__
-        std::exit(1);
+// Checks errors of the whole frame in per-frame tier and above.
+#if ARCI_GL_DIAGNOSTICS >= 2
+#define opengl_check_frame() \
+    ARCI_GL_CHECK_SITE(::arci::gl_diagnostics_tier::per_frame)
 #else
-        // On Android we cannot call std::exit since it will cause
-        // incorrect app finish.
-        throw std::runtime_error { "Opengl issue" };
+#define opengl_check_frame() static_cast<void>(0)
 #endif
-    }
-
-    ///////////////////////////////////////////////////////////////////////////////
-
-} // namespace arci
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "engine.hxx"
+
+#include "glad/glad.h"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Times named render passes of every frame. With
+    // GL_EXT_disjoint_timer_query every pass gets a GL_TIME_ELAPSED_EXT
+    // query, otherwise CPU time spent issuing the pass is measured.
+    // Query results are read `frames_latency` frames later and only if
+    // they are already available, so the profiler never waits for GPU
+    // (frames whose results are late are just dropped).
+    // Passes should not overlap. Everything except get_timings() is
+    // called on the thread owning the GL context.
+    class opengl_gpu_profiler final
+    {
+    public:
+        static constexpr std::size_t frames_latency { 4 };
+        // Number of frames the statistics are computed over.
+        static constexpr std::size_t history_size { 120 };
+
+        explicit opengl_gpu_profiler(GLADloadproc load);
+        ~opengl_gpu_profiler();
+        opengl_gpu_profiler(const opengl_gpu_profiler&) = delete;
+        opengl_gpu_profiler(opengl_gpu_profiler&&) = delete;
+        opengl_gpu_profiler& operator=(const opengl_gpu_profiler&) = delete;
+        opengl_gpu_profiler& operator=(opengl_gpu_profiler&&) = delete;
+
+        void begin_frame();
+        void end_frame();
+
+        // Passes with the same name in one frame are summed up.
+        void begin_pass(const std::string_view name);
+        void end_pass();
+
+        bool is_pass_open() const noexcept;
+
+        gpu_timings get_timings() const;
+
+    private:
+        struct pass
+        {
+            std::string name {};
+            GLuint query {};
+            std::chrono::steady_clock::time_point cpu_begin {};
+            float cpu_ms {};
+        };
+
+        struct pass_history
+        {
+            std::string name {};
+            // Last `history_size` values in milliseconds.
+            std::deque<float> samples {};
+        };
+
+        struct frame
+        {
+            std::vector<pass> passes {};
+            // Queries are reused by the next frames taking the slot.
+            std::vector<GLuint> queries {};
+            bool is_recorded { false };
+        };
+
+        void collect(frame& slot);
+        void add_sample(const std::string& name, const float ms);
+
+        bool m_gpu_timer { false };
+
+        using gen_queries_func = void(APIENTRYP)(GLsizei, GLuint*);
+        using delete_queries_func = void(APIENTRYP)(GLsizei, const GLuint*);
+        using begin_query_func = void(APIENTRYP)(GLenum, GLuint);
+        using end_query_func = void(APIENTRYP)(GLenum);
+        using get_query_uiv_func = void(APIENTRYP)(GLuint, GLenum, GLuint*);
+
+        gen_queries_func m_gen_queries { nullptr };
+        delete_queries_func m_delete_queries { nullptr };
+        begin_query_func m_begin_query { nullptr };
+        end_query_func m_end_query { nullptr };
+        get_query_uiv_func m_get_query_uiv { nullptr };
+
+        std::array<frame, frames_latency> m_frames {};
+        std::size_t m_frame_index {};
+        bool m_pass_open { false };
+
+        mutable std::mutex m_history_mutex {};
+        // In order of the first appearance of the passes.
+        std::vector<pass_history> m_history {};
+        std::size_t m_dropped_frames {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // On-disk cache of linked program binaries (glGetProgramBinary).
+    // A binary is keyed by the hash of all shader sources of the program
+    // and the driver identity (vendor, renderer, version), so a driver
+    // update or an edited shader simply misses the cache. Binaries rejected
+    // by glProgramBinary are removed and the program is compiled again.
+    class opengl_program_cache final
+    {
+    public:
+        struct program_binary
+        {
+            GLenum format {};
+            std::vector<std::uint8_t> data {};
+        };
+
+        struct statistics
+        {
+            std::size_t hits {};
+            std::size_t misses {};
+            std::size_t rejected {};
+        };
+
+        // Should be created with the current GL context. The cache is
+        // disabled if the driver has no binary formats or the directory
+        // can't be created.
+        explicit opengl_program_cache(std::string directory);
+        opengl_program_cache(const opengl_program_cache&) = delete;
+        opengl_program_cache(opengl_program_cache&&) = delete;
+        opengl_program_cache& operator=(const opengl_program_cache&) = delete;
+        opengl_program_cache& operator=(opengl_program_cache&&) = delete;
+
+        bool is_enabled() const noexcept;
+
+        // Key of the program built from the given (already combined)
+        // shader sources.
+        std::uint64_t get_key(const std::string_view sources) const;
+
+        // Returns false if there is no valid binary for the key.
+        bool load(const std::uint64_t key, program_binary& binary);
+
+        void store(const std::uint64_t key, const program_binary& binary);
+
+        // The binary for the key was rejected by the driver.
+        void remove(const std::uint64_t key);
+
+        const statistics& get_statistics() const noexcept;
+
+    private:
+        std::string get_file_path(const std::uint64_t key) const;
+
+        std::string m_directory {};
+        std::string m_driver_id {};
+        bool m_enabled {};
+
+        statistics m_statistics {};
+    };
+
+    // Directory for the program cache: SDL preference path of the game
+    // or ARCI_SHADER_CACHE environment variable. Empty string (cache
+    // disabled) if ARCI_SHADER_CACHE is set to "off".
+    std::string get_default_program_cache_directory();
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
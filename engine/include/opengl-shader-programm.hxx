@@ -2,10 +2,14 @@
 
 #include "glad/glad.h"
 
+#include "opengl-program-cache.hxx"
+
 #include <glm/ext/matrix_float2x2_precision.hpp>
 
+#include <cstdint>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -15,6 +19,34 @@ namespace arci
 
     ///////////////////////////////////////////////////////////////////////////////
 
+    // FNV-1a hash of uniform/attribute name. Names are hashed once,
+    // so lookups don't compare strings.
+    constexpr std::uint32_t shader_name_id(const std::string_view name)
+    {
+        std::uint32_t hash { 2166136261u };
+
+        for (const char c : name)
+        {
+            hash ^= static_cast<std::uint8_t>(c);
+            hash *= 16777619u;
+        }
+
+        return hash;
+    }
+
+    // Location of a uniform resolved at link time.
+    struct uniform_handle
+    {
+        GLint location { -1 };
+
+        bool is_valid() const noexcept
+        {
+            return location != -1;
+        }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
     class opengl_shader_program final
     {
     public:
@@ -25,35 +57,86 @@ namespace arci
         opengl_shader_program& operator=(const opengl_shader_program&) = delete;
         opengl_shader_program& operator=(opengl_shader_program&&) = delete;
 
+        // Preprocessor lines (e.g. feature `#define`s) inserted after the
+        // `#version` line of every shader loaded afterwards.
+        void set_defines(std::string defines);
+
+        // Only reads the source, shaders are compiled by prepare_program().
         void load_shader(
             const GLenum shader_type,
             const std::string_view shader_path);
 
-        // Attach all shaders, compile, link and validate program.
-        void prepare_program();
+        // Compile all shaders, attach them, link and validate program.
+        // With the cache the program is first looked up there by its
+        // sources and built from the source only on a miss (the new binary
+        // is stored then). Locations of all active uniforms and attributes
+        // are collected right after linking.
+        void prepare_program(opengl_program_cache* cache = nullptr);
+
+        // Invalid handle is returned if the uniform is not active.
+        uniform_handle get_uniform(const std::string_view name) const;
 
-        void set_uniform(const std::string_view matrix_attribute_name,
+        // Returns -1 if the attribute is not active.
+        GLint get_attribute_location(const std::string_view name) const;
+
+        // Program should be in use.
+        void set_uniform(const uniform_handle handle,
                          const glm::mediump_mat3& result_matrix);
 
-        void set_uniform(const std::string_view texture_attribute_name);
+        // Set texture unit for a sampler. Program should be in use.
+        void set_uniform(const uniform_handle handle,
+                         const GLint texture_unit);
+
+        // Unlike other setters works with any program in use
+        // (glProgramUniform1f).
+        void set_uniform(const uniform_handle handle, const GLfloat value);
+
+        // Connect uniform block with the binding point of uniform buffer.
+        // Returns false if the program has no such active block.
+        bool bind_uniform_block(const std::string_view block_name,
+                                const GLuint binding_point);
 
         // Use this shader for rendering objects.
         void apply_shader_program();
 
+        GLuint get_program_id() const noexcept;
+
     private:
         // IMPORTANT NOTE: it's assumed that the user specifies attribute
         // location directly in the shader source file by using `location`
         // layout qualifier (opengl es 3.2). So, there is no need to call
         // glBindAttributeLocation().
+        struct shader_source
+        {
+            GLenum type {};
+            std::string code {};
+        };
+
+        void compile_shader(const GLenum shader_type,
+                            const std::string& shader_code_string);
         void attach_shaders();
         void link_program() const;
         void validate_program() const;
+        void reflect_program();
+
+        // Returns false if there is no binary or the driver rejected it.
+        bool load_program_binary(opengl_program_cache& cache,
+                                 const std::uint64_t key);
+        void store_program_binary(opengl_program_cache& cache,
+                                  const std::uint64_t key) const;
 
         std::string get_shader_code_from_file(const std::string_view path) const;
 
+        std::string m_defines {};
+        std::vector<shader_source> m_sources {};
+
         // All shader ids.
         std::vector<GLuint> m_shaders {};
         GLuint m_program {};
+
+        // Name id -> location.
+        std::unordered_map<std::uint32_t, GLint> m_uniform_locations {};
+        std::unordered_map<std::uint32_t, GLint> m_attribute_locations {};
     };
 
     ///////////////////////////////////////////////////////////////////////////////
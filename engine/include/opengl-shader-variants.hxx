@@ -0,0 +1,68 @@
+#pragma once
+
+#include "opengl-shader-programm.hxx"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Bit `i` enables the i-th feature define of the variants.
+    using shader_features = std::uint32_t;
+
+    // Permutations of one vertex/fragment shader pair. Every feature is a
+    // preprocessor define inserted after the `#version` line of both
+    // sources. A variant is compiled when it is requested for the first
+    // time, so permutations that are never used are never compiled.
+    class opengl_shader_variants final
+    {
+    public:
+        // Called once for every new variant, e.g. to set sampler units
+        // and uniform block bindings.
+        using setup_callback = std::function<void(opengl_shader_program&,
+                                                  const shader_features)>;
+
+        opengl_shader_variants(std::string vertex_shader_name,
+                               std::string fragment_shader_name,
+                               std::vector<std::string> feature_defines,
+                               opengl_program_cache* cache,
+                               setup_callback setup);
+        opengl_shader_variants(const opengl_shader_variants&) = delete;
+        opengl_shader_variants(opengl_shader_variants&&) = delete;
+        opengl_shader_variants& operator=(const opengl_shader_variants&) = delete;
+        opengl_shader_variants& operator=(opengl_shader_variants&&) = delete;
+
+        // Compiles the variant if it wasn't requested before.
+        opengl_shader_program& get(const shader_features features);
+
+        std::size_t get_compiled_number() const noexcept;
+
+    private:
+        std::string get_defines(const shader_features features) const;
+
+        std::string m_vertex_shader_name {};
+        std::string m_fragment_shader_name {};
+        std::vector<std::string> m_feature_defines {};
+        opengl_program_cache* m_cache { nullptr };
+        setup_callback m_setup {};
+
+        std::unordered_map<shader_features,
+                           std::unique_ptr<opengl_shader_program>>
+            m_programs {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
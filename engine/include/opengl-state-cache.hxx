@@ -0,0 +1,102 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <array>
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Shadow copy of the GL state the engine touches while rendering.
+    // Every bind/use/enable goes through this class, so a GL call is only
+    // issued when it really changes the state. If some code outside the
+    // engine changes GL state (e.g. ImGui backend), invalidate() must be
+    // called afterwards.
+    class opengl_state_cache final
+    {
+    public:
+        struct statistics
+        {
+            std::size_t calls_issued {};
+            std::size_t calls_avoided {};
+        };
+
+        static constexpr std::size_t max_texture_units { 8 };
+
+        opengl_state_cache() = default;
+        opengl_state_cache(const opengl_state_cache&) = delete;
+        opengl_state_cache(opengl_state_cache&&) = delete;
+        opengl_state_cache& operator=(const opengl_state_cache&) = delete;
+        opengl_state_cache& operator=(opengl_state_cache&&) = delete;
+
+        void use_program(const GLuint program);
+
+        // Target should be GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY.
+        void bind_texture(const GLuint unit,
+                          const GLenum target,
+                          const GLuint texture);
+
+        void bind_vertex_array(const GLuint vao);
+
+        // Element array buffer binding is a part of the VAO state, so it is
+        // tracked for the currently bound VAO only.
+        void bind_buffer(const GLenum target, const GLuint buffer);
+
+        void set_blend(const bool enabled);
+        void set_blend_func(const GLenum src_factor, const GLenum dst_factor);
+
+        void set_depth_test(const bool enabled);
+        void set_depth_mask(const bool enabled);
+
+        // Deleting bound objects resets the bindings to 0 (as GL does).
+        void delete_texture(const GLuint texture);
+        void delete_vertex_array(const GLuint vao);
+        void delete_buffer(const GLuint buffer);
+
+        // Forget everything we know about the current GL state.
+        void invalidate();
+
+        const statistics& get_statistics() const noexcept;
+        void reset_statistics() noexcept;
+
+    private:
+        static constexpr GLuint unknown { ~0u };
+        static constexpr GLenum unknown_enum { ~0u };
+
+        struct texture_unit
+        {
+            GLuint texture_2d { unknown };
+            GLuint texture_2d_array { unknown };
+        };
+
+        GLuint& texture_binding(texture_unit& unit, const GLenum target);
+
+        // Returns true if GL call should be issued.
+        bool update(GLuint& cached, const GLuint value) noexcept;
+
+        GLuint m_program { unknown };
+        GLuint m_active_texture_unit { unknown };
+        std::array<texture_unit, max_texture_units> m_texture_units {};
+        GLuint m_vertex_array { unknown };
+        GLuint m_array_buffer { unknown };
+        GLuint m_element_array_buffer { unknown };
+        GLuint m_uniform_buffer { unknown };
+        GLuint m_blend_enabled { unknown };
+        GLenum m_blend_src_factor { unknown_enum };
+        GLenum m_blend_dst_factor { unknown_enum };
+        GLuint m_depth_test_enabled { unknown };
+        GLuint m_depth_mask { unknown };
+
+        statistics m_statistics {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
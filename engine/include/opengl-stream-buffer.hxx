@@ -0,0 +1,77 @@
+#pragma once
+
+#include "glad/glad.h"
+
+#include <array>
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    class opengl_state_cache;
+
+    // Ring buffer for geometry which lives only for one frame (sprite
+    // batches, ImGui draw lists, ...). The buffer is split into
+    // `frames_in_flight` regions, one per frame. Data is written with
+    // glMapBufferRange(GL_MAP_UNSYNCHRONIZED_BIT), so the driver never
+    // stalls on a buffer the GPU is still reading. Instead every region
+    // is protected by a fence, and we wait for it only when the ring wraps
+    // around to the region again (normally it is signaled long before).
+    class opengl_stream_buffer final
+    {
+    public:
+        static constexpr std::size_t frames_in_flight { 3 };
+
+        opengl_stream_buffer(opengl_state_cache& state_cache,
+                             const std::size_t frame_capacity);
+        ~opengl_stream_buffer();
+        opengl_stream_buffer(const opengl_stream_buffer&) = delete;
+        opengl_stream_buffer(opengl_stream_buffer&&) = delete;
+        opengl_stream_buffer& operator=(const opengl_stream_buffer&) = delete;
+        opengl_stream_buffer& operator=(opengl_stream_buffer&&) = delete;
+
+        // Copies data into the region of the current frame and returns its
+        // offset in bytes from the start of the buffer. Offset is a multiple
+        // of `alignment` (e.g. vertex stride for base vertex drawing).
+        // If the region is full, the buffer grows by orphaning its storage:
+        // draws issued before keep reading the old storage, but offsets
+        // returned before should not be used for new draws.
+        //
+        // Every push maps and unmaps the buffer, so geometry of many draws
+        // should be pushed at once rather than draw by draw.
+        std::size_t push(const void* data,
+                         const std::size_t size,
+                         const std::size_t alignment);
+
+        // Grows the buffer now if `size` bytes, alignment padding
+        // included, don't fit into the rest of the region, so several
+        // pushes of that much in total keep their offsets valid.
+        void reserve(const std::size_t size);
+
+        // Fences the region of the finished frame and moves to the next one.
+        void end_frame();
+
+        GLuint get_buffer_id() const noexcept;
+
+    private:
+        void allocate_storage(const std::size_t frame_capacity);
+        void wait_for_region(const std::size_t region);
+        void delete_fences();
+
+        opengl_state_cache& m_state_cache;
+        GLuint m_buffer_id {};
+        std::size_t m_frame_capacity {};
+        std::size_t m_region {};
+        std::size_t m_cursor {};
+        std::array<GLsync, frames_in_flight> m_fences {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "opengl-stream-buffer.hxx"
+
+#include "glad/glad.h"
+
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    class opengl_state_cache;
+
+    // Uniform buffer object attached to the indexed binding point. Every
+    // program that connects its uniform block to the same binding point
+    // (see opengl_shader_program::bind_uniform_block()) shares the data,
+    // so constants are uploaded once instead of once per program.
+    //
+    // Every update is written to a new range of a stream buffer and the
+    // binding point is moved to it, so the GPU may still read the data
+    // of earlier frames without the driver stalling or copying the
+    // buffer.
+    class opengl_uniform_buffer final
+    {
+    public:
+        opengl_uniform_buffer(opengl_state_cache& state_cache,
+                              const GLuint binding_point,
+                              const std::size_t size);
+        ~opengl_uniform_buffer();
+        opengl_uniform_buffer(const opengl_uniform_buffer&) = delete;
+        opengl_uniform_buffer(opengl_uniform_buffer&&) = delete;
+        opengl_uniform_buffer& operator=(const opengl_uniform_buffer&) = delete;
+        opengl_uniform_buffer& operator=(opengl_uniform_buffer&&) = delete;
+
+        // Data should follow std140 layout of the uniform block.
+        void update(const void* data, const std::size_t size);
+
+        // Fences the updates of the finished frame, see
+        // opengl_stream_buffer::end_frame().
+        void end_frame();
+
+        GLuint get_binding_point() const noexcept;
+
+    private:
+        opengl_state_cache& m_state_cache;
+        GLuint m_binding_point {};
+        std::size_t m_size {};
+        // Ranges bound to the binding point start at multiples of
+        // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT.
+        std::size_t m_alignment {};
+        opengl_stream_buffer m_stream;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
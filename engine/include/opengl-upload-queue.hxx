@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // GL work prepared by worker threads (e.g. texture upload of a decoded
+    // image). Uploads are pushed from any thread and executed on the GL
+    // thread a few per frame, so loading doesn't stall frames.
+    class opengl_upload_queue final
+    {
+    public:
+        using upload = std::function<void()>;
+
+        opengl_upload_queue() = default;
+        opengl_upload_queue(const opengl_upload_queue&) = delete;
+        opengl_upload_queue(opengl_upload_queue&&) = delete;
+        opengl_upload_queue& operator=(const opengl_upload_queue&) = delete;
+        opengl_upload_queue& operator=(opengl_upload_queue&&) = delete;
+
+        // Any thread.
+        void push(upload new_upload);
+
+        // GL thread. Executes uploads in the order they were pushed until
+        // the budget is spent, at least one upload is executed if there
+        // is any. Returns the number of executed uploads.
+        std::size_t execute(const std::chrono::microseconds budget);
+
+        // GL thread. Executes everything pushed so far.
+        std::size_t execute_all();
+
+        // Drops uploads not executed yet.
+        void clear();
+
+    private:
+        upload pop();
+
+        std::deque<upload> m_uploads {};
+        std::mutex m_mutex {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
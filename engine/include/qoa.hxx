@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // QOA, the "Quite OK Audio" format (https://qoaformat.org): lossy
+    // 16-bit audio at 3.2 bits per sample, decoded with a few integer
+    // operations per sample. Files are written by engine/tools/arci-qoa.cxx
+    // and read by the engine (qoa-source.cxx). All values are big-endian:
+    //   file header: "qoaf", u32 samples per channel
+    //   frames of up to qoa_frame_samples samples per channel:
+    //     u8 channels, u24 rate, u16 samples per channel, u16 frame size
+    //     per channel: u64 LMS history, u64 LMS weights (4 x s16 each)
+    //     slices of qoa_slice_samples samples, one per channel in turn:
+    //     4 bits of scalefactor index, 20 x 3 bits of quantized residuals
+    inline constexpr std::uint32_t qoa_magic { 0x716f6166 };
+    inline constexpr std::size_t qoa_file_header_size { 8 };
+    inline constexpr std::size_t qoa_frame_header_size { 8 };
+    inline constexpr std::size_t qoa_slice_samples { 20 };
+    inline constexpr std::size_t qoa_frame_slices { 256 };
+    inline constexpr std::size_t qoa_frame_samples { qoa_slice_samples
+                                                     * qoa_frame_slices };
+    inline constexpr std::size_t qoa_channels_max { 8 };
+
+    inline constexpr std::size_t get_qoa_frame_size(const std::size_t channels,
+                                                    const std::size_t samples)
+    {
+        const std::size_t slices
+            = (samples + qoa_slice_samples - 1) / qoa_slice_samples;
+        return qoa_frame_header_size + 16 * channels + 8 * slices * channels;
+    }
+
+    // round((index + 1) ^ 2.75)
+    inline constexpr std::array<int, 16> qoa_scalefactors {
+        1, 7, 21, 45, 84, 138, 211, 304, 421, 562, 731, 928, 1157, 1419, 1715, 2048
+    };
+
+    // Residual of a quantized value (0..7) at a scalefactor: the
+    // scalefactor times 0.75, -0.75, 2.5, -2.5, 4.5, -4.5, 7, -7, rounded
+    // away from zero.
+    inline constexpr std::array<std::array<int, 8>, 16> qoa_dequantized = [] {
+        constexpr int numerators[8] { 3, -3, 5, -5, 9, -9, 7, -7 };
+        constexpr int denominators[8] { 4, 4, 2, 2, 2, 2, 1, 1 };
+
+        std::array<std::array<int, 8>, 16> table {};
+
+        for (std::size_t s = 0; s < table.size(); s++)
+        {
+            for (std::size_t q = 0; q < table[s].size(); q++)
+            {
+                const int magnitude = qoa_scalefactors[s]
+                    * (numerators[q] < 0 ? -numerators[q] : numerators[q]);
+                const int rounded
+                    = (2 * magnitude + denominators[q]) / (2 * denominators[q]);
+                table[s][q] = numerators[q] < 0 ? -rounded : rounded;
+            }
+        }
+
+        return table;
+    }();
+
+    // Predicts a sample from the 4 previous ones, the weights adapt to
+    // the signal as it is decoded.
+    struct qoa_lms
+    {
+        std::array<int, 4> history {};
+        std::array<int, 4> weights {};
+
+        int predict() const noexcept
+        {
+            int prediction {};
+
+            for (std::size_t i = 0; i < 4; i++)
+            {
+                prediction += weights[i] * history[i];
+            }
+
+            return prediction >> 13;
+        }
+
+        void update(const int sample, const int residual) noexcept
+        {
+            const int delta = residual >> 4;
+
+            for (std::size_t i = 0; i < 4; i++)
+            {
+                weights[i] += history[i] < 0 ? -delta : delta;
+            }
+
+            history[0] = history[1];
+            history[1] = history[2];
+            history[2] = history[3];
+            history[3] = sample;
+        }
+    };
+
+    inline int clamp_qoa_sample(const int sample) noexcept
+    {
+        return std::clamp(sample, -32768, 32767);
+    }
+
+    inline std::uint64_t read_qoa_u64(const std::uint8_t* bytes) noexcept
+    {
+        std::uint64_t value {};
+
+        for (std::size_t i = 0; i < 8; i++)
+        {
+            value = value << 8 | bytes[i];
+        }
+
+        return value;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Fields of the sort key, from the most significant bits:
+    //       63 - translucent (all opaque commands go first)
+    //   62..55 - layer, descending for opaque commands
+    //   54..48 - program
+    //   47..24 - texture
+    //   23..0  - depth, descending for translucent commands
+    struct sort_key_fields
+    {
+        std::uint8_t layer {};
+        bool translucent {};
+        std::uint8_t program {};
+        std::uint32_t texture {};
+        // [0, 1], 0 is the nearest to the viewer.
+        float depth {};
+    };
+
+    std::uint64_t make_sort_key(const sort_key_fields& fields);
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Keys of the commands submitted during the frame. The queue only
+    // orders commands, they are stored and executed by the owner, which
+    // refers to them by index.
+    class render_queue final
+    {
+    public:
+        struct item
+        {
+            std::uint64_t key {};
+            std::uint32_t command {};
+        };
+
+        void push(const std::uint64_t key, const std::uint32_t command);
+
+        // Stable LSD radix sort by key, one pass per byte. Passes over
+        // bytes which are the same for all keys are skipped.
+        void sort();
+
+        void clear();
+
+        const std::vector<item>& get_items() const noexcept;
+
+        // Number of program or texture switches needed to draw items
+        // in their current order.
+        std::size_t count_state_changes() const noexcept;
+
+    private:
+        std::vector<item> m_items {};
+        std::vector<item> m_scratch {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Thread which owns the GL context. The game thread records commands
+    // (closures holding copies of everything they need) into the frame
+    // being built, and the render thread executes whole frames while the
+    // game thread simulates the next one. No more than `frames_in_flight`
+    // recorded frames wait for (or are in) execution, so the game thread
+    // is never more than that ahead of GL submission.
+    // Without the thread (inline mode) commands are executed right away.
+    class render_thread final
+    {
+    public:
+        using command = std::function<void()>;
+
+        static constexpr std::size_t frames_in_flight { 2 };
+
+        render_thread() = default;
+        ~render_thread();
+        render_thread(const render_thread&) = delete;
+        render_thread(render_thread&&) = delete;
+        render_thread& operator=(const render_thread&) = delete;
+        render_thread& operator=(render_thread&&) = delete;
+
+        // `on_start` is the first command executed by the render thread
+        // (e.g. to make the GL context current).
+        void start(const bool threaded, command on_start);
+
+        // Executes all recorded commands and `on_stop`, then joins.
+        void stop(command on_stop);
+
+        void record(command cmd);
+
+        // Hands the recorded frame over to the render thread. Blocks while
+        // there are `frames_in_flight` frames not executed yet.
+        void submit_frame();
+
+        // Submits the recorded commands and waits until everything
+        // is executed.
+        void flush();
+
+        bool is_threaded() const noexcept;
+
+        // When execution of the current frame began. Should be called by
+        // its commands. In inline mode the frame also includes the game
+        // logic run between submit_frame() calls.
+        std::chrono::steady_clock::time_point get_frame_start() const noexcept;
+
+    private:
+        using frame = std::vector<command>;
+
+        void run();
+
+        bool m_threaded { false };
+        bool m_stopping { false };
+        std::chrono::steady_clock::time_point m_frame_start {};
+
+        frame m_recording {};
+        // Front frame is the one being executed.
+        std::deque<frame> m_pending {};
+        // Executed frames, kept to reuse their memory.
+        std::vector<frame> m_free_frames {};
+
+        std::mutex m_mutex {};
+        std::condition_variable m_frame_submitted {};
+        std::condition_variable m_frame_executed {};
+        std::thread m_worker {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "engine.hxx"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Slot index plus the generation of the slot at the moment the handle
+    // was given out. When the resource is freed the generation changes,
+    // so a handle kept after its release is detected instead of pointing
+    // to another resource loaded into the same slot.
+    template <typename T>
+    struct resource_handle
+    {
+        std::uint32_t index {};
+        // 0 is never used by a slot, so default handles are invalid.
+        std::uint32_t generation {};
+
+        bool is_valid() const noexcept
+        {
+            return generation != 0;
+        }
+    };
+
+    using texture_handle = resource_handle<itexture>;
+    using texture_array_handle = resource_handle<itexture_array>;
+    using sound_handle = resource_handle<iaudio_buffer>;
+
+    enum class resource_type
+    {
+        texture,
+        texture_array,
+        sound
+    };
+
+    struct resource_usage
+    {
+        // Loaded resources.
+        std::size_t resources {};
+        // Handles acquired and not released yet.
+        std::size_t references {};
+        std::size_t bytes {};
+    };
+
+    // Loads every file once. Resources are keyed by normalized path, the
+    // same path acquired again gives a handle to the already loaded
+    // resource and increments its reference count. The resource is
+    // destroyed when the last reference is released.
+    //
+    // Shader programs are not managed here: they are owned by the engine,
+    // which compiles each variant once and caches program binaries.
+    //
+    // Game thread only.
+    class resource_manager final
+    {
+    public:
+        explicit resource_manager(iengine* engine);
+        // Every handle should be released before, as textures must be
+        // destroyed before the engine is uninitialized.
+        ~resource_manager();
+        resource_manager(const resource_manager&) = delete;
+        resource_manager(resource_manager&&) = delete;
+        resource_manager& operator=(const resource_manager&) = delete;
+        resource_manager& operator=(resource_manager&&) = delete;
+
+        texture_handle acquire_texture(const std::string_view path);
+        texture_array_handle acquire_texture_array(
+            const std::vector<std::string_view>& paths);
+        sound_handle acquire_sound(const std::string_view path);
+
+        // Returns nullptr for released handles.
+        itexture* get(const texture_handle handle) const;
+        itexture_array* get(const texture_array_handle handle) const;
+        iaudio_buffer* get(const sound_handle handle) const;
+
+        // The handle is reset, so it can't be released twice.
+        void release(texture_handle& handle);
+        void release(texture_array_handle& handle);
+        void release(sound_handle& handle);
+
+        resource_usage get_usage(const resource_type type) const;
+
+    private:
+        template <typename T>
+        class resource_pool
+        {
+        public:
+            // Returns false if the key wasn't loaded before, the caller
+            // should then create the resource and `insert` it.
+            bool find(const std::string& key, resource_handle<T>& handle);
+            resource_handle<T> insert(const std::string& key, T* resource);
+
+            T* get(const resource_handle<T> handle) const;
+
+            // Returns the resource to destroy when the last reference was
+            // released, nullptr otherwise.
+            T* release(resource_handle<T>& handle);
+
+            resource_usage get_usage() const;
+
+        private:
+            struct slot
+            {
+                T* resource { nullptr };
+                std::uint32_t generation { 1 };
+                std::size_t references {};
+                std::string key {};
+            };
+
+            const slot* get_slot(const resource_handle<T> handle) const;
+
+            std::vector<slot> m_slots {};
+            std::vector<std::uint32_t> m_free_slots {};
+            std::unordered_map<std::string, std::uint32_t> m_indices {};
+        };
+
+        iengine* m_engine { nullptr };
+        resource_pool<itexture> m_textures {};
+        resource_pool<itexture_array> m_texture_arrays {};
+        resource_pool<iaudio_buffer> m_sounds {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
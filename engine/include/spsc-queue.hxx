@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Bounded wait-free queue for exactly one producer thread and one
+    // consumer thread (e.g. game thread -> audio callback). Neither side
+    // ever blocks or allocates: pushing to a full queue and popping from
+    // an empty one just fail.
+    template <typename T, std::size_t Capacity>
+    class spsc_queue final
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                      "Capacity should be a power of two");
+
+    public:
+        spsc_queue() = default;
+        spsc_queue(const spsc_queue&) = delete;
+        spsc_queue(spsc_queue&&) = delete;
+        spsc_queue& operator=(const spsc_queue&) = delete;
+        spsc_queue& operator=(spsc_queue&&) = delete;
+
+        // Producer thread.
+        bool try_push(const T& item) noexcept
+        {
+            const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+
+            if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+            {
+                return false;
+            }
+
+            m_items[tail & (Capacity - 1)] = item;
+            m_tail.store(tail + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // Consumer thread.
+        bool try_pop(T& item) noexcept
+        {
+            const std::size_t head = m_head.load(std::memory_order_relaxed);
+
+            if (head == m_tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            item = m_items[head & (Capacity - 1)];
+            m_head.store(head + 1, std::memory_order_release);
+
+            return true;
+        }
+
+    private:
+        // Indices grow forever and wrap with std::size_t, only their
+        // difference matters. They live on separate cache lines, so the
+        // threads don't invalidate each other's line on every operation.
+        alignas(64) std::atomic<std::size_t> m_head {};
+        alignas(64) std::atomic<std::size_t> m_tail {};
+        alignas(64) std::array<T, Capacity> m_items {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Fixed number of threads executing tasks in submission order. Used
+    // for work which doesn't touch GL (file reading, decoding), results
+    // are handed to the GL thread by the tasks themselves.
+    class worker_pool final
+    {
+    public:
+        using task = std::function<void()>;
+
+        // At least one thread is started.
+        explicit worker_pool(const std::size_t threads_number);
+        // Tasks not started yet are dropped.
+        ~worker_pool();
+        worker_pool(const worker_pool&) = delete;
+        worker_pool(worker_pool&&) = delete;
+        worker_pool& operator=(const worker_pool&) = delete;
+        worker_pool& operator=(worker_pool&&) = delete;
+
+        void submit(task new_task);
+
+        // Blocks until all submitted tasks are finished.
+        void wait_idle();
+
+        // One thread per core, leaving one for the game and one for the
+        // render thread.
+        static std::size_t get_default_threads_number();
+
+    private:
+        void run();
+
+        bool m_stopping { false };
+        std::size_t m_running_tasks {};
+        std::deque<task> m_tasks {};
+
+        std::mutex m_mutex {};
+        std::condition_variable m_task_submitted {};
+        std::condition_variable m_task_finished {};
+        std::vector<std::thread> m_threads {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
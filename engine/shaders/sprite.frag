@@ -0,0 +1,25 @@
+#version 320 es
+// See sprite.vert for the features.
+precision mediump float;
+precision mediump sampler2DArray;
+
+in vec4 v_color;
+#ifdef TEXTURE_ARRAY
+in vec3 v_texture;
+uniform sampler2DArray s_texture;
+#else
+in vec2 v_texture;
+uniform sampler2D s_texture;
+#endif
+out vec4 frag_color;
+
+void main()
+{
+    frag_color = texture(s_texture, v_texture);
+#ifdef ALPHA_TEST
+    if (frag_color.a < 0.5)
+    {
+        discard;
+    }
+#endif
+}
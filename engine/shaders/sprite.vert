@@ -0,0 +1,53 @@
+#version 320 es
+// Features are enabled by defines the engine inserts after the version:
+// MODEL_MATRIX - positions are in object space and moved to the world by
+//                u_matrix, otherwise they are already in the world and the
+//                depth comes from u_depth.
+// TEXTURE_ARRAY - `z` component of the position is the layer of the texture
+//                 array.
+// ALPHA_TEST - sprite.frag discards fragments with alpha below 0.5.
+#ifdef TEXTURE_ARRAY
+layout(location = 0) in vec3 a_position;
+#else
+layout(location = 0) in vec2 a_position;
+#endif
+layout(location = 1) in vec4 a_color;
+layout(location = 2) in vec2 a_texture;
+layout(std140) uniform frame_constants
+{
+    mat3 u_view_projection;
+    vec2 u_resolution;
+    float u_time;
+};
+#ifdef MODEL_MATRIX
+// Model matrix: from object to world coordinates.
+uniform mat3 u_matrix;
+#else
+// Window depth of the draw, see engine render queue.
+uniform float u_depth;
+#endif
+out vec4 v_color;
+#ifdef TEXTURE_ARRAY
+out vec3 v_texture;
+#else
+out vec2 v_texture;
+#endif
+
+void main()
+{
+    v_color = a_color;
+#ifdef TEXTURE_ARRAY
+    v_texture = vec3(a_texture, a_position.z);
+#else
+    v_texture = a_texture;
+#endif
+#ifdef MODEL_MATRIX
+    vec3 world_pos = u_matrix * vec3(a_position.xy, 1.0);
+    float depth = 1.0;
+#else
+    vec3 world_pos = vec3(a_position.xy, 1.0);
+    float depth = u_depth * 2.0 - 1.0;
+#endif
+    vec3 ndc_pos = u_view_projection * vec3(world_pos.xy, 1.0);
+    gl_Position = vec4(ndc_pos.xy, depth, 1.0);
+}
@@ -0,0 +1,287 @@
+#include "asset-pack.hxx"
+#include "embedded-assets.hxx"
+
+#include "helper.hxx"
+
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    asset_pack::~asset_pack()
+    {
+        close();
+    }
+
+    bool asset_pack::open(const std::string& path)
+    {
+        close();
+
+        if (!map_file(path))
+        {
+            return false;
+        }
+
+        if (!read_index())
+        {
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void asset_pack::close()
+    {
+        m_entries.clear();
+        unmap_file();
+    }
+
+    bool asset_pack::is_open() const noexcept
+    {
+        return m_data != nullptr;
+    }
+
+    asset_span asset_pack::find(const std::string_view name) const
+    {
+        const auto it = m_entries.find(name);
+        return it != m_entries.end() ? it->second : asset_span {};
+    }
+
+    std::size_t asset_pack::get_entries_number() const noexcept
+    {
+        return m_entries.size();
+    }
+
+#ifdef _WIN32
+    bool asset_pack::map_file(const std::string& path)
+    {
+        HANDLE file = CreateFileA(path.c_str(),
+                                  GENERIC_READ,
+                                  FILE_SHARE_READ,
+                                  nullptr,
+                                  OPEN_EXISTING,
+                                  FILE_ATTRIBUTE_NORMAL,
+                                  nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER size {};
+
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping
+            = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (!mapping)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+        if (!data)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        m_file = file;
+        m_mapping = mapping;
+        m_data = static_cast<const std::uint8_t*>(data);
+        m_size = static_cast<std::size_t>(size.QuadPart);
+
+        return true;
+    }
+
+    void asset_pack::unmap_file()
+    {
+        if (m_data)
+        {
+            UnmapViewOfFile(m_data);
+            CloseHandle(m_mapping);
+            CloseHandle(m_file);
+        }
+
+        m_data = nullptr;
+        m_size = 0;
+        m_mapping = nullptr;
+        m_file = nullptr;
+    }
+#else
+    bool asset_pack::map_file(const std::string& path)
+    {
+        const int file = ::open(path.c_str(), O_RDONLY);
+
+        if (file == -1)
+        {
+            return false;
+        }
+
+        struct stat file_status
+        {
+        };
+
+        if (fstat(file, &file_status) != 0 || file_status.st_size <= 0)
+        {
+            ::close(file);
+            return false;
+        }
+
+        const std::size_t size = static_cast<std::size_t>(file_status.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+        // The mapping keeps the file alive.
+        ::close(file);
+
+        if (data == MAP_FAILED)
+        {
+            return false;
+        }
+
+        m_data = static_cast<const std::uint8_t*>(data);
+        m_size = size;
+
+        return true;
+    }
+
+    void asset_pack::unmap_file()
+    {
+        if (m_data)
+        {
+            CHECK(munmap(const_cast<std::uint8_t*>(m_data), m_size) == 0);
+        }
+
+        m_data = nullptr;
+        m_size = 0;
+    }
+#endif
+
+    bool asset_pack::read_index()
+    {
+        asset_pack_header header {};
+
+        if (m_size < sizeof(header))
+        {
+            return false;
+        }
+
+        std::memcpy(&header, m_data, sizeof(header));
+
+        if (std::memcmp(header.magic, asset_pack_header {}.magic, 4) != 0
+            || header.version != asset_pack_version
+            || header.index_offset > m_size
+            || (m_size - header.index_offset) / sizeof(asset_pack_entry)
+                < header.entries_number)
+        {
+            return false;
+        }
+
+        for (std::uint32_t i = 0; i < header.entries_number; i++)
+        {
+            asset_pack_entry entry {};
+            std::memcpy(&entry,
+                        m_data + header.index_offset
+                            + i * sizeof(asset_pack_entry),
+                        sizeof(entry));
+
+            if (entry.offset % asset_pack_alignment != 0
+                || entry.offset > m_size || m_size - entry.offset < entry.size
+                || entry.name_offset > m_size
+                || m_size - entry.name_offset < entry.name_size)
+            {
+                return false;
+            }
+
+            const std::string_view name {
+                reinterpret_cast<const char*>(m_data + entry.name_offset),
+                entry.name_size
+            };
+
+            const auto [it, inserted] = m_entries.insert(
+                { name,
+                  asset_span { m_data + entry.offset,
+                               static_cast<std::size_t>(entry.size) } });
+
+            if (!inserted)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    static asset_pack mounted_pack {};
+
+    bool mount_asset_pack(const std::string& path)
+    {
+        CHECK(!mounted_pack.is_open());
+        return !path.empty() && mounted_pack.open(path);
+    }
+
+    void unmount_asset_pack()
+    {
+        mounted_pack.close();
+    }
+
+    asset_span find_packed_asset(const std::string_view name)
+    {
+        return mounted_pack.find(name);
+    }
+
+    asset_span find_asset(const std::string_view name)
+    {
+        const asset_span embedded = find_embedded_asset(name);
+        return !embedded.empty() ? embedded : find_packed_asset(name);
+    }
+
+    std::string get_default_asset_pack_path()
+    {
+        const char* requested = std::getenv("ARCI_ASSET_PACK");
+
+        if (requested)
+        {
+            if (std::string_view { requested } == "off")
+            {
+                return {};
+            }
+
+            return requested;
+        }
+
+        return "arcanoid.pack";
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
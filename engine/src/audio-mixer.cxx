@@ -0,0 +1,513 @@
+#include "audio-mixer.hxx"
+#include "audio-stream.hxx"
+
+#include "helper.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    float audio_mixer::voice::get_gain() const noexcept
+    {
+        return sound_gain * parameters.gain;
+    }
+
+    audio_mixer::audio_mixer(const SDL_AudioFormat format,
+                             const std::size_t frames_max)
+        : m_format { format }
+        , m_frames_max { std::max<std::size_t>(frames_max, 1) }
+    {
+        CHECK(m_format == SDL_AUDIO_S16LSB || m_format == SDL_AUDIO_F32LSB);
+
+        m_mix_buffer.resize(m_frames_max * 2);
+
+        for (std::size_t i = 0; i < voices_max; i++)
+        {
+            m_free_voices[m_free_voices_number++]
+                = static_cast<std::uint8_t>(voices_max - 1 - i);
+        }
+    }
+
+    voice_id audio_mixer::play(const audio_samples* samples,
+                               const bool looped,
+                               const float sound_gain,
+                               const voice_parameters& parameters)
+    {
+        CHECK_NOTNULL(samples);
+
+        command play_command {};
+        play_command.type = command_type::play;
+        play_command.looped = looped;
+        play_command.voice = ++m_last_voice_id;
+        play_command.sound_gain = sound_gain;
+        play_command.parameters = parameters;
+        play_command.samples = samples;
+        push(play_command);
+
+        return play_command.voice;
+    }
+
+    void audio_mixer::stop(const audio_samples* samples)
+    {
+        CHECK_NOTNULL(samples);
+
+        command stop_command {};
+        stop_command.type = command_type::stop_samples;
+        stop_command.samples = samples;
+        push(stop_command);
+    }
+
+    void audio_mixer::stop(const voice_id voice)
+    {
+        command stop_command {};
+        stop_command.type = command_type::stop_voice;
+        stop_command.voice = voice;
+        push(stop_command);
+    }
+
+    void audio_mixer::set_gain(const audio_samples* samples,
+                               const float sound_gain)
+    {
+        CHECK_NOTNULL(samples);
+
+        command gain_command {};
+        gain_command.type = command_type::set_gain;
+        gain_command.sound_gain = sound_gain;
+        gain_command.samples = samples;
+        push(gain_command);
+    }
+
+    void audio_mixer::set_voice_parameters(const voice_id voice,
+                                           const voice_parameters& parameters)
+    {
+        command parameters_command {};
+        parameters_command.type = command_type::set_voice_parameters;
+        parameters_command.voice = voice;
+        parameters_command.parameters = parameters;
+        push(parameters_command);
+    }
+
+    void audio_mixer::set_voice_stealing(const voice_stealing policy)
+    {
+        command stealing_command {};
+        stealing_command.type = command_type::set_voice_stealing;
+        stealing_command.stealing = policy;
+        push(stealing_command);
+    }
+
+    void audio_mixer::release(const audio_samples* samples)
+    {
+        CHECK_NOTNULL(samples);
+
+        command stop_command {};
+        stop_command.type = command_type::stop_samples;
+        stop_command.samples = samples;
+
+        // Sounds are destroyed rarely (level change, exit), holding the
+        // callback off for a moment is fine. With the device locked this
+        // thread is the only consumer of the queue. Commands still queued
+        // may refer to the samples, so they go first.
+        if (m_device)
+        {
+            SDL_LockAudioDevice(m_device);
+        }
+
+        execute_commands();
+        execute(stop_command);
+
+        if (m_device)
+        {
+            SDL_UnlockAudioDevice(m_device);
+        }
+    }
+
+    void audio_mixer::set_device(const SDL_AudioDeviceID device)
+    {
+        m_device = device;
+    }
+
+    std::size_t audio_mixer::get_dropped_commands_number() const noexcept
+    {
+        return m_dropped_commands;
+    }
+
+    void audio_mixer::mix(std::uint8_t* stream, const std::size_t length)
+    {
+        execute_commands();
+
+        const std::size_t sample_size = m_format == SDL_AUDIO_F32LSB
+            ? sizeof(float)
+            : sizeof(std::int16_t);
+        const std::size_t frame_size = sample_size * 2;
+
+        std::size_t frames_left = length / frame_size;
+
+        while (frames_left > 0)
+        {
+            const std::size_t frames = std::min(frames_left, m_frames_max);
+
+            std::fill_n(m_mix_buffer.begin(), frames * 2, 0.f);
+
+            for (std::size_t i = 0; i < m_active_voices_number;)
+            {
+                if (!mix_voice(m_voices[m_active_voices[i]], frames))
+                {
+                    // The last active voice takes its place.
+                    remove_active_voice(i);
+                    continue;
+                }
+
+                i++;
+            }
+
+            write_output(stream, frames);
+
+            stream += frames * frame_size;
+            frames_left -= frames;
+        }
+    }
+
+    bool audio_mixer::push(const command& new_command)
+    {
+        if (!m_commands.try_push(new_command))
+        {
+            m_dropped_commands++;
+            return false;
+        }
+
+        return true;
+    }
+
+    void audio_mixer::execute_commands()
+    {
+        command current {};
+
+        while (m_commands.try_pop(current))
+        {
+            execute(current);
+        }
+    }
+
+    void audio_mixer::execute(const command& current)
+    {
+        switch (current.type)
+        {
+        case command_type::play:
+            start_voice(current);
+            break;
+        case command_type::stop_samples:
+            for (std::size_t i = 0; i < m_active_voices_number;)
+            {
+                if (m_voices[m_active_voices[i]].samples == current.samples)
+                {
+                    remove_active_voice(i);
+                    continue;
+                }
+
+                i++;
+            }
+            break;
+        case command_type::stop_voice:
+        {
+            const std::size_t index = find_active_voice(current.voice);
+
+            if (index != voices_max)
+            {
+                remove_active_voice(index);
+            }
+            break;
+        }
+        case command_type::set_gain:
+            for (std::size_t i = 0; i < m_active_voices_number; i++)
+            {
+                voice& playing = m_voices[m_active_voices[i]];
+
+                if (playing.samples == current.samples)
+                {
+                    playing.sound_gain = current.sound_gain;
+                }
+            }
+            break;
+        case command_type::set_voice_parameters:
+        {
+            const std::size_t index = find_active_voice(current.voice);
+
+            if (index != voices_max)
+            {
+                m_voices[m_active_voices[index]].parameters
+                    = current.parameters;
+            }
+            break;
+        }
+        case command_type::set_voice_stealing:
+            m_voice_stealing = current.stealing;
+            break;
+        }
+    }
+
+    void audio_mixer::start_voice(const command& current)
+    {
+        if (current.samples->stream)
+        {
+            command stop_command {};
+            stop_command.type = command_type::stop_samples;
+            stop_command.samples = current.samples;
+            execute(stop_command);
+        }
+
+        if (m_free_voices_number == 0)
+        {
+            const std::size_t stolen = find_voice_to_steal(current.parameters);
+
+            if (stolen == voices_max)
+            {
+                return;
+            }
+
+            remove_active_voice(stolen);
+        }
+
+        const std::uint8_t index = m_free_voices[--m_free_voices_number];
+        m_active_voices[m_active_voices_number++] = index;
+
+        voice& started = m_voices[index];
+        started.samples = current.samples;
+        started.id = current.voice;
+        started.looped = current.looped;
+        started.sound_gain = current.sound_gain;
+        started.parameters = current.parameters;
+        started.position = 0;
+        started.start = m_starts_number++;
+    }
+
+    std::size_t audio_mixer::find_active_voice(const voice_id id) const
+    {
+        for (std::size_t i = 0; i < m_active_voices_number; i++)
+        {
+            if (m_voices[m_active_voices[i]].id == id)
+            {
+                return i;
+            }
+        }
+
+        return voices_max;
+    }
+
+    std::size_t audio_mixer::find_voice_to_steal(
+        const voice_parameters& parameters) const
+    {
+        std::size_t found { voices_max };
+
+        // Returns true if `candidate` should be stolen rather than `best`.
+        auto is_better = [this](const voice& candidate, const voice& best) {
+            switch (m_voice_stealing)
+            {
+            case voice_stealing::quietest:
+                if (candidate.get_gain() != best.get_gain())
+                {
+                    return candidate.get_gain() < best.get_gain();
+                }
+                break;
+            case voice_stealing::priority:
+                if (candidate.parameters.priority != best.parameters.priority)
+                {
+                    return candidate.parameters.priority
+                        < best.parameters.priority;
+                }
+                break;
+            case voice_stealing::oldest:
+                break;
+            }
+
+            return candidate.start < best.start;
+        };
+
+        for (std::size_t i = 0; i < m_active_voices_number; i++)
+        {
+            const voice& candidate = m_voices[m_active_voices[i]];
+
+            if (found == voices_max
+                || is_better(candidate, m_voices[m_active_voices[found]]))
+            {
+                found = i;
+            }
+        }
+
+        if (found != voices_max && m_voice_stealing == voice_stealing::priority
+            && m_voices[m_active_voices[found]].parameters.priority
+                > parameters.priority)
+        {
+            return voices_max;
+        }
+
+        return found;
+    }
+
+    void audio_mixer::remove_active_voice(const std::size_t index)
+    {
+        m_free_voices[m_free_voices_number++] = m_active_voices[index];
+        m_active_voices[index] = m_active_voices[--m_active_voices_number];
+    }
+
+    bool audio_mixer::mix_voice(voice& current, const std::size_t frames)
+    {
+        if (current.samples->stream)
+        {
+            return mix_stream_voice(current, frames);
+        }
+
+        const std::size_t frames_total = current.samples->frames;
+        std::size_t mixed {};
+
+        while (mixed < frames)
+        {
+            if (current.position == frames_total)
+            {
+                if (!current.looped || frames_total == 0)
+                {
+                    return false;
+                }
+
+                current.position = 0;
+            }
+
+            const std::size_t frames_to_mix
+                = std::min(frames - mixed, frames_total - current.position);
+
+            accumulate(current,
+                       *current.samples,
+                       current.position,
+                       frames_to_mix,
+                       m_mix_buffer.data() + mixed * 2);
+
+            current.position += frames_to_mix;
+            mixed += frames_to_mix;
+        }
+
+        return current.looped || current.position < frames_total;
+    }
+
+    bool audio_mixer::mix_stream_voice(voice& current, const std::size_t frames)
+    {
+        audio_stream& stream = *current.samples->stream;
+        std::size_t mixed {};
+
+        while (mixed < frames)
+        {
+            const audio_samples ready = stream.read(frames - mixed);
+
+            if (ready.frames == 0)
+            {
+                // The rest of the voice is silent if the streaming thread
+                // is late.
+                return !stream.has_ended();
+            }
+
+            accumulate(current,
+                       ready,
+                       0,
+                       ready.frames,
+                       m_mix_buffer.data() + mixed * 2);
+
+            stream.consume(ready.frames);
+            mixed += ready.frames;
+        }
+
+        return true;
+    }
+
+    void audio_mixer::accumulate(const voice& current,
+                                 const audio_samples& input,
+                                 const std::size_t first_frame,
+                                 const std::size_t frames,
+                                 float* output) const
+    {
+        if (m_format == SDL_AUDIO_F32LSB)
+        {
+            accumulate<float>(current, input, first_frame, frames, output);
+        }
+        else
+        {
+            accumulate<std::int16_t>(
+                current, input, first_frame, frames, output);
+        }
+    }
+
+    template <typename T>
+    void audio_mixer::accumulate(const voice& current,
+                                 const audio_samples& input,
+                                 const std::size_t first_frame,
+                                 const std::size_t frames,
+                                 float* output) const
+    {
+        constexpr float scale = std::is_same_v<T, float> ? 1.f : 1.f / 32768.f;
+
+        // Balance pan: the center keeps both channels as recorded, the
+        // sides attenuate the other channel down to silence.
+        const float gain = current.get_gain() * scale;
+        const float pan = std::clamp(current.parameters.pan, -1.f, 1.f);
+        const float left = gain * std::min(1.f, 1.f - pan);
+        const float right = gain * std::min(1.f, 1.f + pan);
+
+        const std::size_t channels = input.channels;
+        const T* samples = reinterpret_cast<const T*>(input.data)
+            + first_frame * channels;
+
+        if (channels == 1)
+        {
+            for (std::size_t i = 0; i < frames; i++)
+            {
+                const float sample = static_cast<float>(samples[i]);
+                output[i * 2] += sample * left;
+                output[i * 2 + 1] += sample * right;
+            }
+        }
+        else
+        {
+            for (std::size_t i = 0; i < frames; i++)
+            {
+                output[i * 2] += static_cast<float>(samples[i * 2]) * left;
+                output[i * 2 + 1]
+                    += static_cast<float>(samples[i * 2 + 1]) * right;
+            }
+        }
+    }
+
+    void audio_mixer::write_output(std::uint8_t* stream,
+                                   const std::size_t frames) const
+    {
+        const std::size_t samples_number = frames * 2;
+
+        if (m_format == SDL_AUDIO_F32LSB)
+        {
+            float* output = reinterpret_cast<float*>(stream);
+
+            for (std::size_t i = 0; i < samples_number; i++)
+            {
+                output[i] = std::clamp(m_mix_buffer[i], -1.f, 1.f);
+            }
+        }
+        else
+        {
+            std::int16_t* output = reinterpret_cast<std::int16_t*>(stream);
+
+            for (std::size_t i = 0; i < samples_number; i++)
+            {
+                output[i] = static_cast<std::int16_t>(std::lrint(
+                    std::clamp(m_mix_buffer[i], -1.f, 1.f) * 32767.f));
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,508 @@
+#include "audio-stream.hxx"
+#include "asset-pack.hxx"
+
+#include "helper.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // The streaming thread checks the ring buffer that often, and fills
+    // it once a quarter of it is free. The audio callback consumes about
+    // 85 ms (4096 frames) at once.
+    constexpr std::chrono::milliseconds stream_check_interval { 20 };
+    constexpr std::size_t stream_fill_frames_min { audio_stream::ring_frames
+                                                   / 4 };
+    // Frames of the source read at once.
+    constexpr std::size_t stream_chunk_frames { 4096 };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    class wav_source final : public audio_source
+    {
+    public:
+        explicit wav_source(SDL_RWops* rwop)
+            : m_rwop { rwop }
+        {
+        }
+
+        ~wav_source()
+        {
+            CHECK(!m_rwop->close(m_rwop));
+        }
+
+        wav_source(const wav_source&) = delete;
+        wav_source(wav_source&&) = delete;
+        wav_source& operator=(const wav_source&) = delete;
+        wav_source& operator=(wav_source&&) = delete;
+
+        // Finds the format and the data chunks, returns false if the
+        // file is not a WAVE file of a supported encoding.
+        bool read_header();
+
+        std::size_t read(std::uint8_t* data, const std::size_t size) override
+        {
+            std::size_t bytes = std::min(size, m_data_size - m_position);
+            bytes -= bytes % m_block_align;
+
+            if (bytes == 0)
+            {
+                return 0;
+            }
+
+            const Sint64 bytes_read = m_rwop->read(m_rwop, data, bytes);
+
+            if (bytes_read <= 0)
+            {
+                return 0;
+            }
+
+            // A truncated file ends with a partial frame.
+            const std::size_t whole_bytes = static_cast<std::size_t>(bytes_read)
+                - static_cast<std::size_t>(bytes_read) % m_block_align;
+            m_position += whole_bytes;
+
+            return whole_bytes;
+        }
+
+        void rewind() override
+        {
+            CHECK(m_rwop->seek(m_rwop, m_data_offset, SDL_RW_SEEK_SET) != -1);
+            m_position = 0;
+        }
+
+        std::size_t get_size() const override
+        {
+            return m_data_size;
+        }
+
+    private:
+        bool read_bytes(void* data, const std::size_t size)
+        {
+            return m_rwop->read(m_rwop, data, size)
+                == static_cast<Sint64>(size);
+        }
+
+        SDL_RWops* m_rwop { nullptr };
+        Sint64 m_data_offset {};
+        std::size_t m_data_size {};
+        std::size_t m_block_align { 1 };
+        std::size_t m_position {};
+    };
+
+    // WAVE data is little-endian, as all platforms we run on.
+    template <typename T>
+    static T get_value(const std::uint8_t* bytes)
+    {
+        T value {};
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    static SDL_AudioFormat get_wav_format(const std::uint16_t encoding,
+                                          const std::uint16_t bits)
+    {
+        constexpr std::uint16_t pcm { 1 };
+        constexpr std::uint16_t ieee_float { 3 };
+
+        if (encoding == pcm)
+        {
+            switch (bits)
+            {
+            case 8:
+                return SDL_AUDIO_U8;
+            case 16:
+                return SDL_AUDIO_S16LSB;
+            case 32:
+                return SDL_AUDIO_S32LSB;
+            }
+        }
+        else if (encoding == ieee_float && bits == 32)
+        {
+            return SDL_AUDIO_F32LSB;
+        }
+
+        return 0;
+    }
+
+    bool wav_source::read_header()
+    {
+        std::uint8_t riff[12] {};
+
+        if (!read_bytes(riff, sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0
+            || std::memcmp(riff + 8, "WAVE", 4) != 0)
+        {
+            return false;
+        }
+
+        bool format_found { false };
+
+        for (;;)
+        {
+            std::uint8_t chunk[8] {};
+
+            if (!read_bytes(chunk, sizeof(chunk)))
+            {
+                return false;
+            }
+
+            const std::uint32_t chunk_size = get_value<std::uint32_t>(chunk + 4);
+
+            if (std::memcmp(chunk, "fmt ", 4) == 0)
+            {
+                // WAVEFORMATEXTENSIBLE is 40 bytes, the rest is skipped.
+                std::uint8_t fmt[40] {};
+                const std::uint32_t fmt_size
+                    = std::min<std::uint32_t>(chunk_size, sizeof(fmt));
+
+                if (fmt_size < 16 || !read_bytes(fmt, fmt_size))
+                {
+                    return false;
+                }
+
+                const Sint64 rest = chunk_size - fmt_size + (chunk_size & 1);
+
+                if (rest && m_rwop->seek(m_rwop, rest, SDL_RW_SEEK_CUR) == -1)
+                {
+                    return false;
+                }
+
+                std::uint16_t encoding = get_value<std::uint16_t>(fmt);
+                const std::uint16_t fmt_channels
+                    = get_value<std::uint16_t>(fmt + 2);
+                const std::uint16_t block_align
+                    = get_value<std::uint16_t>(fmt + 12);
+                const std::uint16_t bits = get_value<std::uint16_t>(fmt + 14);
+
+                constexpr std::uint16_t extensible { 0xFFFE };
+
+                if (encoding == extensible && fmt_size == sizeof(fmt))
+                {
+                    // The first two bytes of the subformat GUID.
+                    encoding = get_value<std::uint16_t>(fmt + 24);
+                }
+
+                format = get_wav_format(encoding, bits);
+                channels = static_cast<std::uint8_t>(fmt_channels);
+                freq = static_cast<int>(get_value<std::uint32_t>(fmt + 4));
+                m_block_align = block_align;
+
+                if (!format || fmt_channels == 0 || fmt_channels > 8
+                    || freq <= 0 || block_align != bits / 8 * fmt_channels)
+                {
+                    return false;
+                }
+
+                format_found = true;
+            }
+            else if (std::memcmp(chunk, "data", 4) == 0)
+            {
+                if (!format_found)
+                {
+                    return false;
+                }
+
+                m_data_offset = m_rwop->seek(m_rwop, 0, SDL_RW_SEEK_CUR);
+                const Sint64 file_size = m_rwop->size(m_rwop);
+
+                if (m_data_offset == -1 || file_size < m_data_offset)
+                {
+                    return false;
+                }
+
+                // Streaming encoders may leave the size unset.
+                m_data_size = std::min<std::size_t>(
+                    chunk_size,
+                    static_cast<std::size_t>(file_size - m_data_offset));
+                m_data_size -= m_data_size % m_block_align;
+
+                return true;
+            }
+            else if (m_rwop->seek(
+                         m_rwop, chunk_size + (chunk_size & 1), SDL_RW_SEEK_CUR)
+                     == -1)
+            {
+                return false;
+            }
+        }
+    }
+
+    std::unique_ptr<audio_source> open_wav_source(const std::string_view path)
+    {
+        const asset_span asset = find_asset(path);
+
+        SDL_RWops* rwop = asset.empty()
+            ? SDL_RWFromFile(std::string { path }.c_str(), "rb")
+            : SDL_RWFromConstMem(asset.data, asset.size);
+
+        if (!rwop)
+        {
+            return nullptr;
+        }
+
+        auto source = std::make_unique<wav_source>(rwop);
+
+        if (!source->read_header())
+        {
+            return nullptr;
+        }
+
+        return source;
+    }
+
+    std::unique_ptr<audio_source> open_audio_source(const std::string_view path)
+    {
+        const std::string stem { path.substr(0, path.rfind('.')) };
+
+        if (std::unique_ptr<audio_source> source = open_qoa_source(stem + ".qoa"))
+        {
+            return source;
+        }
+
+        return open_wav_source(path);
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    audio_stream::audio_stream(std::unique_ptr<audio_source> source,
+                               const SDL_AudioFormat format,
+                               const int freq)
+        : m_source { std::move(source) }
+    {
+        CHECK_NOTNULL(m_source.get());
+
+        m_channels = std::min<std::uint8_t>(m_source->channels, 2);
+        m_frame_size = SDL_AUDIO_BITSIZE(format) / 8 * m_channels;
+
+        m_converter = SDL_CreateAudioStream(m_source->format,
+                                            m_source->channels,
+                                            m_source->freq,
+                                            format,
+                                            m_channels,
+                                            freq);
+        CHECK_NOTNULL(m_converter);
+
+        m_chunk.resize(stream_chunk_frames * SDL_AUDIO_BITSIZE(m_source->format)
+                       / 8 * m_source->channels);
+        m_ring.resize(ring_frames * m_frame_size);
+
+        m_thread = std::thread { [this] { run(); } };
+    }
+
+    audio_stream::~audio_stream()
+    {
+        stop();
+        SDL_DestroyAudioStream(m_converter);
+    }
+
+    void audio_stream::stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock { m_mutex };
+            m_stopping = true;
+        }
+
+        m_wake.notify_one();
+
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+    }
+
+    void audio_stream::start(const bool looped)
+    {
+        {
+            std::lock_guard<std::mutex> lock { m_mutex };
+            m_requested_looped.store(looped, std::memory_order_relaxed);
+            m_requested_start.fetch_add(1, std::memory_order_release);
+        }
+
+        m_wake.notify_one();
+    }
+
+    audio_samples audio_stream::read(const std::size_t frames_max)
+    {
+        const std::uint32_t ready_start
+            = m_ready_start.load(std::memory_order_acquire);
+
+        if (ready_start != m_requested_start.load(std::memory_order_acquire))
+        {
+            // Frames of the new start are not there yet.
+            return {};
+        }
+
+        if (ready_start != m_consumed_start)
+        {
+            // Skip what is left of the previous start.
+            m_head.store(m_ready_head.load(std::memory_order_relaxed),
+                         std::memory_order_release);
+            m_consumed_start = ready_start;
+        }
+
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        const std::size_t tail = m_tail.load(std::memory_order_acquire);
+        const std::size_t offset = head & (ring_frames - 1);
+        const std::size_t frames
+            = std::min({ tail - head, ring_frames - offset, frames_max });
+
+        return { m_ring.data() + offset * m_frame_size, frames, m_channels };
+    }
+
+    void audio_stream::consume(const std::size_t frames)
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + frames,
+                     std::memory_order_release);
+    }
+
+    bool audio_stream::has_ended() const
+    {
+        return m_requested_start.load(std::memory_order_acquire)
+            == m_consumed_start
+            && m_ended_start.load(std::memory_order_acquire) == m_consumed_start
+            && m_head.load(std::memory_order_relaxed)
+            == m_tail.load(std::memory_order_acquire);
+    }
+
+    std::uint8_t audio_stream::get_channels() const noexcept
+    {
+        return m_channels;
+    }
+
+    std::size_t audio_stream::get_memory_size() const noexcept
+    {
+        return m_ring.size() + m_chunk.size();
+    }
+
+    void audio_stream::run()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        while (!m_stopping)
+        {
+            lock.unlock();
+            const bool produced = produce();
+            lock.lock();
+
+            if (!produced)
+            {
+                m_wake.wait_for(lock, stream_check_interval, [this] {
+                    return m_stopping
+                        || m_requested_start.load(std::memory_order_relaxed)
+                        != m_current_start;
+                });
+            }
+        }
+    }
+
+    bool audio_stream::produce()
+    {
+        const std::uint32_t requested
+            = m_requested_start.load(std::memory_order_acquire);
+
+        if (requested != m_current_start)
+        {
+            m_source->rewind();
+            SDL_ClearAudioStream(m_converter);
+
+            m_current_start = requested;
+            m_looped = m_requested_looped.load(std::memory_order_relaxed);
+            m_flushed = false;
+            m_drained = false;
+
+            // The mixer skips frames written before.
+            m_ready_head.store(m_tail.load(std::memory_order_relaxed),
+                               std::memory_order_relaxed);
+            m_ready_start.store(requested, std::memory_order_release);
+        }
+
+        if (m_current_start == 0 || m_drained)
+        {
+            return false;
+        }
+
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        const std::size_t free_frames
+            = ring_frames - (tail - m_head.load(std::memory_order_acquire));
+
+        if (free_frames < stream_fill_frames_min)
+        {
+            return false;
+        }
+
+        const std::size_t available_frames
+            = static_cast<std::size_t>(SDL_GetAudioStreamAvailable(m_converter))
+            / m_frame_size;
+
+        if (available_frames == 0)
+        {
+            if (!feed_converter())
+            {
+                m_drained = true;
+                m_ended_start.store(m_current_start, std::memory_order_release);
+                return false;
+            }
+
+            return true;
+        }
+
+        const std::size_t offset = tail & (ring_frames - 1);
+        const std::size_t frames = std::min(
+            { available_frames, free_frames, ring_frames - offset });
+
+        const int bytes
+            = SDL_GetAudioStreamData(m_converter,
+                                     m_ring.data() + offset * m_frame_size,
+                                     static_cast<int>(frames * m_frame_size));
+        CHECK(bytes >= 0);
+
+        m_tail.store(tail + static_cast<std::size_t>(bytes) / m_frame_size,
+                     std::memory_order_release);
+
+        return true;
+    }
+
+    bool audio_stream::feed_converter()
+    {
+        const std::size_t bytes = m_source->read(m_chunk.data(), m_chunk.size());
+
+        if (bytes > 0)
+        {
+            CHECK(SDL_PutAudioStreamData(
+                      m_converter, m_chunk.data(), static_cast<int>(bytes))
+                  == 0);
+            return true;
+        }
+
+        if (m_looped && m_source->get_size() > 0)
+        {
+            // The converter keeps its state, so the loop point is as
+            // smooth as the track itself.
+            m_source->rewind();
+            return true;
+        }
+
+        if (!m_flushed)
+        {
+            // Frames the resampler holds back waiting for more input.
+            CHECK(SDL_FlushAudioStream(m_converter) == 0);
+            m_flushed = true;
+            return true;
+        }
+
+        return false;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,35 @@
+#include "embedded-assets.hxx"
+
+// Generated by the `embedded_assets` target, see res/CMakeLists.txt.
+#include "embedded-asset-data.hxx"
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    asset_span find_embedded_asset(const std::string_view name)
+    {
+        // Only a few files are embedded, no need for an index.
+        const auto it = std::find_if(
+            embedded_assets.begin(),
+            embedded_assets.end(),
+            [name](const embedded_asset& asset) { return asset.name == name; });
+
+        if (it == embedded_assets.end())
+        {
+            return {};
+        }
+
+        return { it->data, it->size };
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -1,8 +1,25 @@
 #include "engine.hxx"
+#include "asset-pack.hxx"
+#include "audio-mixer.hxx"
+#include "audio-stream.hxx"
 #include "glad/glad.h"
 
+#include "ktx-image.hxx"
+#include "null-engine.hxx"
 #include "opengl-debug.hxx"
+#include "opengl-gpu-profiler.hxx"
+#include "opengl-program-cache.hxx"
 #include "opengl-shader-programm.hxx"
+#include "opengl-shader-variants.hxx"
+#include "opengl-state-cache.hxx"
+#include "opengl-stream-buffer.hxx"
+#include "opengl-uniform-buffer.hxx"
+#include "opengl-upload-queue.hxx"
+#include "render-queue.hxx"
+#include "render-thread.hxx"
+#include "worker-pool.hxx"
+
+#include "helper.hxx"
 
 //
 #include <SDL3/SDL.h>
@@ -24,8 +41,11 @@
 //
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <cstddef>
 #include <filesystem>
 #include <fstream>
 #include <memory>
@@ -33,6 +53,8 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <variant>
 #include <vector>
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -53,7 +75,7 @@ namespace arci
 
     ///////////////////////////////////////////////////////////////////////////////
 
-    const std::array<bind_key, 8> keys {
+    const std::array<bind_key, 9> keys {
         bind_key {
             "left",
             SDLK_LEFT,
@@ -110,6 +132,13 @@ namespace arci
             key_event::escape_button_released,
             keys::exit,
         },
+        bind_key {
+            "f3",
+            SDLK_F3,
+            key_event::profiler_button_pressed,
+            key_event::profiler_button_released,
+            keys::profiler,
+        },
     };
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -123,64 +152,140 @@ namespace arci
 
     ///////////////////////////////////////////////////////////////////////////////
 
-    class vertex_buffer final : public ivertex_buffer
+    sprite_vertex make_sprite_vertex(const float x,
+                                     const float y,
+                                     const float tx,
+                                     const float ty,
+                                     const float r,
+                                     const float g,
+                                     const float b,
+                                     const float a)
     {
-    public:
-        vertex_buffer(const std::vector<triangle>& triangles)
-        {
-            m_num_vertices = triangles.size() * 3;
+        auto to_uint16 = [](const float value) {
+            return static_cast<std::uint16_t>(
+                std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
+        };
 
-            glGenVertexArrays(1, &m_vao_id);
-            opengl_check();
-            glGenBuffers(1, &m_vbo_id);
-            opengl_check();
+        auto to_uint8 = [](const float value) {
+            return static_cast<std::uint8_t>(
+                std::lround(std::clamp(value, 0.f, 1.f) * 255.f));
+        };
 
-            bind();
+        return sprite_vertex {
+            x,
+            y,
+            to_uint16(tx),
+            to_uint16(ty),
+            to_uint8(r),
+            to_uint8(g),
+            to_uint8(b),
+            to_uint8(a),
+        };
+    }
 
-            glBufferData(
-                GL_ARRAY_BUFFER,
-                triangles.size() * 3 * sizeof(vertex),
-                triangles.data()->vertices.data(),
-                GL_STATIC_DRAW);
-            opengl_check();
-        }
+    const vertex_layout& get_vertex_layout()
+    {
+        static const vertex_layout layout {
+            {
+                { 0, 3, attribute_type::float32, false, offsetof(vertex, x) },
+                { 1, 4, attribute_type::float32, false, offsetof(vertex, r) },
+                { 2, 2, attribute_type::float32, false, offsetof(vertex, tx) },
+            },
+            sizeof(vertex),
+        };
+
+        return layout;
+    }
+
+    const vertex_layout& get_sprite_vertex_layout()
+    {
+        static const vertex_layout layout {
+            {
+                { 0, 2, attribute_type::float32, false, offsetof(sprite_vertex, x) },
+                { 1, 4, attribute_type::uint8, true, offsetof(sprite_vertex, r) },
+                { 2, 2, attribute_type::uint16, true, offsetof(sprite_vertex, tx) },
+            },
+            sizeof(sprite_vertex),
+        };
+
+        return layout;
+    }
 
-        vertex_buffer(const std::vector<vertex>& vertices)
+    static GLenum to_gl_type(const attribute_type type)
+    {
+        switch (type)
         {
-            m_num_vertices = vertices.size();
+        case attribute_type::float32:
+            return GL_FLOAT;
+        case attribute_type::uint16:
+            return GL_UNSIGNED_SHORT;
+        case attribute_type::uint8:
+            return GL_UNSIGNED_BYTE;
+        }
 
-            glGenVertexArrays(1, &m_vao_id);
+        CHECK(false);
+        return GL_FLOAT;
+    }
+
+    // Attribute pointers refer to the buffer bound to GL_ARRAY_BUFFER
+    // and are stored in the currently bound VAO.
+    static void set_vertex_attributes(const vertex_layout& layout)
+    {
+        for (const vertex_attribute& attribute : layout.attributes)
+        {
+            glEnableVertexAttribArray(attribute.location);
             opengl_check();
-            glGenBuffers(1, &m_vbo_id);
+
+            glVertexAttribPointer(
+                attribute.location,
+                attribute.components,
+                to_gl_type(attribute.type),
+                attribute.normalized ? GL_TRUE : GL_FALSE,
+                layout.stride,
+                reinterpret_cast<void*>(attribute.offset));
             opengl_check();
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
 
-            bind();
+    // GL objects of buffers and textures are created, updated and
+    // deleted by commands executed on the render thread.
+    class vertex_buffer final : public ivertex_buffer
+    {
+    public:
+        vertex_buffer(render_thread& renderer,
+                      opengl_state_cache& state_cache,
+                      const void* vertices,
+                      const std::size_t vertices_number,
+                      const vertex_layout& layout)
+            : m_render_thread { renderer }
+            , m_state_cache { state_cache }
+        {
+            m_num_vertices = vertices_number;
+            m_stride = layout.stride;
 
-            glBufferData(GL_ARRAY_BUFFER,
-                         m_num_vertices * sizeof(vertex),
-                         vertices.data(),
-                         GL_STATIC_DRAW);
-            opengl_check();
+            const auto* bytes = static_cast<const unsigned char*>(vertices);
+            std::vector<unsigned char> data(bytes,
+                                            bytes + m_num_vertices * m_stride);
+
+            m_render_thread.record(
+                [this, data = std::move(data), layout] {
+                    create(data.data(), layout);
+                });
         }
 
         ~vertex_buffer()
         {
-            glBindVertexArray(0);
-            opengl_check();
-            glDeleteVertexArrays(1, &m_vao_id);
-            opengl_check();
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-            opengl_check();
-            glDeleteBuffers(1, &m_vbo_id);
-            opengl_check();
+            m_state_cache.delete_vertex_array(m_vao_id);
+            m_state_cache.delete_buffer(m_vbo_id);
         }
 
+        // Attribute pointers are stored in the VAO, so binding the VAO
+        // is all we need for drawing.
         void bind() override
         {
-            glBindVertexArray(m_vao_id);
-            opengl_check();
-            glBindBuffer(GL_ARRAY_BUFFER, m_vbo_id);
-            opengl_check();
+            m_state_cache.bind_vertex_array(m_vao_id);
         }
 
         std::size_t get_vertices_number() const override
@@ -188,10 +293,53 @@ namespace arci
             return m_num_vertices;
         }
 
+        void update(const std::size_t first_vertex,
+                    const void* vertices,
+                    const std::size_t vertices_number) override
+        {
+            CHECK(first_vertex + vertices_number <= m_num_vertices);
+
+            const auto* bytes = static_cast<const unsigned char*>(vertices);
+            std::vector<unsigned char> data(bytes,
+                                            bytes + vertices_number * m_stride);
+
+            m_render_thread.record([this, first_vertex, data = std::move(data)] {
+                m_state_cache.bind_buffer(GL_ARRAY_BUFFER, m_vbo_id);
+
+                glBufferSubData(GL_ARRAY_BUFFER,
+                                first_vertex * m_stride,
+                                data.size(),
+                                data.data());
+                opengl_check();
+            });
+        }
+
     private:
+        void create(const void* vertices, const vertex_layout& layout)
+        {
+            glGenVertexArrays(1, &m_vao_id);
+            opengl_check();
+            glGenBuffers(1, &m_vbo_id);
+            opengl_check();
+
+            m_state_cache.bind_vertex_array(m_vao_id);
+            m_state_cache.bind_buffer(GL_ARRAY_BUFFER, m_vbo_id);
+
+            glBufferData(GL_ARRAY_BUFFER,
+                         m_num_vertices * layout.stride,
+                         vertices,
+                         GL_STATIC_DRAW);
+            opengl_check();
+
+            set_vertex_attributes(layout);
+        }
+
+        render_thread& m_render_thread;
+        opengl_state_cache& m_state_cache;
         GLuint m_vbo_id {};
         GLuint m_vao_id {};
         std::size_t m_num_vertices {};
+        std::size_t m_stride {};
     };
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -199,37 +347,40 @@ namespace arci
     class index_buffer : public i_index_buffer
     {
     public:
-        index_buffer(const std::vector<uint32_t>& indices)
+        index_buffer(render_thread& renderer,
+                     opengl_state_cache& state_cache,
+                     const std::vector<uint32_t>& indices)
+            : m_state_cache { state_cache }
         {
             m_num_indices = indices.size();
 
             m_indices.resize(m_num_indices);
             std::copy(indices.begin(), indices.end(), m_indices.begin());
 
-            glGenBuffers(1, &m_ebo_id);
-            opengl_check();
+            // `m_indices` are never changed, so they can be read by
+            // the render thread.
+            renderer.record([this] {
+                glGenBuffers(1, &m_ebo_id);
+                opengl_check();
 
-            bind();
+                bind();
 
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                         m_num_indices * sizeof(uint32_t),
-                         indices.data(),
-                         GL_STATIC_DRAW);
-            opengl_check();
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                             m_num_indices * sizeof(uint32_t),
+                             m_indices.data(),
+                             GL_STATIC_DRAW);
+                opengl_check();
+            });
         }
 
         ~index_buffer()
         {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-            opengl_check();
-            glDeleteBuffers(1, &m_ebo_id);
-            opengl_check();
+            m_state_cache.delete_buffer(m_ebo_id);
         }
 
         void bind() override
         {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo_id);
-            opengl_check();
+            m_state_cache.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo_id);
         }
 
         uint32_t* data() override
@@ -243,6 +394,7 @@ namespace arci
         }
 
     private:
+        opengl_state_cache& m_state_cache;
         std::vector<uint32_t> m_indices {};
         GLuint m_ebo_id {};
         std::size_t m_num_indices {};
@@ -250,24 +402,92 @@ namespace arci
 
     ///////////////////////////////////////////////////////////////////////////////
 
+    struct texture_image;
+
+    // Link between a texture and its asynchronous load. The texture clears
+    // it when destroyed, so an upload arriving after that is dropped. Used
+    // on the GL thread only.
+    template <typename texture_type>
+    struct pending_texture_load
+    {
+        texture_type* texture { nullptr };
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
     class opengl_texture : public itexture
     {
     public:
+        // `texture_bytes` is the total size of all textures.
+        opengl_texture(opengl_state_cache& state_cache,
+                       std::size_t& texture_bytes)
+            : m_state_cache { state_cache }
+            , m_texture_bytes { texture_bytes }
+        {
+        }
+
+        ~opengl_texture()
+        {
+            if (m_pending_load)
+            {
+                m_pending_load->texture = nullptr;
+            }
+
+            m_state_cache.delete_texture(m_texture_id);
+            m_texture_bytes -= m_bytes;
+        }
+
         void bind() override
         {
             CHECK(m_texture_id);
-            glBindTexture(GL_TEXTURE_2D, m_texture_id);
-            opengl_check();
+            m_state_cache.bind_texture(0, GL_TEXTURE_2D, m_texture_id);
         }
 
+        // Decode and upload right away.
         void load(const std::string_view path) override;
 
+        // Fully transparent 1x1 image shown until the real one is uploaded.
+        // Does nothing if the image is already uploaded.
+        void create_placeholder();
+
+        // Texture id is kept if the texture exists already.
+        void upload(const texture_image& image);
+
+        void set_pending_load(
+            std::shared_ptr<pending_texture_load<opengl_texture>> load)
+        {
+            m_pending_load = std::move(load);
+        }
+
+        std::size_t get_memory_size() const override
+        {
+            return m_bytes;
+        }
+
         std::pair<unsigned long, unsigned long> get_texture_size() const
         {
             return { m_texture_width, m_texture_height };
         }
 
+        GLuint get_texture_id() const noexcept
+        {
+            return m_texture_id;
+        }
+
     private:
+        void create_texture_object();
+        void upload_pixels(const unsigned char* pixels,
+                           const int width,
+                           const int height);
+        void upload_ktx(const ktx_image& image);
+        void set_levels(const std::size_t levels_number,
+                        const std::size_t bytes);
+
+        opengl_state_cache& m_state_cache;
+        std::size_t& m_texture_bytes;
+        // Read by the game thread.
+        std::atomic<std::size_t> m_bytes {};
+        std::shared_ptr<pending_texture_load<opengl_texture>> m_pending_load {};
         GLuint m_texture_id {};
         unsigned long m_texture_width {};
         unsigned long m_texture_height {};
@@ -275,216 +495,1182 @@ namespace arci
 
     ///////////////////////////////////////////////////////////////////////////////
 
-    static std::mutex audio_mutex {};
-
-    struct audio_buffer : public iaudio_buffer
+    class opengl_texture_array : public itexture_array
     {
-        Uint8* buffer { nullptr };
-        Uint32 size {};
-        std::size_t current_position {};
-        running_mode mode { running_mode::once };
-        bool is_running { false };
-
-        audio_buffer(const std::string_view audio_file_name,
-                     const SDL_AudioSpec& desired_audio_spec);
-
-        ~audio_buffer()
+    public:
+        // Number of layers is known before the images are loaded.
+        // `texture_bytes` is the total size of all textures.
+        opengl_texture_array(opengl_state_cache& state_cache,
+                             std::size_t& texture_bytes,
+                             const std::size_t layers_number)
+            : m_state_cache { state_cache }
+            , m_texture_bytes { texture_bytes }
+            , m_layers_number { layers_number }
         {
-            SDL_free(buffer);
         }
 
-        void play(const running_mode mode) override
+        ~opengl_texture_array()
         {
-            std::lock_guard<std::mutex> lock { audio_mutex };
-            current_position = 0;
-            is_running = true;
-            this->mode = mode;
-        }
-    };
-
-    ///////////////////////////////////////////////////////////////////////////////
+            if (m_pending_load)
+            {
+                m_pending_load->texture = nullptr;
+            }
 
-    class engine_using_sdl final : public iengine
-    {
-    public:
-        engine_using_sdl() = default;
+            m_state_cache.delete_texture(m_texture_id);
+            m_texture_bytes -= m_bytes;
+        }
 
-        engine_using_sdl(const engine_using_sdl&) = delete;
+        void bind() override
+        {
+            CHECK(m_texture_id);
+            m_state_cache.bind_texture(0, GL_TEXTURE_2D_ARRAY, m_texture_id);
+        }
 
-        engine_using_sdl(engine_using_sdl&&) = delete;
+        // Decode and upload right away.
+        void load(const std::vector<std::string_view>& paths) override;
 
-        engine_using_sdl& operator=(const engine_using_sdl&) = delete;
+        // Every layer is a fully transparent 1x1 image until the real
+        // images are uploaded. Does nothing if they are uploaded already.
+        void create_placeholder();
 
-        engine_using_sdl& operator=(engine_using_sdl&&) = delete;
+        // Image of every layer, see load_texture_images().
+        void upload(const std::vector<texture_image>& layers);
 
-        void init() override;
+        void set_pending_load(
+            std::shared_ptr<pending_texture_load<opengl_texture_array>> load)
+        {
+            m_pending_load = std::move(load);
+        }
 
-        bool process_input(event& event) override;
+        std::size_t get_layers_number() const override
+        {
+            return m_layers_number;
+        }
 
-        bool key_down(const enum keys key) override;
+        std::size_t get_memory_size() const override
+        {
+            return m_bytes;
+        }
 
-        void imgui_new_frame() override;
+        GLuint get_texture_id() const noexcept
+        {
+            return m_texture_id;
+        }
 
-        void imgui_render() override;
+    private:
+        void create_texture_object();
+        // All layers have the same size.
+        void upload_pixels(const std::vector<const unsigned char*>& layers,
+                           const int width,
+                           const int height);
+        void upload_ktx(const std::vector<texture_image>& layers);
+        void set_levels(const std::size_t levels_number,
+                        const std::size_t bytes);
+
+        opengl_state_cache& m_state_cache;
+        std::size_t& m_texture_bytes;
+        // Read by the game thread.
+        std::atomic<std::size_t> m_bytes {};
+        std::shared_ptr<pending_texture_load<opengl_texture_array>>
+            m_pending_load {};
+        GLuint m_texture_id {};
+        unsigned long m_texture_width {};
+        unsigned long m_texture_height {};
+        std::size_t m_layers_number {};
+    };
 
-        void render(ivertex_buffer* vertex_buffer,
-                    i_index_buffer* ebo,
-                    itexture* const texture,
-                    const glm::mediump_mat3& matrix) override;
+    ///////////////////////////////////////////////////////////////////////////////
 
-        void render(ivertex_buffer* vertex_buffer,
-                    i_index_buffer* ebo,
-                    itexture* const texture) override;
+    using decoded_image = std::unique_ptr<unsigned char, void (*)(void*)>;
 
-        itexture* create_texture(const std::string_view path) override;
+    // Returns false if the file can't be opened.
+    static bool read_file(const std::string_view path,
+                          std::vector<std::uint8_t>& content)
+    {
+        SDL_RWops* rwop = SDL_RWFromFile(std::string { path }.c_str(), "rb");
 
-        void destroy_texture(const itexture* const texture) override;
+        if (!rwop)
+        {
+            return false;
+        }
 
-        ivertex_buffer* create_vertex_buffer(
-            const std::vector<triangle>& triangles) override;
+        const auto bytes_to_read = rwop->size(rwop);
 
-        ivertex_buffer* create_vertex_buffer(
-            const std::vector<vertex>& vertices) override;
+        CHECK(bytes_to_read != -1);
 
-        void destroy_vertex_buffer(ivertex_buffer* buffer) override;
+        content.resize(bytes_to_read);
 
-        i_index_buffer* create_ebo(
-            const std::vector<uint32_t>& indices) override;
+        const auto bytes_read = rwop->read(rwop, content.data(), bytes_to_read);
 
-        void destroy_ebo(i_index_buffer* buffer) override;
+        CHECK(bytes_read == bytes_to_read);
 
-        iaudio_buffer* create_audio_buffer(
-            const std::string_view audio_file_name) override;
+        CHECK(!rwop->close(rwop));
 
-        void destroy_audio_buffer(iaudio_buffer* buffer) override;
+        return true;
+    }
 
-        void swap_buffers() override;
+    // Decode the image file (straight from the binary or the asset pack
+    // if it is there) to RGBA pixels.
+    static decoded_image decode_image(const std::string_view path,
+                                      int& width,
+                                      int& height)
+    {
+        std::vector<std::uint8_t> raw_png_image {};
+        asset_span image_file = find_asset(path);
 
-        void uninit() override;
+        if (image_file.empty())
+        {
+            if (!read_file(path, raw_png_image))
+            {
+                std::ostringstream error_on_opening {};
+                error_on_opening << "Error on opening " << path << "\n";
+                print_ostream_msg_and_exit(error_on_opening);
+            }
 
-        void imgui_uninit() override;
+            image_file = { raw_png_image.data(), raw_png_image.size() };
+        }
 
-        std::pair<size_t, size_t>
-        get_screen_resolution() const noexcept override;
+        int components {}, required_comps { 4 };
 
-        std::uint64_t get_time_since_epoch() const;
+        // Images are decoded by worker threads as well.
+        stbi_set_flip_vertically_on_load_thread(true);
 
-        static void sdl_audio_callback(void* userdata, Uint8* stream, int len);
+        unsigned char* raw_pixels_after_decoding
+            = stbi_load_from_memory(image_file.data,
+                                    static_cast<int>(image_file.size),
+                                    &width,
+                                    &height,
+                                    &components,
+                                    required_comps);
 
-    private:
-        std::optional<bind_key> get_key_for_event(
-            const SDL_Event& sdl_event);
+        CHECK_NOTNULL(raw_pixels_after_decoding);
 
-        std::unique_ptr<SDL_Window, void (*)(SDL_Window*)>
-            m_window { nullptr, nullptr };
+        return decoded_image { raw_pixels_after_decoding, stbi_image_free };
+    }
 
-        std::unique_ptr<void, int (*)(SDL_GLContext)>
-            m_opengl_context { nullptr, nullptr };
+    // Compressed formats textures may be loaded in. Set once by the
+    // render thread before any texture is created.
+    struct texture_format_support
+    {
+        bool ktx {};
+        bool astc {};
+    };
 
-        opengl_shader_program m_textured_triangle_program {};
-        opengl_shader_program m_tex_no_math_program {};
+    static texture_format_support supported_texture_formats {};
 
-        // Desired audio spec for all sounds.
-        std::vector<audio_buffer*> m_sounds {};
-        SDL_AudioSpec m_desired_audio_spec {};
-        SDL_AudioDeviceID m_audio_device_id {};
+    // Image of a texture prepared by a worker thread: KTX file with its
+    // mip chain if there is one in a format the GPU supports, RGBA pixels
+    // of the original image otherwise.
+    struct texture_image
+    {
+        ktx_image ktx {};
+        decoded_image pixels { nullptr, stbi_image_free };
+        int width {};
+        int height {};
 
-        std::size_t m_screen_width {};
-        std::size_t m_screen_height {};
-        GLuint m_vbo {};
-        GLuint m_vao {};
+        bool is_ktx() const noexcept
+        {
+            return !ktx.levels.empty();
+        }
     };
 
-    void opengl_texture::load(const std::string_view path)
+    // Compressed versions of `res/name.png` are `res/name.astc.ktx2` and
+    // `res/name.etc2.ktx2` (or `.ktx` for KTX 1.1), see res/CMakeLists.txt.
+    // ASTC is preferred when it is supported, ETC2 is always there in
+    // GL ES 3.x.
+    static bool load_ktx_image(const std::string_view path, ktx_image& image)
     {
-        std::vector<unsigned char> raw_png_image {};
+        if (!supported_texture_formats.ktx)
+        {
+            return false;
+        }
 
-        SDL_RWops* rwop = SDL_RWFromFile(path.data(), "rb");
+        const std::string stem { path.substr(0, path.rfind('.')) };
 
-        std::ostringstream error_on_opening {};
-        error_on_opening << "Error on opening " << path << "\n";
+        std::vector<std::string> candidates {};
 
-        if (!rwop)
+        if (supported_texture_formats.astc)
         {
-            print_ostream_msg_and_exit(error_on_opening);
+            candidates.push_back(stem + ".astc.ktx2");
+            candidates.push_back(stem + ".astc.ktx");
         }
 
-        const auto bytes_to_read = rwop->size(rwop);
-
-        CHECK(bytes_to_read != -1);
+        candidates.push_back(stem + ".etc2.ktx2");
+        candidates.push_back(stem + ".etc2.ktx");
 
-        raw_png_image.resize(bytes_to_read);
+        for (const std::string& candidate : candidates)
+        {
+            // Embedded and packed files are used in place, both outlive
+            // textures.
+            const asset_span asset = find_asset(candidate);
+            std::vector<std::uint8_t> content {};
 
-        const auto bytes_read = rwop->read(rwop,
-                                           raw_png_image.data(),
-                                           bytes_to_read);
+            const bool parsed = !asset.empty()
+                ? parse_ktx(asset.data, asset.size, image)
+                : read_file(candidate, content)
+                    && parse_ktx(std::move(content), image);
 
-        CHECK(bytes_read == bytes_to_read);
+            if (!parsed)
+            {
+                continue;
+            }
 
-        CHECK(!rwop->close(rwop));
+            if (image.layers == 1
+                && (image.family != ktx_format_family::astc
+                    || supported_texture_formats.astc))
+            {
+                return true;
+            }
+        }
 
-        int w {}, h {}, components {}, required_comps { 4 };
+        return false;
+    }
 
-        stbi_set_flip_vertically_on_load(true);
+    static texture_image load_texture_image(const std::string_view path)
+    {
+        texture_image image {};
 
-        unsigned char* raw_pixels_after_decoding
-            = stbi_load_from_memory(raw_png_image.data(),
-                                    static_cast<int>(raw_png_image.size()),
-                                    &w,
-                                    &h,
-                                    &components,
-                                    required_comps);
+        if (!load_ktx_image(path, image.ktx))
+        {
+            image.ktx = ktx_image {};
+            image.pixels = decode_image(path, image.width, image.height);
+        }
 
-        CHECK_NOTNULL(raw_pixels_after_decoding);
+        return image;
+    }
 
-        m_texture_width = w;
-        m_texture_height = h;
+    // Layers of a texture array are uploaded from KTX files only if all
+    // of them have one in the same format, size and number of levels.
+    static std::vector<texture_image> load_texture_images(
+        const std::vector<std::string>& paths)
+    {
+        std::vector<texture_image> images {};
 
-        glGenTextures(1, &m_texture_id);
-        opengl_check();
+        for (const std::string& path : paths)
+        {
+            images.emplace_back();
 
-        glBindTexture(GL_TEXTURE_2D, m_texture_id);
-        opengl_check();
+            if (!load_ktx_image(path, images.back().ktx))
+            {
+                images.clear();
+                break;
+            }
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        opengl_check();
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        opengl_check();
+            const ktx_image& first = images.front().ktx;
+            const ktx_image& layer = images.back().ktx;
 
-        glTexImage2D(GL_TEXTURE_2D,
+            if (layer.internal_format != first.internal_format
+                || layer.width != first.width || layer.height != first.height
+                || layer.levels.size() != first.levels.size())
+            {
+                images.clear();
+                break;
+            }
+        }
+
+        if (!images.empty())
+        {
+            return images;
+        }
+
+        for (const std::string& path : paths)
+        {
+            texture_image& image = images.emplace_back();
+            image.pixels = decode_image(path, image.width, image.height);
+
+            // All layers of the array share the same size.
+            CHECK(image.width == images.front().width);
+            CHECK(image.height == images.front().height);
+        }
+
+        return images;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Per-frame constants shared by all programs which declare
+    // `frame_constants` uniform block. Follows std140 layout, where every
+    // column of mat3 is padded to vec4:
+    //
+    // layout(std140) uniform frame_constants
+    // {
+    //     mat3 u_view_projection;
+    //     vec2 u_resolution;
+    //     float u_time;
+    // };
+    struct frame_constants
+    {
+        float view_projection[12] {};
+        float resolution[2] {};
+        float time {};
+        float padding {};
+    };
+
+    static_assert(sizeof(frame_constants) == 64,
+                  "frame_constants should match std140 layout");
+
+    glm::mediump_mat3 get_view_projection(const camera2d& camera)
+    {
+        CHECK(camera.viewport_width > 0.f && camera.viewport_height > 0.f);
+
+        const float scale_x = 2.f * camera.zoom / camera.viewport_width;
+        // World `y` axis points down, NDC one points up.
+        const float scale_y = -2.f * camera.zoom / camera.viewport_height;
+        const float cos_r = std::cos(-camera.rotation);
+        const float sin_r = std::sin(-camera.rotation);
+
+        // ndc = scale * rotate * (world - center), column-major.
+        glm::mediump_mat3 result(1.f);
+        result[0][0] = scale_x * cos_r;
+        result[0][1] = scale_y * sin_r;
+        result[0][2] = 0.f;
+        result[1][0] = -scale_x * sin_r;
+        result[1][1] = scale_y * cos_r;
+        result[1][2] = 0.f;
+        result[2][0] = -(result[0][0] * camera.center_x
+                         + result[1][0] * camera.center_y);
+        result[2][1] = -(result[0][1] * camera.center_x
+                         + result[1][1] * camera.center_y);
+        result[2][2] = 1.f;
+
+        return result;
+    }
+
+    bool is_translucent(const blend_mode blend)
+    {
+        return blend == blend_mode::alpha || blend == blend_mode::additive;
+    }
+
+    constexpr GLuint frame_constants_binding_point { 0 };
+
+    // Features of the sprite shader (sprite.vert, sprite.frag), the order
+    // matches the defines passed to its variants.
+    constexpr shader_features sprite_feature_model_matrix { 1u << 0 };
+    constexpr shader_features sprite_feature_texture_array { 1u << 1 };
+    constexpr shader_features sprite_feature_alpha_test { 1u << 2 };
+    constexpr std::size_t sprite_shader_variants_max { 1u << 3 };
+
+    // Initial sizes of one frame region of the stream buffers. They are
+    // doubled on overflow.
+    constexpr std::size_t vertex_stream_frame_capacity { 256 * 1024 };
+    constexpr std::size_t index_stream_frame_capacity { 64 * 1024 };
+
+    // Time the render thread spends on uploading asynchronously loaded
+    // textures per frame. At least one texture is uploaded per frame.
+    constexpr std::chrono::microseconds texture_upload_frame_budget { 2000 };
+
+    // Sounds with more data (about 3 s of 16-bit mono), e.g. music, are
+    // streamed instead of being decoded into memory.
+    constexpr std::size_t audio_streaming_threshold { 256 * 1024 };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Playback state lives in the mixer, the buffer only sends it
+    // commands. Long sounds have a stream instead of the samples.
+    struct audio_buffer : public iaudio_buffer
+    {
+        Uint8* buffer { nullptr };
+        Uint32 size {};
+        std::unique_ptr<audio_stream> stream {};
+        audio_samples samples {};
+        audio_mixer& mixer;
+        float gain { 1.f };
+
+        audio_buffer(const std::string_view audio_file_name,
+                     const SDL_AudioSpec& desired_audio_spec,
+                     audio_mixer& mixer);
+
+        ~audio_buffer()
+        {
+            mixer.release(&samples);
+            SDL_free(buffer);
+        }
+
+        voice_id play(const running_mode mode,
+                      const voice_parameters& parameters) override
+        {
+            if (stream)
+            {
+                stream->start(mode == running_mode::for_ever);
+            }
+
+            return mixer.play(
+                &samples, mode == running_mode::for_ever, gain, parameters);
+        }
+
+        void stop() override
+        {
+            mixer.stop(&samples);
+        }
+
+        void stop(const voice_id voice) override
+        {
+            mixer.stop(voice);
+        }
+
+        void set_gain(const float gain) override
+        {
+            this->gain = gain;
+            mixer.set_gain(&samples, gain);
+        }
+
+        void set_voice_parameters(const voice_id voice,
+                                  const voice_parameters& parameters) override
+        {
+            mixer.set_voice_parameters(voice, parameters);
+        }
+
+        std::size_t get_memory_size() const override
+        {
+            return stream ? stream->get_memory_size() : size;
+        }
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    class engine_using_sdl final : public iengine
+    {
+    public:
+        // Offscreen engine draws into a framebuffer object of a hidden
+        // window created by SDL offscreen video driver.
+        explicit engine_using_sdl(const bool offscreen)
+            : m_offscreen { offscreen }
+        {
+        }
+
+        engine_using_sdl(const engine_using_sdl&) = delete;
+
+        engine_using_sdl(engine_using_sdl&&) = delete;
+
+        engine_using_sdl& operator=(const engine_using_sdl&) = delete;
+
+        engine_using_sdl& operator=(engine_using_sdl&&) = delete;
+
+        void init() override;
+
+        bool process_input(event& event) override;
+
+        bool key_down(const enum keys key) override;
+
+        void imgui_new_frame() override;
+
+        void imgui_render() override;
+
+        void set_camera(const camera2d& camera) override;
+
+        camera2d get_camera() const noexcept override;
+
+        void render(ivertex_buffer* vertex_buffer,
+                    i_index_buffer* ebo,
+                    itexture* const texture,
+                    const glm::mediump_mat3& matrix) override;
+
+        void render(ivertex_buffer* vertex_buffer,
+                    i_index_buffer* ebo,
+                    itexture* const texture) override;
+
+        void render(ivertex_buffer* vertex_buffer,
+                    i_index_buffer* ebo,
+                    itexture_array* const texture_array) override;
+
+        void render(const std::vector<sprite_vertex>& vertices,
+                    const std::vector<uint32_t>& indices,
+                    itexture* const texture) override;
+
+        void render(const std::vector<vertex>& vertices,
+                    const std::vector<uint32_t>& indices,
+                    itexture_array* const texture_array) override;
+
+        itexture* create_texture(const std::string_view path) override;
+
+        void destroy_texture(const itexture* const texture) override;
+
+        itexture_array* create_texture_array(
+            const std::vector<std::string_view>& paths) override;
+
+        void destroy_texture_array(
+            const itexture_array* const texture_array) override;
+
+        void submit(const sprite_command& command) override;
+
+        void submit(const mesh_command& command) override;
+
+        void execute_render_queue() override;
+
+        ivertex_buffer* create_vertex_buffer(
+            const std::vector<triangle>& triangles) override;
+
+        ivertex_buffer* create_vertex_buffer(
+            const std::vector<vertex>& vertices) override;
+
+        ivertex_buffer* create_vertex_buffer(
+            const std::vector<sprite_vertex>& vertices) override;
+
+        ivertex_buffer* create_vertex_buffer(
+            const void* vertices,
+            const std::size_t vertices_number,
+            const vertex_layout& layout) override;
+
+        void destroy_vertex_buffer(ivertex_buffer* buffer) override;
+
+        i_index_buffer* create_ebo(
+            const std::vector<uint32_t>& indices) override;
+
+        void destroy_ebo(i_index_buffer* buffer) override;
+
+        iaudio_buffer* create_audio_buffer(
+            const std::string_view audio_file_name) override;
+
+        void destroy_audio_buffer(iaudio_buffer* buffer) override;
+
+        void set_voice_stealing(const voice_stealing policy) override;
+
+        void swap_buffers() override;
+
+        void uninit() override;
+
+        void imgui_uninit() override;
+
+        std::pair<size_t, size_t>
+        get_screen_resolution() const noexcept override;
+
+        render_stats get_render_stats() const noexcept override;
+
+        void set_layer_name(const std::uint8_t layer,
+                            const std::string_view name) override;
+        gpu_timings get_gpu_timings() const override;
+
+        std::uint64_t get_time_since_epoch() const;
+
+        static void sdl_audio_callback(void* userdata, Uint8* stream, int len);
+
+    private:
+        using queued_command = std::variant<sprite_command, mesh_command>;
+
+        std::optional<bind_key> get_key_for_event(
+            const SDL_Event& sdl_event);
+
+        // Everything below is executed on the render thread.
+        void init_opengl();
+        void create_offscreen_framebuffer();
+        void destroy_offscreen_framebuffer();
+
+        void uninit_opengl();
+
+        void present();
+
+        void execute_queued_commands(
+            const std::vector<queued_command>& commands);
+
+        std::uint64_t get_sort_key(const queued_command& command) const;
+
+        void draw(ivertex_buffer* vertex_buffer,
+                  i_index_buffer* ebo,
+                  itexture* const texture,
+                  const glm::mediump_mat3& matrix);
+
+        void draw(ivertex_buffer* vertex_buffer,
+                  i_index_buffer* ebo,
+                  itexture* const texture);
+
+        // `features` are the sprite shader features besides the
+        // texture kind, e.g. alpha test of the blend mode.
+        void draw(ivertex_buffer* vertex_buffer,
+                  i_index_buffer* ebo,
+                  itexture_array* const texture_array,
+                  const shader_features features);
+
+        void draw(const std::vector<sprite_vertex>& vertices,
+                  const std::vector<uint32_t>& indices,
+                  itexture* const texture,
+                  const shader_features features);
+
+        void draw(const std::vector<vertex>& vertices,
+                  const std::vector<uint32_t>& indices,
+                  itexture_array* const texture_array,
+                  const shader_features features);
+
+        void draw_elements(i_index_buffer* ebo);
+
+        void draw_streamed(const GLuint vao,
+                           const void* vertices,
+                           const std::size_t vertices_number,
+                           const std::size_t stride,
+                           const std::vector<uint32_t>& indices);
+
+        // Indices are read from the index stream at `indices_offset`
+        // bytes, they count vertices from `base_vertex` of the VAO.
+        void draw_stream_range(const GLuint vao,
+                               const std::size_t base_vertex,
+                               const std::size_t indices_offset,
+                               const std::size_t indices_number);
+
+        GLuint create_stream_vertex_array(const vertex_layout& layout);
+
+        // Uniforms of a sprite shader variant. Depth value is kept to skip
+        // redundant updates.
+        struct sprite_uniforms
+        {
+            uniform_handle matrix {};
+            uniform_handle depth {};
+            float depth_value { -1.f };
+        };
+
+        // Compiles the variant on first use.
+        opengl_shader_program& use_sprite_shader(
+            const shader_features features);
+
+        void close_sprite_batch();
+        void draw_queued();
+        void begin_layer_pass(const std::uint8_t layer);
+
+        void apply_blend_mode(const blend_mode blend);
+
+        void set_depth(const shader_features features, const float depth);
+
+        void upload_frame_constants();
+
+        std::unique_ptr<SDL_Window, void (*)(SDL_Window*)>
+            m_window { nullptr, nullptr };
+
+        std::unique_ptr<void, int (*)(SDL_GLContext)>
+            m_opengl_context { nullptr, nullptr };
+
+        // Linked program binaries from previous runs.
+        std::unique_ptr<opengl_program_cache> m_program_cache {};
+
+        // All engine draws, a variant per set of sprite features.
+        std::unique_ptr<opengl_shader_variants> m_sprite_shader {};
+
+        // Owns the GL context, all GL calls are made from it.
+        render_thread m_render_thread {};
+
+        const bool m_offscreen { false };
+        GLuint m_offscreen_framebuffer {};
+        // Colour and depth attachments.
+        std::array<GLuint, 2> m_offscreen_renderbuffers {};
+
+        // Game thread state.
+        camera2d m_camera {};
+        std::vector<queued_command> m_submitted_commands {};
+
+        // Render thread state.
+        opengl_state_cache m_state_cache {};
+        std::unique_ptr<opengl_uniform_buffer> m_frame_constants_buffer {};
+
+        // Per-frame geometry, one VAO per vertex layout reads from the
+        // same vertex stream at offset 0 (see glDrawElementsBaseVertex).
+        std::unique_ptr<opengl_stream_buffer> m_vertex_stream {};
+        std::unique_ptr<opengl_stream_buffer> m_index_stream {};
+        GLuint m_sprite_stream_vao {};
+        GLuint m_vertex_stream_vao {};
+
+        render_queue m_render_queue {};
+
+        std::unique_ptr<opengl_gpu_profiler> m_gpu_profiler {};
+
+        // Textures are read and decoded by the workers, decoded images
+        // wait in the queue for the render thread.
+        std::unique_ptr<worker_pool> m_texture_workers {};
+        opengl_upload_queue m_texture_uploads {};
+        // Size of all textures, render thread only.
+        std::size_t m_texture_bytes {};
+        // Names of the render passes of queued layers.
+        std::array<std::string, 256> m_layer_names {};
+
+        // Draw of the render queue: a mesh or consecutive sprites with
+        // the same texture, blending and depth.
+        struct queued_draw
+        {
+            const mesh_command* mesh { nullptr };
+            itexture* texture { nullptr };
+            itexture_array* texture_array { nullptr };
+            blend_mode blend { blend_mode::alpha };
+            float depth {};
+            // Range of m_batch_indices.
+            std::size_t first_index {};
+            std::size_t indices_number {};
+            // Layer of the render pass the draw begins.
+            std::optional<std::uint8_t> pass {};
+        };
+
+        // Geometry of all draws of the queue is collected first and
+        // pushed to the streams at once, so they are mapped once per
+        // queue rather than once per draw.
+        std::vector<queued_draw> m_queued_draws {};
+        itexture* m_batch_texture { nullptr };
+        itexture_array* m_batch_texture_array { nullptr };
+        blend_mode m_batch_blend { blend_mode::alpha };
+        float m_batch_depth {};
+        std::size_t m_batch_first_index {};
+        std::optional<std::uint8_t> m_batch_pass {};
+        std::vector<sprite_vertex> m_batch_sprite_vertices {};
+        std::vector<vertex> m_batch_vertices {};
+        std::vector<uint32_t> m_batch_indices {};
+        std::chrono::steady_clock::time_point m_start_time {};
+        camera2d m_frame_camera {};
+        bool m_frame_constants_dirty { true };
+
+        std::array<sprite_uniforms, sprite_shader_variants_max>
+            m_sprite_uniforms {};
+        render_stats m_frame_stats {};
+
+        // Written by the render thread, read by the game thread.
+        mutable std::mutex m_stats_mutex {};
+        render_stats m_last_frame_stats {};
+
+        // Desired audio spec for all sounds.
+        SDL_AudioSpec m_desired_audio_spec {};
+        // Outlives the device, sounds are destroyed after uninit.
+        std::unique_ptr<audio_mixer> m_audio_mixer {};
+        // Streams of sounds not destroyed yet, game thread only.
+        std::vector<audio_stream*> m_audio_streams {};
+        SDL_AudioDeviceID m_audio_device_id {};
+
+        std::size_t m_screen_width {};
+        std::size_t m_screen_height {};
+        int m_viewport_width {};
+        int m_viewport_height {};
+    };
+
+    void opengl_texture::load(const std::string_view path)
+    {
+        upload(load_texture_image(path));
+    }
+
+    void opengl_texture::create_placeholder()
+    {
+        if (m_texture_id)
+        {
+            return;
+        }
+
+        const std::array<unsigned char, 4> transparent_pixel {};
+
+        upload_pixels(transparent_pixel.data(), 1, 1);
+    }
+
+    void opengl_texture::upload(const texture_image& image)
+    {
+        if (image.is_ktx())
+        {
+            upload_ktx(image.ktx);
+        }
+        else
+        {
+            upload_pixels(image.pixels.get(), image.width, image.height);
+        }
+    }
+
+    void opengl_texture::upload_pixels(const unsigned char* pixels,
+                                       const int width,
+                                       const int height)
+    {
+        m_texture_width = width;
+        m_texture_height = height;
+
+        if (!m_texture_id)
+        {
+            create_texture_object();
+        }
+
+        m_state_cache.bind_texture(0, GL_TEXTURE_2D, m_texture_id);
+
+        // Min filter is GL_LINEAR, so mip levels are never sampled and
+        // aren't generated.
+        glTexImage2D(GL_TEXTURE_2D,
+                     0,
+                     GL_RGBA8,
+                     m_texture_width,
+                     m_texture_height,
                      0,
                      GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     pixels);
+        opengl_check();
+
+        set_levels(1, m_texture_width * m_texture_height * 4);
+    }
+
+    void opengl_texture::upload_ktx(const ktx_image& image)
+    {
+        m_texture_width = image.width;
+        m_texture_height = image.height;
+
+        if (!m_texture_id)
+        {
+            create_texture_object();
+        }
+
+        m_state_cache.bind_texture(0, GL_TEXTURE_2D, m_texture_id);
+
+        std::size_t bytes {};
+
+        for (std::size_t i = 0; i < image.levels.size(); i++)
+        {
+            const ktx_level& level = image.levels[i];
+
+            if (image.is_compressed())
+            {
+                glCompressedTexImage2D(GL_TEXTURE_2D,
+                                       static_cast<GLint>(i),
+                                       image.internal_format,
+                                       level.width,
+                                       level.height,
+                                       0,
+                                       static_cast<GLsizei>(level.size),
+                                       image.get_level_data(i));
+            }
+            else
+            {
+                glTexImage2D(GL_TEXTURE_2D,
+                             static_cast<GLint>(i),
+                             image.internal_format,
+                             level.width,
+                             level.height,
+                             0,
+                             image.format,
+                             image.type,
+                             image.get_level_data(i));
+            }
+            opengl_check();
+
+            bytes += level.size;
+        }
+
+        set_levels(image.levels.size(), bytes);
+    }
+
+    void opengl_texture::set_levels(const std::size_t levels_number,
+                                    const std::size_t bytes)
+    {
+        // Prebuilt mip chains of KTX files are sampled, single level
+        // images are not.
+        glTexParameteri(GL_TEXTURE_2D,
+                        GL_TEXTURE_MIN_FILTER,
+                        levels_number > 1 ? GL_LINEAR_MIPMAP_LINEAR
+                                          : GL_LINEAR);
+        opengl_check();
+        glTexParameteri(GL_TEXTURE_2D,
+                        GL_TEXTURE_MAX_LEVEL,
+                        static_cast<GLint>(levels_number - 1));
+        opengl_check();
+
+        m_texture_bytes -= m_bytes;
+        m_bytes = bytes;
+        m_texture_bytes += m_bytes;
+    }
+
+    void opengl_texture::create_texture_object()
+    {
+        glGenTextures(1, &m_texture_id);
+        opengl_check();
+
+        m_state_cache.bind_texture(0, GL_TEXTURE_2D, m_texture_id);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        opengl_check();
+    }
+
+    void opengl_texture_array::load(const std::vector<std::string_view>& paths)
+    {
+        CHECK(!paths.empty());
+        CHECK(paths.size() == m_layers_number);
+
+        upload(load_texture_images(
+            std::vector<std::string>(paths.begin(), paths.end())));
+    }
+
+    void opengl_texture_array::create_placeholder()
+    {
+        if (m_texture_id)
+        {
+            return;
+        }
+
+        const std::vector<unsigned char> transparent_pixels(
+            m_layers_number * 4);
+
+        std::vector<const unsigned char*> layers {};
+
+        for (std::size_t layer = 0; layer < m_layers_number; layer++)
+        {
+            layers.push_back(transparent_pixels.data() + layer * 4);
+        }
+
+        upload_pixels(layers, 1, 1);
+    }
+
+    void opengl_texture_array::upload(const std::vector<texture_image>& layers)
+    {
+        CHECK(layers.size() == m_layers_number);
+
+        if (layers.front().is_ktx())
+        {
+            upload_ktx(layers);
+            return;
+        }
+
+        std::vector<const unsigned char*> pixels {};
+
+        for (const texture_image& layer : layers)
+        {
+            pixels.push_back(layer.pixels.get());
+        }
+
+        upload_pixels(pixels,
+                      layers.front().width,
+                      layers.front().height);
+    }
+
+    void opengl_texture_array::upload_pixels(
+        const std::vector<const unsigned char*>& layers,
+        const int width,
+        const int height)
+    {
+        CHECK(layers.size() == m_layers_number);
+
+        m_texture_width = width;
+        m_texture_height = height;
+
+        if (!m_texture_id)
+        {
+            create_texture_object();
+        }
+
+        m_state_cache.bind_texture(0, GL_TEXTURE_2D_ARRAY, m_texture_id);
+
+        // Mutable storage, so the placeholder can be replaced keeping
+        // the texture id.
+        glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                     0,
+                     GL_RGBA8,
                      m_texture_width,
                      m_texture_height,
+                     m_layers_number,
                      0,
                      GL_RGBA,
                      GL_UNSIGNED_BYTE,
-                     raw_pixels_after_decoding);
+                     nullptr);
+        opengl_check();
+
+        for (std::size_t layer = 0; layer < m_layers_number; layer++)
+        {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                            0,
+                            0,
+                            0,
+                            layer,
+                            m_texture_width,
+                            m_texture_height,
+                            1,
+                            GL_RGBA,
+                            GL_UNSIGNED_BYTE,
+                            layers[layer]);
+            opengl_check();
+        }
+
+        set_levels(1,
+                   m_texture_width * m_texture_height * 4 * m_layers_number);
+    }
+
+    void opengl_texture_array::upload_ktx(
+        const std::vector<texture_image>& layers)
+    {
+        const ktx_image& first = layers.front().ktx;
+
+        m_texture_width = first.width;
+        m_texture_height = first.height;
+
+        if (!m_texture_id)
+        {
+            create_texture_object();
+        }
+
+        m_state_cache.bind_texture(0, GL_TEXTURE_2D_ARRAY, m_texture_id);
+
+        std::size_t bytes {};
+
+        for (std::size_t i = 0; i < first.levels.size(); i++)
+        {
+            const ktx_level& level = first.levels[i];
+            const auto level_index = static_cast<GLint>(i);
+
+            // Storage of the level for all layers, then every layer.
+            if (first.is_compressed())
+            {
+                glCompressedTexImage3D(
+                    GL_TEXTURE_2D_ARRAY,
+                    level_index,
+                    first.internal_format,
+                    level.width,
+                    level.height,
+                    m_layers_number,
+                    0,
+                    static_cast<GLsizei>(level.size * m_layers_number),
+                    nullptr);
+            }
+            else
+            {
+                glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                             level_index,
+                             first.internal_format,
+                             level.width,
+                             level.height,
+                             m_layers_number,
+                             0,
+                             first.format,
+                             first.type,
+                             nullptr);
+            }
+            opengl_check();
+
+            for (std::size_t layer = 0; layer < m_layers_number; layer++)
+            {
+                const ktx_image& image = layers[layer].ktx;
+
+                if (first.is_compressed())
+                {
+                    glCompressedTexSubImage3D(
+                        GL_TEXTURE_2D_ARRAY,
+                        level_index,
+                        0,
+                        0,
+                        layer,
+                        level.width,
+                        level.height,
+                        1,
+                        first.internal_format,
+                        static_cast<GLsizei>(image.levels[i].size),
+                        image.get_level_data(i));
+                }
+                else
+                {
+                    glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                                    level_index,
+                                    0,
+                                    0,
+                                    layer,
+                                    level.width,
+                                    level.height,
+                                    1,
+                                    first.format,
+                                    first.type,
+                                    image.get_level_data(i));
+                }
+                opengl_check();
+
+                bytes += image.levels[i].size;
+            }
+        }
+
+        set_levels(first.levels.size(), bytes);
+    }
+
+    void opengl_texture_array::set_levels(const std::size_t levels_number,
+                                          const std::size_t bytes)
+    {
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,
+                        GL_TEXTURE_MIN_FILTER,
+                        levels_number > 1 ? GL_LINEAR_MIPMAP_LINEAR
+                                          : GL_LINEAR);
+        opengl_check();
+        glTexParameteri(GL_TEXTURE_2D_ARRAY,
+                        GL_TEXTURE_MAX_LEVEL,
+                        static_cast<GLint>(levels_number - 1));
+        opengl_check();
+
+        m_texture_bytes -= m_bytes;
+        m_bytes = bytes;
+        m_texture_bytes += m_bytes;
+    }
+
+    void opengl_texture_array::create_texture_object()
+    {
+        GLint max_layers {};
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+        opengl_check();
+        CHECK(m_layers_number <= static_cast<std::size_t>(max_layers));
+
+        glGenTextures(1, &m_texture_id);
+        opengl_check();
+
+        m_state_cache.bind_texture(0, GL_TEXTURE_2D_ARRAY, m_texture_id);
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        opengl_check();
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         opengl_check();
-        glGenerateMipmap(GL_TEXTURE_2D);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         opengl_check();
     }
 
     audio_buffer::audio_buffer(const std::string_view audio_file_name,
-                               const SDL_AudioSpec& desired_audio_spec)
+                               const SDL_AudioSpec& desired_audio_spec,
+                               audio_mixer& mixer)
+        : mixer { mixer }
     {
-        SDL_RWops* rwop_ptr_file = SDL_RWFromFile(audio_file_name.data(),
-                                                  "rb");
-        CHECK_NOTNULL(rwop_ptr_file);
+        std::unique_ptr<audio_source> source
+            = open_audio_source(audio_file_name);
+
+        if (source && source->get_size() > audio_streaming_threshold)
+        {
+            stream = std::make_unique<audio_stream>(std::move(source),
+                                                    desired_audio_spec.format,
+                                                    desired_audio_spec.freq);
+            samples.channels = stream->get_channels();
+            samples.stream = stream.get();
+            return;
+        }
 
         SDL_AudioSpec audio_spec {};
 
-        // Load the audio data of a WAVE file into memory.
-        SDL_AudioSpec* music_spec = SDL_LoadWAV_RW(rwop_ptr_file,
-                                                   1,
-                                                   &audio_spec,
-                                                   &buffer,
-                                                   &size);
+        if (source)
+        {
+            // Short sounds are decoded at once.
+            size = static_cast<Uint32>(source->get_size());
+            buffer = static_cast<Uint8*>(SDL_malloc(size));
+            CHECK_NOTNULL(buffer);
+
+            Uint32 bytes_read {};
+
+            while (bytes_read < size)
+            {
+                const std::size_t bytes
+                    = source->read(buffer + bytes_read, size - bytes_read);
+                CHECK(bytes > 0);
+                bytes_read += static_cast<Uint32>(bytes);
+            }
+
+            audio_spec.format = source->format;
+            audio_spec.channels = source->channels;
+            audio_spec.freq = source->freq;
+        }
+        else
+        {
+            // WAVE files in encodings the sources don't read (e.g. ADPCM).
+            const asset_span asset = find_asset(audio_file_name);
+
+            SDL_RWops* rwop_ptr_file = asset.empty()
+                ? SDL_RWFromFile(audio_file_name.data(), "rb")
+                : SDL_RWFromConstMem(asset.data, asset.size);
+            CHECK_NOTNULL(rwop_ptr_file);
+
+            // Load the audio data of a WAVE file into memory.
+            SDL_AudioSpec* music_spec = SDL_LoadWAV_RW(rwop_ptr_file,
+                                                       1,
+                                                       &audio_spec,
+                                                       &buffer,
+                                                       &size);
+
+            CHECK(music_spec);
+        }
 
-        CHECK(music_spec);
+        // Mono sounds stay mono, the mixer pans them.
+        const Uint8 channels = std::min<Uint8>(audio_spec.channels, 2);
 
         if (audio_spec.freq != desired_audio_spec.freq
-            || audio_spec.channels != desired_audio_spec.channels
+            || audio_spec.channels != channels
             || audio_spec.format != desired_audio_spec.format)
         {
             Uint8* new_converted_buffer { nullptr };
@@ -495,7 +1681,7 @@ namespace arci
                                                        buffer,
                                                        size,
                                                        desired_audio_spec.format,
-                                                       desired_audio_spec.channels,
+                                                       channels,
                                                        desired_audio_spec.freq,
                                                        &new_converted_buffer,
                                                        &new_length);
@@ -507,13 +1693,28 @@ namespace arci
             buffer = new_converted_buffer;
             size = new_length;
         }
+
+        const std::size_t frame_size
+            = SDL_AUDIO_BITSIZE(desired_audio_spec.format) / 8 * channels;
+        samples = { buffer, size / frame_size, channels };
     }
 
     void engine_using_sdl::init()
     {
+        if (m_offscreen)
+        {
+            // Offscreen driver creates GL contexts with EGL pbuffers,
+            // so no display server is needed.
+            CHECK(SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen"));
+            CHECK(SDL_SetHint(SDL_HINT_AUDIO_DRIVER, "dummy"));
+        }
+
         // SDL initialization.
         CHECK(SDL_Init(SDL_INIT_EVERYTHING) == 0);
 
+        // Without a pack every asset is read from its own file.
+        mount_asset_pack(get_default_asset_pack_path());
+
         CHECK(SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS,
                                   SDL_GL_CONTEXT_DEBUG_FLAG)
               == 0);
@@ -548,6 +1749,11 @@ namespace arci
 
         Uint32 window_flags = SDL_WINDOW_OPENGL;
 
+        if (m_offscreen)
+        {
+            window_flags |= SDL_WINDOW_HIDDEN;
+        }
+
 #ifdef __ANDROID__
         int num_displays {};
         const auto* list_of_displays = SDL_GetDisplays(&num_displays);
@@ -571,6 +1777,9 @@ namespace arci
         window_flags |= SDL_WINDOW_FULLSCREEN;
 #endif
 
+        // Opaque sprites are depth tested against each other.
+        CHECK(SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24) == 0);
+
         // Window setup.
         m_window = std::unique_ptr<SDL_Window, void (*)(SDL_Window*)>(
             SDL_CreateWindow(
@@ -594,80 +1803,68 @@ namespace arci
             SDL_GL_DeleteContext);
         CHECK_NOTNULL(m_opengl_context.get());
 
-        auto load_opengl_func_pointer = [](const char* func_name) -> void* {
-            SDL_FunctionPointer sdl_func_pointer
-                = SDL_GL_GetProcAddress(func_name);
-            CHECK_NOTNULL(sdl_func_pointer);
-            return reinterpret_cast<void*>(sdl_func_pointer);
+        int w {}, h {};
+        CHECK(!SDL_GetWindowSizeInPixels(m_window.get(), &w, &h));
+        m_viewport_width = w;
+        m_viewport_height = h;
+
+        m_camera = camera2d {
+            m_screen_width / 2.f,
+            m_screen_height / 2.f,
+            1.f,
+            0.f,
+            static_cast<float>(m_screen_width),
+            static_cast<float>(m_screen_height),
         };
+        m_frame_camera = m_camera;
 
-        CHECK(gladLoadGLES2Loader(load_opengl_func_pointer));
-
-        glEnable(GL_DEBUG_OUTPUT);
-        opengl_check();
-        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-        opengl_check();
-        glDebugMessageCallback(opengl_message_callback, nullptr);
-        opengl_check();
-        glDebugMessageControl(
-            GL_DONT_CARE,
-            GL_DONT_CARE,
-            GL_DONT_CARE,
-            0,
-            nullptr,
-            GL_TRUE);
-        opengl_check();
-
-        m_textured_triangle_program.load_shader(GL_VERTEX_SHADER,
-                                                "texture.vert");
-        m_textured_triangle_program.load_shader(GL_FRAGMENT_SHADER,
-                                                "texture.frag");
-        m_textured_triangle_program.prepare_program();
-
-        m_tex_no_math_program.load_shader(GL_VERTEX_SHADER,
-                                          "tex-no-math.vert");
-        m_tex_no_math_program.load_shader(GL_FRAGMENT_SHADER,
-                                          "tex-no-math.frag");
-        m_tex_no_math_program.prepare_program();
-
-        glGenBuffers(1, &m_vbo);
-        opengl_check();
-
-        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-        opengl_check();
-
-        glGenVertexArrays(1, &m_vao);
-        opengl_check();
-        glBindVertexArray(m_vao);
-        opengl_check();
+        // ImGui context lives on the game thread, only its GL objects
+        // are created by the render thread.
+        ImGui_ImplSdlGL3_Init(m_window.get());
 
-        glEnable(GL_BLEND);
-        opengl_check();
+        m_texture_workers = std::make_unique<worker_pool>(
+            worker_pool::get_default_threads_number());
 
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        opengl_check();
+        // ARCI_RENDER_THREAD=0 makes all GL calls on the game thread.
+        const char* render_thread_env = std::getenv("ARCI_RENDER_THREAD");
+        const bool threaded = !render_thread_env
+            || std::string_view { render_thread_env } != "0";
 
-        int w {}, h {};
-        CHECK(!SDL_GetWindowSizeInPixels(m_window.get(), &w, &h));
+        if (threaded)
+        {
+            // Context is made current on the render thread.
+            CHECK(SDL_GL_MakeCurrent(m_window.get(), nullptr) == 0);
+        }
 
-        glViewport(0, 0, w, h);
-        opengl_check();
+        m_render_thread.start(threaded, [this, threaded] {
+            if (threaded)
+            {
+                CHECK(SDL_GL_MakeCurrent(m_window.get(),
+                                         m_opengl_context.get())
+                      == 0);
+            }
 
-        ImGui_ImplSdlGL3_Init(m_window.get());
+            init_opengl();
+        });
+        m_render_thread.flush();
 
         SDL_memset(&m_desired_audio_spec, 0, sizeof(m_desired_audio_spec));
         m_desired_audio_spec.freq = 48000;
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
         m_desired_audio_spec.format = SDL_AUDIO_F32LSB;
-        m_desired_audio_spec.channels = 2;
 #else
         m_desired_audio_spec.format = SDL_AUDIO_S16LSB;
-        m_desired_audio_spec.channels = 1;
 #endif
+        // Stereo for panning, the mixer writes stereo frames.
+        m_desired_audio_spec.channels = 2;
         m_desired_audio_spec.samples = 4096;
         m_desired_audio_spec.callback = sdl_audio_callback;
         m_desired_audio_spec.userdata = this;
 
+        m_audio_mixer
+            = std::make_unique<audio_mixer>(m_desired_audio_spec.format,
+                                            m_desired_audio_spec.samples);
+
         const char* default_audio_device { nullptr };
 
         SDL_AudioSpec returned_from_open_audio_device {};
@@ -687,10 +1884,168 @@ namespace arci
         CHECK(m_desired_audio_spec.channels
               == returned_from_open_audio_device.channels);
 
-        CHECK(m_desired_audio_spec.format
-              == returned_from_open_audio_device.format);
+        CHECK(m_desired_audio_spec.format
+              == returned_from_open_audio_device.format);
+
+        SDL_PlayAudioDevice(m_audio_device_id);
+        m_audio_mixer->set_device(m_audio_device_id);
+    }
+
+    void engine_using_sdl::init_opengl()
+    {
+        auto load_opengl_func_pointer = [](const char* func_name) -> void* {
+            SDL_FunctionPointer sdl_func_pointer
+                = SDL_GL_GetProcAddress(func_name);
+            CHECK_NOTNULL(sdl_func_pointer);
+            return reinterpret_cast<void*>(sdl_func_pointer);
+        };
+
+        CHECK(gladLoadGLES2Loader(load_opengl_func_pointer));
+
+        m_gpu_profiler
+            = std::make_unique<opengl_gpu_profiler>(load_opengl_func_pointer);
+
+        init_gl_diagnostics();
+
+        // ASTC LDR is a part of GL ES 3.2, but not every 3.2 driver has it.
+        // ARCI_COMPRESSED_TEXTURES=0 makes all textures load from PNG.
+        const char* compressed_textures_env
+            = std::getenv("ARCI_COMPRESSED_TEXTURES");
+        supported_texture_formats.ktx = !compressed_textures_env
+            || std::string_view { compressed_textures_env } != "0";
+        supported_texture_formats.astc
+            = has_gl_extension("GL_KHR_texture_compression_astc_ldr");
+
+        m_program_cache = std::make_unique<opengl_program_cache>(
+            get_default_program_cache_directory());
+
+        m_frame_constants_buffer = std::make_unique<opengl_uniform_buffer>(
+            m_state_cache,
+            frame_constants_binding_point,
+            sizeof(frame_constants));
+
+        m_sprite_shader = std::make_unique<opengl_shader_variants>(
+            "sprite.vert",
+            "sprite.frag",
+            std::vector<std::string> {
+                "MODEL_MATRIX", "TEXTURE_ARRAY", "ALPHA_TEST" },
+            m_program_cache.get(),
+            [this](opengl_shader_program& program,
+                   const shader_features features) {
+                // Samplers always read from texture unit 0, so set them
+                // only once.
+                program.apply_shader_program();
+                program.set_uniform(program.get_uniform("s_texture"), 0);
+                program.bind_uniform_block("frame_constants",
+                                           frame_constants_binding_point);
+
+                sprite_uniforms& uniforms = m_sprite_uniforms[features];
+                uniforms = sprite_uniforms {};
+
+                if (features & sprite_feature_model_matrix)
+                {
+                    uniforms.matrix = program.get_uniform("u_matrix");
+                    CHECK(uniforms.matrix.is_valid());
+                }
+                else
+                {
+                    uniforms.depth = program.get_uniform("u_depth");
+                    CHECK(uniforms.depth.is_valid());
+                }
+
+                // The program was used bypassing the state cache.
+                m_state_cache.invalidate();
+            });
+
+        // Forget all bindings made above bypassing the state cache.
+        m_state_cache.invalidate();
+
+        m_vertex_stream = std::make_unique<opengl_stream_buffer>(
+            m_state_cache, vertex_stream_frame_capacity);
+        m_index_stream = std::make_unique<opengl_stream_buffer>(
+            m_state_cache, index_stream_frame_capacity);
+
+        m_sprite_stream_vao
+            = create_stream_vertex_array(get_sprite_vertex_layout());
+        m_vertex_stream_vao = create_stream_vertex_array(get_vertex_layout());
+
+        m_state_cache.set_blend(true);
+        m_state_cache.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // Sprites of one layer share the depth value.
+        glDepthFunc(GL_LEQUAL);
+        opengl_check();
+
+        m_start_time = std::chrono::steady_clock::now();
+
+        if (m_offscreen)
+        {
+            create_offscreen_framebuffer();
+        }
+
+        glViewport(0, 0, m_viewport_width, m_viewport_height);
+        opengl_check();
+
+        ImGui_ImplSdlGL3_CreateDeviceObjects();
+
+        // ImGui changes GL state behind our back.
+        m_state_cache.invalidate();
+
+        m_gpu_profiler->begin_frame();
+    }
+
+    void engine_using_sdl::create_offscreen_framebuffer()
+    {
+        glGenRenderbuffers(static_cast<GLsizei>(m_offscreen_renderbuffers.size()),
+                           m_offscreen_renderbuffers.data());
+        opengl_check();
+
+        const std::array<GLenum, 2> formats { GL_RGBA8, GL_DEPTH_COMPONENT24 };
+
+        for (std::size_t i = 0; i < formats.size(); i++)
+        {
+            glBindRenderbuffer(GL_RENDERBUFFER, m_offscreen_renderbuffers[i]);
+            opengl_check();
+            glRenderbufferStorage(GL_RENDERBUFFER,
+                                  formats[i],
+                                  m_viewport_width,
+                                  m_viewport_height);
+            opengl_check();
+        }
+
+        glGenFramebuffers(1, &m_offscreen_framebuffer);
+        opengl_check();
+        glBindFramebuffer(GL_FRAMEBUFFER, m_offscreen_framebuffer);
+        opengl_check();
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER,
+                                  GL_COLOR_ATTACHMENT0,
+                                  GL_RENDERBUFFER,
+                                  m_offscreen_renderbuffers[0]);
+        opengl_check();
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER,
+                                  GL_DEPTH_ATTACHMENT,
+                                  GL_RENDERBUFFER,
+                                  m_offscreen_renderbuffers[1]);
+        opengl_check();
+
+        CHECK(glCheckFramebufferStatus(GL_FRAMEBUFFER)
+              == GL_FRAMEBUFFER_COMPLETE);
+
+        // Stays bound for the whole run, nothing else binds framebuffers.
+    }
+
+    void engine_using_sdl::destroy_offscreen_framebuffer()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        opengl_check();
+        glDeleteFramebuffers(1, &m_offscreen_framebuffer);
+        opengl_check();
+        glDeleteRenderbuffers(static_cast<GLsizei>(m_offscreen_renderbuffers.size()),
+                              m_offscreen_renderbuffers.data());
+        opengl_check();
 
-        SDL_PlayAudioDevice(m_audio_device_id);
+        m_offscreen_framebuffer = 0;
+        m_offscreen_renderbuffers.fill(0);
     }
 
     bool engine_using_sdl::process_input(event& event)
@@ -763,155 +2118,833 @@ namespace arci
                 event.device = event_from_device::none;
                 break;
 
-            default:
-                break;
+            default:
+                break;
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    bool engine_using_sdl::key_down(const enum keys key)
+    {
+        const auto iter = std::find_if(
+            keys.begin(),
+            keys.end(),
+            [key](const bind_key& bind) {
+                return bind.key == key;
+            });
+
+        if (iter != keys.end())
+        {
+            const Uint8* state = SDL_GetKeyboardState(nullptr);
+            const SDL_Scancode sdl_scan_code
+                = SDL_GetScancodeFromKey(iter->key_code);
+            return state[sdl_scan_code];
+        }
+
+        return false;
+    }
+
+    itexture* engine_using_sdl::create_texture(const std::string_view path)
+    {
+        opengl_texture* texture
+            = new opengl_texture { m_state_cache, m_texture_bytes };
+
+        auto pending_load
+            = std::make_shared<pending_texture_load<opengl_texture>>();
+        pending_load->texture = texture;
+        texture->set_pending_load(pending_load);
+
+        m_render_thread.record([texture] { texture->create_placeholder(); });
+
+        m_texture_workers->submit(
+            [this, pending_load, path = std::string { path }] {
+                auto image = std::make_shared<texture_image>(
+                    load_texture_image(path));
+
+                m_texture_uploads.push([pending_load, image] {
+                    if (pending_load->texture)
+                    {
+                        pending_load->texture->upload(*image);
+                    }
+                });
+            });
+
+        return texture;
+    }
+
+    void engine_using_sdl::destroy_texture(const itexture* const texture)
+    {
+        CHECK_NOTNULL(texture);
+        m_render_thread.record([texture] { delete texture; });
+    }
+
+    itexture_array* engine_using_sdl::create_texture_array(
+        const std::vector<std::string_view>& paths)
+    {
+        CHECK(!paths.empty());
+
+        opengl_texture_array* texture_array = new opengl_texture_array {
+            m_state_cache, m_texture_bytes, paths.size()
+        };
+
+        auto pending_load
+            = std::make_shared<pending_texture_load<opengl_texture_array>>();
+        pending_load->texture = texture_array;
+        texture_array->set_pending_load(pending_load);
+
+        m_render_thread.record(
+            [texture_array] { texture_array->create_placeholder(); });
+
+        std::vector<std::string> paths_copy(paths.begin(), paths.end());
+
+        m_texture_workers->submit([this,
+                                   pending_load,
+                                   paths_copy = std::move(paths_copy)] {
+            auto images = std::make_shared<std::vector<texture_image>>(
+                load_texture_images(paths_copy));
+
+            m_texture_uploads.push([pending_load, images] {
+                if (pending_load->texture)
+                {
+                    pending_load->texture->upload(*images);
+                }
+            });
+        });
+
+        return texture_array;
+    }
+
+    void engine_using_sdl::destroy_texture_array(
+        const itexture_array* const texture_array)
+    {
+        CHECK_NOTNULL(texture_array);
+        m_render_thread.record([texture_array] { delete texture_array; });
+    }
+
+    ivertex_buffer* engine_using_sdl::create_vertex_buffer(
+        const std::vector<triangle>& triangles)
+    {
+        return new vertex_buffer { m_render_thread,
+                                   m_state_cache,
+                                   triangles.data()->vertices.data(),
+                                   triangles.size() * 3,
+                                   get_vertex_layout() };
+    }
+
+    ivertex_buffer* engine_using_sdl::create_vertex_buffer(
+        const std::vector<vertex>& vertices)
+    {
+        return new vertex_buffer { m_render_thread,
+                                   m_state_cache,
+                                   vertices.data(),
+                                   vertices.size(),
+                                   get_vertex_layout() };
+    }
+
+    ivertex_buffer* engine_using_sdl::create_vertex_buffer(
+        const std::vector<sprite_vertex>& vertices)
+    {
+        return new vertex_buffer { m_render_thread,
+                                   m_state_cache,
+                                   vertices.data(),
+                                   vertices.size(),
+                                   get_sprite_vertex_layout() };
+    }
+
+    ivertex_buffer* engine_using_sdl::create_vertex_buffer(
+        const void* vertices,
+        const std::size_t vertices_number,
+        const vertex_layout& layout)
+    {
+        return new vertex_buffer { m_render_thread,
+                                   m_state_cache,
+                                   vertices,
+                                   vertices_number,
+                                   layout };
+    }
+
+    void engine_using_sdl::destroy_vertex_buffer(ivertex_buffer* buffer)
+    {
+        CHECK_NOTNULL(buffer);
+        m_render_thread.record([buffer] { delete buffer; });
+    }
+
+    i_index_buffer* engine_using_sdl::create_ebo(const std::vector<uint32_t>& indices)
+    {
+        return new index_buffer { m_render_thread, m_state_cache, indices };
+    }
+
+    void engine_using_sdl::destroy_ebo(i_index_buffer* buffer)
+    {
+        CHECK_NOTNULL(buffer);
+        m_render_thread.record([buffer] { delete buffer; });
+    }
+
+    iaudio_buffer* engine_using_sdl::create_audio_buffer(
+        const std::string_view audio_file_name)
+    {
+        audio_buffer* buffer = new audio_buffer { audio_file_name,
+                                                  m_desired_audio_spec,
+                                                  *m_audio_mixer };
+
+        if (buffer->stream)
+        {
+            m_audio_streams.push_back(buffer->stream.get());
+        }
+
+        return buffer;
+    }
+
+    void engine_using_sdl::destroy_audio_buffer(iaudio_buffer* buffer)
+    {
+        CHECK_NOTNULL(buffer);
+
+        const audio_stream* stream
+            = static_cast<audio_buffer*>(buffer)->stream.get();
+        m_audio_streams.erase(
+            std::remove(m_audio_streams.begin(), m_audio_streams.end(), stream),
+            m_audio_streams.end());
+
+        // Waits until the mixer doesn't use the samples.
+        delete buffer;
+    }
+
+    void engine_using_sdl::set_voice_stealing(const voice_stealing policy)
+    {
+        m_audio_mixer->set_voice_stealing(policy);
+    }
+
+    void engine_using_sdl::imgui_new_frame()
+    {
+        // Device objects are created by init_opengl(), so no GL calls
+        // are made here.
+        ImGui_ImplSdlGL3_NewFrame(m_window.get());
+    }
+
+    // Draw lists are owned by the ImGui context and rebuilt by the next
+    // frame, so the render thread gets their copy.
+    struct imgui_draw_snapshot
+    {
+        imgui_draw_snapshot() = default;
+        imgui_draw_snapshot(const imgui_draw_snapshot&) = delete;
+        imgui_draw_snapshot& operator=(const imgui_draw_snapshot&) = delete;
+
+        ~imgui_draw_snapshot()
+        {
+            for (ImDrawList* list : lists)
+            {
+                IM_DELETE(list);
+            }
+        }
+
+        ImDrawData draw_data {};
+        std::vector<ImDrawList*> lists {};
+    };
+
+    void engine_using_sdl::imgui_render()
+    {
+        ImGui::Render();
+
+        const ImDrawData* draw_data = ImGui::GetDrawData();
+
+        auto snapshot = std::make_shared<imgui_draw_snapshot>();
+        snapshot->draw_data = *draw_data;
+
+        for (int i = 0; i < draw_data->CmdListsCount; i++)
+        {
+            snapshot->lists.push_back(draw_data->CmdLists[i]->CloneOutput());
+        }
+
+        snapshot->draw_data.CmdLists = snapshot->lists.data();
+
+        m_render_thread.record([this, snapshot] {
+            m_gpu_profiler->begin_pass("imgui");
+            ImGui_ImplSdlGL3_RenderDrawLists(&snapshot->draw_data,
+                                             *m_vertex_stream,
+                                             *m_index_stream);
+            m_gpu_profiler->end_pass();
+
+            // ImGui backend changes GL state behind our back.
+            m_state_cache.invalidate();
+        });
+    }
+
+    void engine_using_sdl::render(ivertex_buffer* vertex_buffer,
+                                  i_index_buffer* ebo,
+                                  itexture* const texture)
+    {
+        m_render_thread.record([this, vertex_buffer, ebo, texture] {
+            draw(vertex_buffer, ebo, texture);
+        });
+    }
+
+    void engine_using_sdl::render(ivertex_buffer* vertex_buffer,
+                                  i_index_buffer* ebo,
+                                  itexture_array* const texture_array)
+    {
+        m_render_thread.record([this, vertex_buffer, ebo, texture_array] {
+            draw(vertex_buffer, ebo, texture_array, 0);
+        });
+    }
+
+    void engine_using_sdl::render(ivertex_buffer* vertex_buffer,
+                                  i_index_buffer* ebo,
+                                  itexture* const texture,
+                                  const glm::mediump_mat3& matrix)
+    {
+        m_render_thread.record([this, vertex_buffer, ebo, texture, matrix] {
+            draw(vertex_buffer, ebo, texture, matrix);
+        });
+    }
+
+    void engine_using_sdl::render(const std::vector<sprite_vertex>& vertices,
+                                  const std::vector<uint32_t>& indices,
+                                  itexture* const texture)
+    {
+        m_render_thread.record([this, vertices, indices, texture] {
+            draw(vertices, indices, texture, 0);
+        });
+    }
+
+    void engine_using_sdl::render(const std::vector<vertex>& vertices,
+                                  const std::vector<uint32_t>& indices,
+                                  itexture_array* const texture_array)
+    {
+        m_render_thread.record([this, vertices, indices, texture_array] {
+            draw(vertices, indices, texture_array, 0);
+        });
+    }
+
+    void engine_using_sdl::draw(ivertex_buffer* vertex_buffer,
+                                i_index_buffer* ebo,
+                                itexture* const texture)
+    {
+        use_sprite_shader(0);
+
+        texture->bind();
+        vertex_buffer->bind();
+        ebo->bind();
+
+        draw_elements(ebo);
+    }
+
+    void engine_using_sdl::draw(ivertex_buffer* vertex_buffer,
+                                i_index_buffer* ebo,
+                                itexture_array* const texture_array,
+                                const shader_features features)
+    {
+        use_sprite_shader(sprite_feature_texture_array | features);
+
+        texture_array->bind();
+        vertex_buffer->bind();
+        ebo->bind();
+
+        draw_elements(ebo);
+    }
+
+    void engine_using_sdl::draw(ivertex_buffer* vertex_buffer,
+                                i_index_buffer* ebo,
+                                itexture* const texture,
+                                const glm::mediump_mat3& matrix)
+    {
+        use_sprite_shader(sprite_feature_model_matrix)
+            .set_uniform(m_sprite_uniforms[sprite_feature_model_matrix].matrix,
+                         matrix);
+
+        texture->bind();
+        vertex_buffer->bind();
+        ebo->bind();
+
+        draw_elements(ebo);
+    }
+
+    void engine_using_sdl::submit(const sprite_command& command)
+    {
+        CHECK(command.texture || command.texture_array);
+        m_submitted_commands.push_back(command);
+    }
+
+    void engine_using_sdl::submit(const mesh_command& command)
+    {
+        CHECK_NOTNULL(command.vertex_buffer);
+        CHECK_NOTNULL(command.ebo);
+        CHECK_NOTNULL(command.texture_array);
+        m_submitted_commands.push_back(command);
+    }
+
+    void engine_using_sdl::execute_render_queue()
+    {
+        if (m_submitted_commands.empty())
+        {
+            return;
+        }
+
+        m_render_thread.record(
+            [this, commands = std::move(m_submitted_commands)] {
+                execute_queued_commands(commands);
+            });
+
+        m_submitted_commands.clear();
+    }
+
+    static shader_features get_blend_features(const blend_mode blend)
+    {
+        return blend == blend_mode::alpha_test ? sprite_feature_alpha_test : 0;
+    }
+
+    std::uint64_t engine_using_sdl::get_sort_key(
+        const queued_command& command) const
+    {
+        sort_key_fields fields {};
+
+        if (const auto* mesh = std::get_if<mesh_command>(&command))
+        {
+            fields.layer = mesh->layer;
+            fields.translucent = is_translucent(mesh->blend);
+            fields.depth = mesh->depth;
+            fields.program = static_cast<std::uint8_t>(
+                sprite_feature_texture_array | get_blend_features(mesh->blend));
+            fields.texture = static_cast<opengl_texture_array*>(
+                                 mesh->texture_array)
+                                 ->get_texture_id();
+            return make_sort_key(fields);
+        }
+
+        const sprite_command& spr = std::get<sprite_command>(command);
+
+        fields.layer = spr.layer;
+        fields.translucent = is_translucent(spr.blend);
+        fields.depth = spr.depth;
+        fields.program = static_cast<std::uint8_t>(get_blend_features(spr.blend));
+
+        if (spr.texture_array)
+        {
+            fields.program |= sprite_feature_texture_array;
+            fields.texture = static_cast<opengl_texture_array*>(
+                                 spr.texture_array)
+                                 ->get_texture_id();
+        }
+        else
+        {
+            fields.texture = static_cast<opengl_texture*>(spr.texture)
+                                 ->get_texture_id();
+        }
+
+        return make_sort_key(fields);
+    }
+
+    // Window depth of the command: every layer gets its own slice of
+    // [0, 1], higher layers are nearer to the viewer.
+    static float get_queue_depth(const std::uint8_t layer, const float depth)
+    {
+        constexpr float layers_number { 256.f };
+
+        return (layers_number - 1.f - layer
+                + std::clamp(depth, 0.f, 1.f) * 0.99f)
+            / layers_number;
+    }
+
+    void engine_using_sdl::execute_queued_commands(
+        const std::vector<queued_command>& commands)
+    {
+        // Keys use GL texture names, so they are built here.
+        for (std::size_t i = 0; i < commands.size(); i++)
+        {
+            m_render_queue.push(get_sort_key(commands[i]), i);
+        }
+
+        m_frame_stats.queue_state_changes_unsorted
+            += m_render_queue.count_state_changes();
+        m_render_queue.sort();
+        m_frame_stats.queue_state_changes_sorted
+            += m_render_queue.count_state_changes();
+
+        m_state_cache.set_depth_test(true);
+
+        // Commands are grouped by opacity and then by layer, every group
+        // is timed as a pass named after its layer.
+        std::optional<std::pair<bool, std::uint8_t>> pass {};
+
+        for (const render_queue::item& item : m_render_queue.get_items())
+        {
+            const queued_command& command = commands[item.command];
+
+            const auto* mesh = std::get_if<mesh_command>(&command);
+            const std::uint8_t layer = mesh
+                ? mesh->layer
+                : std::get<sprite_command>(command).layer;
+            const std::pair<bool, std::uint8_t> item_pass {
+                static_cast<bool>(item.key >> 63), layer
+            };
+
+            if (pass != item_pass)
+            {
+                close_sprite_batch();
+                pass = item_pass;
+                m_batch_pass = layer;
+            }
+
+            if (mesh)
+            {
+                close_sprite_batch();
+
+                queued_draw batch {};
+                batch.mesh = mesh;
+                batch.blend = mesh->blend;
+                batch.depth = get_queue_depth(mesh->layer, mesh->depth);
+                batch.pass = std::exchange(m_batch_pass, std::nullopt);
+                m_queued_draws.push_back(batch);
+                continue;
+            }
+
+            const sprite_command& spr = std::get<sprite_command>(command);
+            const float depth = get_queue_depth(spr.layer, spr.depth);
+
+            if (spr.texture != m_batch_texture
+                || spr.texture_array != m_batch_texture_array
+                || spr.blend != m_batch_blend
+                || depth != m_batch_depth)
+            {
+                close_sprite_batch();
+                m_batch_texture = spr.texture;
+                m_batch_texture_array = spr.texture_array;
+                m_batch_blend = spr.blend;
+                m_batch_depth = depth;
+            }
+
+            const float left = spr.x;
+            const float right = spr.x + spr.width;
+            const float top = spr.y;
+            const float bottom = spr.y + spr.height;
+
+            if (spr.texture_array)
+            {
+                const auto first
+                    = static_cast<uint32_t>(m_batch_vertices.size());
+                const float z = static_cast<float>(spr.texture_layer);
+
+                m_batch_vertices.insert(
+                    m_batch_vertices.end(),
+                    {
+                        { left, top, z, 0.f, 0.f, 0.f, 1.f, spr.u0, spr.v1 },
+                        { right, top, z, 0.f, 0.f, 0.f, 1.f, spr.u1, spr.v1 },
+                        { right, bottom, z, 0.f, 0.f, 0.f, 1.f, spr.u1, spr.v0 },
+                        { left, bottom, z, 0.f, 0.f, 0.f, 1.f, spr.u0, spr.v0 },
+                    });
+                m_batch_indices.insert(
+                    m_batch_indices.end(),
+                    { first, first + 1, first + 2, first, first + 3, first + 2 });
             }
+            else
+            {
+                const auto first
+                    = static_cast<uint32_t>(m_batch_sprite_vertices.size());
 
-            return true;
+                m_batch_sprite_vertices.insert(
+                    m_batch_sprite_vertices.end(),
+                    {
+                        make_sprite_vertex(left, top, spr.u0, spr.v1),
+                        make_sprite_vertex(right, top, spr.u1, spr.v1),
+                        make_sprite_vertex(right, bottom, spr.u1, spr.v0),
+                        make_sprite_vertex(left, bottom, spr.u0, spr.v0),
+                    });
+                m_batch_indices.insert(
+                    m_batch_indices.end(),
+                    { first, first + 1, first + 2, first, first + 3, first + 2 });
+            }
         }
 
-        return false;
+        close_sprite_batch();
+        draw_queued();
+
+        // Direct render() calls and ImGui expect blending without depth.
+        m_state_cache.set_depth_test(false);
+        m_state_cache.set_depth_mask(true);
+        apply_blend_mode(blend_mode::alpha);
+
+        m_render_queue.clear();
     }
 
-    bool engine_using_sdl::key_down(const enum keys key)
+    void engine_using_sdl::begin_layer_pass(const std::uint8_t layer)
     {
-        const auto iter = std::find_if(
-            keys.begin(),
-            keys.end(),
-            [key](const bind_key& bind) {
-                return bind.key == key;
-            });
-
-        if (iter != keys.end())
+        if (m_layer_names[layer].empty())
         {
-            const Uint8* state = SDL_GetKeyboardState(nullptr);
-            const SDL_Scancode sdl_scan_code
-                = SDL_GetScancodeFromKey(iter->key_code);
-            return state[sdl_scan_code];
+            m_layer_names[layer] = "layer " + std::to_string(layer);
         }
 
-        return false;
+        m_gpu_profiler->begin_pass(m_layer_names[layer]);
     }
 
-    itexture* engine_using_sdl::create_texture(const std::string_view path)
+    void engine_using_sdl::close_sprite_batch()
     {
-        itexture* texture = new opengl_texture {};
-        texture->load(path);
-        return texture;
-    }
+        if (m_batch_indices.size() > m_batch_first_index)
+        {
+            queued_draw batch {};
+            batch.texture = m_batch_texture;
+            batch.texture_array = m_batch_texture_array;
+            batch.blend = m_batch_blend;
+            batch.depth = m_batch_depth;
+            batch.first_index = m_batch_first_index;
+            batch.indices_number = m_batch_indices.size() - m_batch_first_index;
+            batch.pass = std::exchange(m_batch_pass, std::nullopt);
+            m_queued_draws.push_back(batch);
+        }
 
-    void engine_using_sdl::destroy_texture(const itexture* const texture)
-    {
-        CHECK_NOTNULL(texture);
-        delete texture;
+        m_batch_texture = nullptr;
+        m_batch_texture_array = nullptr;
+        m_batch_first_index = m_batch_indices.size();
     }
 
-    ivertex_buffer* engine_using_sdl::create_vertex_buffer(
-        const std::vector<triangle>& triangles)
+    void engine_using_sdl::draw_queued()
     {
-        return new vertex_buffer { triangles };
-    }
+        const std::size_t sprite_vertices_size
+            = m_batch_sprite_vertices.size() * sizeof(sprite_vertex);
+        const std::size_t vertices_size
+            = m_batch_vertices.size() * sizeof(vertex);
 
-    ivertex_buffer* engine_using_sdl::create_vertex_buffer(
-        const std::vector<vertex>& vertices)
-    {
-        return new vertex_buffer { vertices };
-    }
+        // Both pushes fit into the frame region, so the second one doesn't
+        // grow the buffer and invalidate the offset of the first one.
+        m_vertex_stream->reserve(sprite_vertices_size + sizeof(sprite_vertex)
+                                 + vertices_size + sizeof(vertex));
 
-    void engine_using_sdl::destroy_vertex_buffer(ivertex_buffer* buffer)
-    {
-        CHECK_NOTNULL(buffer);
-        delete buffer;
+        std::size_t sprite_vertices_offset {};
+        std::size_t vertices_offset {};
+        std::size_t indices_offset {};
+
+        if (sprite_vertices_size)
+        {
+            sprite_vertices_offset
+                = m_vertex_stream->push(m_batch_sprite_vertices.data(),
+                                        sprite_vertices_size,
+                                        sizeof(sprite_vertex));
+        }
+
+        if (vertices_size)
+        {
+            vertices_offset = m_vertex_stream->push(m_batch_vertices.data(),
+                                                    vertices_size,
+                                                    sizeof(vertex));
+        }
+
+        if (!m_batch_indices.empty())
+        {
+            indices_offset
+                = m_index_stream->push(m_batch_indices.data(),
+                                       m_batch_indices.size() * sizeof(uint32_t),
+                                       sizeof(uint32_t));
+        }
+
+        bool in_pass { false };
+
+        for (const queued_draw& batch : m_queued_draws)
+        {
+            if (batch.pass)
+            {
+                if (in_pass)
+                {
+                    m_gpu_profiler->end_pass();
+                }
+
+                in_pass = true;
+                begin_layer_pass(*batch.pass);
+            }
+
+            const shader_features features = get_blend_features(batch.blend);
+
+            apply_blend_mode(batch.blend);
+
+            if (batch.mesh)
+            {
+                set_depth(sprite_feature_texture_array | features, batch.depth);
+                draw(batch.mesh->vertex_buffer,
+                     batch.mesh->ebo,
+                     batch.mesh->texture_array,
+                     features);
+            }
+            else if (batch.texture_array)
+            {
+                set_depth(sprite_feature_texture_array | features, batch.depth);
+                use_sprite_shader(sprite_feature_texture_array | features);
+                batch.texture_array->bind();
+                draw_stream_range(m_vertex_stream_vao,
+                                  vertices_offset / sizeof(vertex),
+                                  indices_offset
+                                      + batch.first_index * sizeof(uint32_t),
+                                  batch.indices_number);
+            }
+            else
+            {
+                set_depth(features, batch.depth);
+                use_sprite_shader(features);
+                batch.texture->bind();
+                draw_stream_range(m_sprite_stream_vao,
+                                  sprite_vertices_offset / sizeof(sprite_vertex),
+                                  indices_offset
+                                      + batch.first_index * sizeof(uint32_t),
+                                  batch.indices_number);
+            }
+        }
+
+        if (in_pass)
+        {
+            m_gpu_profiler->end_pass();
+        }
+
+        m_queued_draws.clear();
+        m_batch_first_index = 0;
+        m_batch_sprite_vertices.clear();
+        m_batch_vertices.clear();
+        m_batch_indices.clear();
     }
 
-    i_index_buffer* engine_using_sdl::create_ebo(const std::vector<uint32_t>& indices)
+    void engine_using_sdl::apply_blend_mode(const blend_mode blend)
     {
-        return new index_buffer { indices };
+        switch (blend)
+        {
+        case blend_mode::opaque:
+        case blend_mode::alpha_test:
+            m_state_cache.set_blend(false);
+            m_state_cache.set_depth_mask(true);
+            break;
+        case blend_mode::alpha:
+            m_state_cache.set_blend(true);
+            m_state_cache.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            m_state_cache.set_depth_mask(false);
+            break;
+        case blend_mode::additive:
+            m_state_cache.set_blend(true);
+            m_state_cache.set_blend_func(GL_SRC_ALPHA, GL_ONE);
+            m_state_cache.set_depth_mask(false);
+            break;
+        }
     }
 
-    void engine_using_sdl::destroy_ebo(i_index_buffer* buffer)
+    opengl_shader_program& engine_using_sdl::use_sprite_shader(
+        const shader_features features)
     {
-        CHECK_NOTNULL(buffer);
-        delete buffer;
+        opengl_shader_program& program = m_sprite_shader->get(features);
+        m_state_cache.use_program(program.get_program_id());
+        return program;
     }
 
-    iaudio_buffer* engine_using_sdl::create_audio_buffer(
-        const std::string_view audio_file_name)
+    void engine_using_sdl::set_depth(const shader_features features,
+                                     const float depth)
     {
-        audio_buffer* buffer = new audio_buffer {
-            audio_file_name, m_desired_audio_spec
-        };
+        sprite_uniforms& uniforms = m_sprite_uniforms[features];
+        opengl_shader_program& program = m_sprite_shader->get(features);
 
+        if (uniforms.depth_value == depth)
         {
-            std::lock_guard<std::mutex> lock { audio_mutex };
-            m_sounds.push_back(buffer);
+            return;
         }
 
-        return buffer;
+        uniforms.depth_value = depth;
+        program.set_uniform(uniforms.depth, depth);
     }
 
-    void engine_using_sdl::destroy_audio_buffer(iaudio_buffer* buffer)
+    void engine_using_sdl::draw(const std::vector<sprite_vertex>& vertices,
+                                const std::vector<uint32_t>& indices,
+                                itexture* const texture,
+                                const shader_features features)
     {
-        CHECK_NOTNULL(buffer);
-        delete buffer;
+        use_sprite_shader(features);
+
+        texture->bind();
+
+        draw_streamed(m_sprite_stream_vao,
+                      vertices.data(),
+                      vertices.size(),
+                      sizeof(sprite_vertex),
+                      indices);
     }
 
-    void engine_using_sdl::imgui_new_frame()
+    void engine_using_sdl::draw(const std::vector<vertex>& vertices,
+                                const std::vector<uint32_t>& indices,
+                                itexture_array* const texture_array,
+                                const shader_features features)
     {
-        ImGui_ImplSdlGL3_NewFrame(m_window.get());
+        use_sprite_shader(sprite_feature_texture_array | features);
+
+        texture_array->bind();
+
+        draw_streamed(m_vertex_stream_vao,
+                      vertices.data(),
+                      vertices.size(),
+                      sizeof(vertex),
+                      indices);
     }
 
-    void engine_using_sdl::imgui_render()
+    void engine_using_sdl::draw_streamed(const GLuint vao,
+                                         const void* vertices,
+                                         const std::size_t vertices_number,
+                                         const std::size_t stride,
+                                         const std::vector<uint32_t>& indices)
     {
-        ImGui::Render();
-        ImGui_ImplSdlGL3_RenderDrawLists(ImGui::GetDrawData());
+        if (indices.empty())
+        {
+            return;
+        }
+
+        // Vertex offset is aligned to the stride, so the data can be
+        // addressed by the base vertex without touching attribute pointers.
+        const std::size_t vertices_offset
+            = m_vertex_stream->push(vertices, vertices_number * stride, stride);
+        const std::size_t indices_offset
+            = m_index_stream->push(indices.data(),
+                                   indices.size() * sizeof(uint32_t),
+                                   sizeof(uint32_t));
+
+        draw_stream_range(vao,
+                          vertices_offset / stride,
+                          indices_offset,
+                          indices.size());
     }
 
-    void engine_using_sdl::render(ivertex_buffer* vertex_buffer,
-                                  i_index_buffer* ebo,
-                                  itexture* const texture)
+    void engine_using_sdl::draw_stream_range(const GLuint vao,
+                                             const std::size_t base_vertex,
+                                             const std::size_t indices_offset,
+                                             const std::size_t indices_number)
     {
-        m_tex_no_math_program.apply_shader_program();
-
-        m_tex_no_math_program.set_uniform("s_texture");
+        m_state_cache.bind_vertex_array(vao);
 
-        texture->bind();
-        vertex_buffer->bind();
-        ebo->bind();
+        upload_frame_constants();
 
-        glEnableVertexAttribArray(0);
-        opengl_check();
-        glEnableVertexAttribArray(1);
-        opengl_check();
-        glEnableVertexAttribArray(2);
+        glDrawElementsBaseVertex(GL_TRIANGLES,
+                                 indices_number,
+                                 GL_UNSIGNED_INT,
+                                 reinterpret_cast<void*>(indices_offset),
+                                 base_vertex);
         opengl_check();
 
-        glVertexAttribPointer(
-            0,
-            2,
-            GL_FLOAT,
-            GL_FALSE,
-            sizeof(vertex),
-            reinterpret_cast<void*>(0));
-        opengl_check();
+        m_frame_stats.draw_calls++;
+        m_frame_stats.vertices += indices_number;
+    }
 
-        glVertexAttribPointer(
-            1,
-            4,
-            GL_FLOAT,
-            GL_FALSE,
-            sizeof(vertex),
-            reinterpret_cast<void*>(3 * sizeof(float)));
+    GLuint engine_using_sdl::create_stream_vertex_array(
+        const vertex_layout& layout)
+    {
+        GLuint vao {};
+        glGenVertexArrays(1, &vao);
         opengl_check();
 
-        glVertexAttribPointer(
-            2,
-            2,
-            GL_FLOAT,
-            GL_FALSE,
-            sizeof(vertex),
-            reinterpret_cast<void*>(7 * sizeof(float)));
-        opengl_check();
+        m_state_cache.bind_vertex_array(vao);
+        m_state_cache.bind_buffer(GL_ARRAY_BUFFER,
+                                  m_vertex_stream->get_buffer_id());
+        m_state_cache.bind_buffer(GL_ELEMENT_ARRAY_BUFFER,
+                                  m_index_stream->get_buffer_id());
+
+        set_vertex_attributes(layout);
+
+        return vao;
+    }
+
+    void engine_using_sdl::draw_elements(i_index_buffer* ebo)
+    {
+        upload_frame_constants();
 
         glDrawElements(GL_TRIANGLES,
                        ebo->get_indices_number(),
@@ -919,101 +2952,184 @@ namespace arci
                        0);
         opengl_check();
 
-        glDisableVertexAttribArray(0);
-        opengl_check();
+        m_frame_stats.draw_calls++;
+        m_frame_stats.vertices += ebo->get_indices_number();
+    }
 
-        glDisableVertexAttribArray(1);
-        opengl_check();
+    void engine_using_sdl::swap_buffers()
+    {
+        execute_render_queue();
 
-        glDisableVertexAttribArray(2);
-        opengl_check();
+        m_render_thread.record([this] { present(); });
+
+        // Game thread goes on with the next frame while this one is drawn.
+        m_render_thread.submit_frame();
     }
 
-    void engine_using_sdl::render(ivertex_buffer* vertex_buffer,
-                                  i_index_buffer* ebo,
-                                  itexture* const texture,
-                                  const glm::mediump_mat3& matrix)
+    void engine_using_sdl::present()
     {
-        m_textured_triangle_program.apply_shader_program();
+        opengl_check_frame();
 
-        m_textured_triangle_program.set_uniform("u_matrix", matrix);
-        m_textured_triangle_program.set_uniform("s_texture");
+        m_gpu_profiler->end_frame();
 
-        texture->bind();
-        vertex_buffer->bind();
-        ebo->bind();
+        // Fence everything streamed during the frame.
+        m_vertex_stream->end_frame();
+        m_index_stream->end_frame();
+        m_frame_constants_buffer->end_frame();
 
-        glEnableVertexAttribArray(0);
-        opengl_check();
-        glEnableVertexAttribArray(1);
-        opengl_check();
-        glEnableVertexAttribArray(2);
-        opengl_check();
+        const std::chrono::duration<float, std::milli> submit_time
+            = std::chrono::steady_clock::now()
+            - m_render_thread.get_frame_start();
+        m_frame_stats.submit_time_ms = submit_time.count();
 
-        glVertexAttribPointer(
-            0,
-            2,
-            GL_FLOAT,
-            GL_FALSE,
-            sizeof(vertex),
-            reinterpret_cast<void*>(0));
-        opengl_check();
+        if (m_offscreen)
+        {
+            // Nothing to show, just make the driver start on the frame.
+            glFlush();
+            opengl_check();
+        }
+        else
+        {
+            CHECK(!SDL_GL_SwapWindow(m_window.get()));
+        }
 
-        glVertexAttribPointer(
-            1,
-            4,
-            GL_FLOAT,
-            GL_FALSE,
-            sizeof(vertex),
-            reinterpret_cast<void*>(3 * sizeof(float)));
-        opengl_check();
+        const opengl_state_cache::statistics& state_statistics
+            = m_state_cache.get_statistics();
+        m_frame_stats.state_calls_issued = state_statistics.calls_issued;
+        m_frame_stats.state_calls_avoided = state_statistics.calls_avoided;
+        m_frame_stats.texture_bytes = m_texture_bytes;
 
-        glVertexAttribPointer(
-            2,
-            2,
-            GL_FLOAT,
-            GL_FALSE,
-            sizeof(vertex),
-            reinterpret_cast<void*>(7 * sizeof(float)));
-        opengl_check();
+        {
+            std::lock_guard<std::mutex> lock { m_stats_mutex };
+            m_last_frame_stats = m_frame_stats;
+        }
 
-        glDrawElements(GL_TRIANGLES,
-                       ebo->get_indices_number(),
-                       GL_UNSIGNED_INT,
-                       0);
-        opengl_check();
+        m_frame_stats = render_stats {};
+        m_state_cache.reset_statistics();
 
-        glDisableVertexAttribArray(0);
+        glClearColor(0.f, 1.f, 1.f, 1.f);
         opengl_check();
-
-        glDisableVertexAttribArray(1);
+        // Depth writes should be on, or depth buffer is not cleared.
+        m_state_cache.set_depth_mask(true);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         opengl_check();
 
-        glDisableVertexAttribArray(2);
-        opengl_check();
+        m_frame_constants_dirty = true;
+
+        // Results of the frame which used this slot `frames_latency`
+        // frames ago are read here.
+        m_gpu_profiler->begin_frame();
+
+        m_texture_uploads.execute(texture_upload_frame_budget);
     }
 
-    void engine_using_sdl::swap_buffers()
+    void engine_using_sdl::set_camera(const camera2d& camera)
     {
-        CHECK(!SDL_GL_SwapWindow(m_window.get()));
+        m_camera = camera;
 
-        glClearColor(0.f, 1.f, 1.f, 1.f);
-        opengl_check();
-        glClear(GL_COLOR_BUFFER_BIT);
-        opengl_check();
+        m_render_thread.record([this, camera] {
+            m_frame_camera = camera;
+            m_frame_constants_dirty = true;
+        });
+    }
+
+    camera2d engine_using_sdl::get_camera() const noexcept
+    {
+        return m_camera;
+    }
+
+    // Frame constants are uploaded lazily before the first draw of
+    // the frame (or the first draw after the camera is changed).
+    void engine_using_sdl::upload_frame_constants()
+    {
+        if (!m_frame_constants_dirty)
+        {
+            return;
+        }
+
+        m_frame_constants_dirty = false;
+
+        const std::chrono::duration<float> time
+            = std::chrono::steady_clock::now() - m_start_time;
+
+        const glm::mediump_mat3 view_projection
+            = get_view_projection(m_frame_camera);
+
+        frame_constants constants {};
+
+        for (int column = 0; column < 3; column++)
+        {
+            for (int row = 0; row < 3; row++)
+            {
+                constants.view_projection[column * 4 + row]
+                    = view_projection[column][row];
+            }
+        }
+
+        constants.resolution[0] = static_cast<float>(m_screen_width);
+        constants.resolution[1] = static_cast<float>(m_screen_height);
+        constants.time = time.count();
+
+        m_frame_constants_buffer->update(&constants, sizeof(constants));
     }
 
     void engine_using_sdl::uninit()
     {
         CHECK(SDL_PauseAudioDevice(m_audio_device_id) == 0);
         SDL_CloseAudioDevice(m_audio_device_id);
+        m_audio_mixer->set_device(0);
         imgui_uninit();
+
+        // Loads still in flight are dropped.
+        m_texture_workers.reset();
+
+        // Resources destroyed by the game are deleted here as well.
+        m_render_thread.stop([this] { uninit_opengl(); });
+
+        // Sounds may outlive the engine, but their streaming threads
+        // read the asset pack.
+        for (audio_stream* stream : m_audio_streams)
+        {
+            stream->stop();
+        }
+
+        // Nothing reads packed assets anymore.
+        unmount_asset_pack();
+
         SDL_Quit();
     }
 
+    void engine_using_sdl::uninit_opengl()
+    {
+        m_texture_uploads.clear();
+        m_gpu_profiler.reset();
+
+        if (m_offscreen)
+        {
+            destroy_offscreen_framebuffer();
+        }
+
+        print_gl_error_report();
+
+        m_frame_constants_buffer.reset();
+        m_state_cache.delete_vertex_array(m_sprite_stream_vao);
+        m_state_cache.delete_vertex_array(m_vertex_stream_vao);
+        m_vertex_stream.reset();
+        m_index_stream.reset();
+
+        if (m_render_thread.is_threaded())
+        {
+            // Let the context be deleted by the game thread.
+            CHECK(SDL_GL_MakeCurrent(m_window.get(), nullptr) == 0);
+        }
+    }
+
     void engine_using_sdl::imgui_uninit()
     {
-        ImGui_ImplSdlGL3_Shutdown();
+        m_render_thread.record([] { ImGui_ImplSdlGL3_InvalidateDeviceObjects(); });
+        m_render_thread.flush();
+
+        ImGui::DestroyContext();
     }
 
     std::pair<size_t, size_t>
@@ -1022,6 +3138,26 @@ namespace arci
         return { m_screen_width, m_screen_height };
     }
 
+    render_stats engine_using_sdl::get_render_stats() const noexcept
+    {
+        std::lock_guard<std::mutex> lock { m_stats_mutex };
+        return m_last_frame_stats;
+    }
+
+    void engine_using_sdl::set_layer_name(const std::uint8_t layer,
+                                          const std::string_view name)
+    {
+        m_render_thread.record([this, layer, name = std::string { name }] {
+            m_layer_names[layer] = name;
+        });
+    }
+
+    gpu_timings engine_using_sdl::get_gpu_timings() const
+    {
+        // Profiler is created by init(), which waits for the render thread.
+        return m_gpu_profiler->get_timings();
+    }
+
     std::uint64_t engine_using_sdl::get_time_since_epoch() const
     {
         return std::chrono::system_clock::now().time_since_epoch().count();
@@ -1049,64 +3185,8 @@ namespace arci
                                               Uint8* stream,
                                               int len)
     {
-        std::lock_guard<std::mutex> lock { audio_mutex };
-
-        std::memset(stream, 0, len);
-
         engine_using_sdl* engine = static_cast<engine_using_sdl*>(userdata);
-
-#if defined(WIN32) || defined(_WIN32) || defined(__WIN32) && !defined(__CYGWIN__)
-        constexpr int32_t AUDIO_FORMAT = SDL_AUDIO_F32LSB;
-#else
-        constexpr int32_t AUDIO_FORMAT = SDL_AUDIO_S16LSB;
-#endif
-
-        for (audio_buffer* sound : engine->m_sounds)
-        {
-            if (sound->is_running)
-            {
-                std::size_t stream_len { static_cast<std::size_t>(len) };
-
-                const Uint8* start_buffer
-                    = sound->buffer
-                    + sound->current_position;
-
-                const std::size_t bytes_left_in_buffer
-                    = sound->size
-                    - sound->current_position;
-
-                if (bytes_left_in_buffer <= stream_len)
-                {
-                    SDL_MixAudioFormat(stream,
-                                       start_buffer,
-                                       AUDIO_FORMAT,
-                                       bytes_left_in_buffer,
-                                       SDL_MIX_MAXVOLUME);
-                    sound->current_position += bytes_left_in_buffer;
-                }
-                else
-                {
-                    SDL_MixAudioFormat(stream,
-                                       start_buffer,
-                                       AUDIO_FORMAT,
-                                       stream_len,
-                                       SDL_MIX_MAXVOLUME);
-                    sound->current_position += stream_len;
-                }
-
-                if (sound->current_position == sound->size)
-                {
-                    if (sound->mode == audio_buffer::running_mode::for_ever)
-                    {
-                        sound->current_position = 0;
-                    }
-                    else
-                    {
-                        sound->is_running = false;
-                    }
-                }
-            }
-        }
+        engine->m_audio_mixer->mix(stream, static_cast<std::size_t>(len));
     }
 
     ///////////////////////////////////////////////////////////////////////////////
@@ -1120,26 +3200,51 @@ namespace arci
 
         engine_instance(engine_instance&&) = delete;
 
-        static iengine* get_instance()
+        static iengine* get_instance(const engine_backend backend)
         {
             CHECK(!m_is_existing);
             m_is_existing = true;
-            return m_engine;
+
+            if (backend == engine_backend::null)
+            {
+                return create_null_engine();
+            }
+
+            return new engine_using_sdl { backend
+                                          == engine_backend::offscreen };
         }
 
     private:
-        static iengine* m_engine;
         static bool m_is_existing;
     };
 
-    iengine* engine_instance::m_engine = new engine_using_sdl {};
     bool engine_instance::m_is_existing = false;
 
     ///////////////////////////////////////////////////////////////////////////////
 
-    iengine* engine_create()
+    engine_backend get_default_engine_backend()
+    {
+        const char* backend = std::getenv("ARCI_ENGINE");
+
+        if (!backend || std::string_view { backend } == "sdl")
+        {
+            return engine_backend::sdl;
+        }
+
+        if (std::string_view { backend } == "offscreen")
+        {
+            return engine_backend::offscreen;
+        }
+
+        CHECK(std::string_view { backend } == "null");
+        return engine_backend::null;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    iengine* engine_create(const engine_backend backend)
     {
-        return engine_instance::get_instance();
+        return engine_instance::get_instance(backend);
     }
 
     ///////////////////////////////////////////////////////////////////////////////
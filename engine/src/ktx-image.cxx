@@ -0,0 +1,379 @@
+#include "ktx-image.hxx"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    static constexpr std::array<std::uint8_t, 12> ktx1_identifier {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+    };
+
+    static constexpr std::array<std::uint8_t, 12> ktx2_identifier {
+        0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+    };
+
+    // ASTC block sizes in the order of both GL and Vulkan format enums.
+    static constexpr std::array<std::array<std::uint32_t, 2>, 14> astc_blocks {
+        { { 4, 4 },
+          { 5, 4 },
+          { 5, 5 },
+          { 6, 5 },
+          { 6, 6 },
+          { 8, 5 },
+          { 8, 6 },
+          { 8, 8 },
+          { 10, 5 },
+          { 10, 6 },
+          { 10, 8 },
+          { 10, 10 },
+          { 12, 10 },
+          { 12, 12 } }
+    };
+
+    struct format_info
+    {
+        ktx_format_family family { ktx_format_family::uncompressed };
+        std::uint32_t block_width { 1 };
+        std::uint32_t block_height { 1 };
+        std::uint32_t block_bytes {};
+        GLenum format {};
+        GLenum type {};
+    };
+
+    static bool get_format_info(const GLenum internal_format, format_info& info)
+    {
+        switch (internal_format)
+        {
+        case GL_RGBA8:
+        case GL_SRGB8_ALPHA8:
+            info = { ktx_format_family::uncompressed,
+                     1,
+                     1,
+                     4,
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE };
+            return true;
+        case GL_COMPRESSED_RGB8_ETC2:
+        case GL_COMPRESSED_SRGB8_ETC2:
+        case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+        case GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+            info = { ktx_format_family::etc2, 4, 4, 8, 0, 0 };
+            return true;
+        case GL_COMPRESSED_RGBA8_ETC2_EAC:
+        case GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC:
+            info = { ktx_format_family::etc2, 4, 4, 16, 0, 0 };
+            return true;
+        default:
+            break;
+        }
+
+        for (const GLenum first : { GL_COMPRESSED_RGBA_ASTC_4x4,
+                                    GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4 })
+        {
+            if (internal_format >= first
+                && internal_format < first + astc_blocks.size())
+            {
+                const auto& block = astc_blocks[internal_format - first];
+                info = { ktx_format_family::astc, block[0], block[1], 16, 0, 0 };
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Returns 0 for formats without GL ES equivalent.
+    static GLenum get_internal_format(const std::uint32_t vk_format)
+    {
+        constexpr std::uint32_t vk_r8g8b8a8_unorm { 37 };
+        constexpr std::uint32_t vk_r8g8b8a8_srgb { 43 };
+        constexpr std::uint32_t vk_etc2_first { 147 };
+        constexpr std::uint32_t vk_astc_first { 157 };
+
+        if (vk_format == vk_r8g8b8a8_unorm)
+        {
+            return GL_RGBA8;
+        }
+
+        if (vk_format == vk_r8g8b8a8_srgb)
+        {
+            return GL_SRGB8_ALPHA8;
+        }
+
+        // ETC2 RGB, RGB A1 and RGBA, each as UNORM and SRGB.
+        if (vk_format >= vk_etc2_first && vk_format < vk_etc2_first + 6)
+        {
+            return GL_COMPRESSED_RGB8_ETC2 + (vk_format - vk_etc2_first);
+        }
+
+        // ASTC blocks, each as UNORM and SRGB.
+        if (vk_format >= vk_astc_first
+            && vk_format < vk_astc_first + astc_blocks.size() * 2)
+        {
+            const std::uint32_t index = vk_format - vk_astc_first;
+            const GLenum first = index % 2 ? GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4
+                                           : GL_COMPRESSED_RGBA_ASTC_4x4;
+            return first + index / 2;
+        }
+
+        return 0;
+    }
+
+    template <typename T>
+    static bool read_value(const ktx_image& image,
+                           const std::size_t offset,
+                           T& value)
+    {
+        if (offset > image.content_size
+            || image.content_size - offset < sizeof(T))
+        {
+            return false;
+        }
+
+        // KTX data is little-endian, as all platforms we run on.
+        std::memcpy(&value, image.content + offset, sizeof(T));
+        return true;
+    }
+
+    static bool has_identifier(const ktx_image& image,
+                               const std::array<std::uint8_t, 12>& identifier)
+    {
+        return image.content_size >= identifier.size()
+            && std::equal(identifier.begin(),
+                          identifier.end(),
+                          image.content);
+    }
+
+    // Every level should hold exactly the blocks of all its layers.
+    static bool fill_levels(const std::vector<std::uint64_t>& offsets,
+                            const std::vector<std::uint64_t>& sizes,
+                            const format_info& info,
+                            ktx_image& image)
+    {
+        image.levels.clear();
+
+        for (std::size_t i = 0; i < offsets.size(); i++)
+        {
+            ktx_level level {};
+            level.width = std::max<std::uint32_t>(image.width >> i, 1);
+            level.height = std::max<std::uint32_t>(image.height >> i, 1);
+
+            const std::uint64_t blocks_x
+                = (level.width + info.block_width - 1) / info.block_width;
+            const std::uint64_t blocks_y
+                = (level.height + info.block_height - 1) / info.block_height;
+            const std::uint64_t expected_size
+                = blocks_x * blocks_y * info.block_bytes * image.layers;
+
+            if (sizes[i] != expected_size || offsets[i] > image.content_size
+                || image.content_size - offsets[i] < sizes[i])
+            {
+                return false;
+            }
+
+            level.offset = static_cast<std::size_t>(offsets[i]);
+            level.size = static_cast<std::size_t>(sizes[i]);
+            image.levels.push_back(level);
+        }
+
+        return !image.levels.empty();
+    }
+
+    static bool set_format(const GLenum internal_format,
+                           ktx_image& image,
+                           format_info& info)
+    {
+        if (!get_format_info(internal_format, info))
+        {
+            return false;
+        }
+
+        image.family = info.family;
+        image.internal_format = internal_format;
+        image.format = info.format;
+        image.type = info.type;
+
+        return true;
+    }
+
+    static bool parse_ktx1(ktx_image& image)
+    {
+        // Fields after the identifier, all 32-bit.
+        enum field
+        {
+            endianness,
+            gl_type,
+            gl_type_size,
+            gl_format,
+            gl_internal_format,
+            gl_base_internal_format,
+            pixel_width,
+            pixel_height,
+            pixel_depth,
+            array_elements,
+            faces,
+            mipmap_levels,
+            key_value_bytes,
+            fields_number
+        };
+
+        std::array<std::uint32_t, fields_number> header {};
+
+        for (std::size_t i = 0; i < header.size(); i++)
+        {
+            if (!read_value(image, 12 + i * 4, header[i]))
+            {
+                return false;
+            }
+        }
+
+        format_info info {};
+
+        if (header[endianness] != 0x04030201 || header[pixel_depth] > 1
+            || header[faces] != 1 || header[pixel_width] == 0
+            || header[pixel_height] == 0
+            || !set_format(header[gl_internal_format], image, info))
+        {
+            return false;
+        }
+
+        image.width = header[pixel_width];
+        image.height = header[pixel_height];
+        image.layers = std::max<std::uint32_t>(header[array_elements], 1);
+
+        const std::uint32_t levels_number
+            = std::max<std::uint32_t>(header[mipmap_levels], 1);
+
+        std::vector<std::uint64_t> offsets {};
+        std::vector<std::uint64_t> sizes {};
+        std::uint64_t offset = 12 + fields_number * 4 + header[key_value_bytes];
+
+        for (std::uint32_t i = 0; i < levels_number; i++)
+        {
+            std::uint32_t image_size {};
+
+            if (!read_value(image, offset, image_size))
+            {
+                return false;
+            }
+
+            offsets.push_back(offset + 4);
+            sizes.push_back(image_size);
+
+            // Levels are padded to 4 bytes.
+            offset += 4 + ((image_size + 3u) & ~3u);
+        }
+
+        return fill_levels(offsets, sizes, info, image);
+    }
+
+    static bool parse_ktx2(ktx_image& image)
+    {
+        enum field
+        {
+            vk_format,
+            type_size,
+            pixel_width,
+            pixel_height,
+            pixel_depth,
+            layer_count,
+            face_count,
+            level_count,
+            supercompression_scheme,
+            fields_number
+        };
+
+        std::array<std::uint32_t, fields_number> header {};
+
+        for (std::size_t i = 0; i < header.size(); i++)
+        {
+            if (!read_value(image, 12 + i * 4, header[i]))
+            {
+                return false;
+            }
+        }
+
+        format_info info {};
+
+        if (header[pixel_depth] > 1 || header[face_count] != 1
+            || header[supercompression_scheme] != 0
+            || header[pixel_width] == 0 || header[pixel_height] == 0
+            || !set_format(get_internal_format(header[vk_format]), image, info))
+        {
+            return false;
+        }
+
+        image.width = header[pixel_width];
+        image.height = header[pixel_height];
+        image.layers = std::max<std::uint32_t>(header[layer_count], 1);
+
+        const std::uint32_t levels_number
+            = std::max<std::uint32_t>(header[level_count], 1);
+
+        // Level index follows the header and the index of DFD, KVD and SGD.
+        constexpr std::size_t level_index_offset { 80 };
+        constexpr std::size_t level_index_entry_size { 24 };
+
+        std::vector<std::uint64_t> offsets(levels_number);
+        std::vector<std::uint64_t> sizes(levels_number);
+
+        for (std::uint32_t i = 0; i < levels_number; i++)
+        {
+            const std::size_t entry
+                = level_index_offset + i * level_index_entry_size;
+
+            if (!read_value(image, entry, offsets[i])
+                || !read_value(image, entry + 8, sizes[i]))
+            {
+                return false;
+            }
+        }
+
+        return fill_levels(offsets, sizes, info, image);
+    }
+
+    bool parse_ktx(std::vector<std::uint8_t> content, ktx_image& image)
+    {
+        if (!parse_ktx(content.data(), content.size(), image))
+        {
+            return false;
+        }
+
+        // Moving the vector keeps its buffer, so levels stay valid.
+        image.storage = std::move(content);
+        return true;
+    }
+
+    bool parse_ktx(const std::uint8_t* content,
+                   const std::size_t size,
+                   ktx_image& image)
+    {
+        image = ktx_image {};
+        image.content = content;
+        image.content_size = size;
+
+        if (has_identifier(image, ktx1_identifier))
+        {
+            return parse_ktx1(image);
+        }
+
+        if (has_identifier(image, ktx2_identifier))
+        {
+            return parse_ktx2(image);
+        }
+
+        return false;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,692 @@
+#include "null-engine.hxx"
+#include "render-queue.hxx"
+
+#include "helper.hxx"
+
+#include <imgui.h>
+
+#include <stb_image.h>
+
+#include <cstdint>
+#include <string>
+#include <variant>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    struct null_vertex_buffer : public ivertex_buffer
+    {
+        explicit null_vertex_buffer(const std::size_t vertices_number)
+            : vertices_number { vertices_number }
+        {
+        }
+
+        void bind() override
+        {
+        }
+
+        std::size_t get_vertices_number() const override
+        {
+            return vertices_number;
+        }
+
+        void update(const std::size_t first_vertex,
+                    const void* vertices,
+                    const std::size_t number) override
+        {
+            CHECK_NOTNULL(vertices);
+            CHECK(first_vertex + number <= vertices_number);
+        }
+
+        std::size_t vertices_number {};
+    };
+
+    struct null_index_buffer : public i_index_buffer
+    {
+        explicit null_index_buffer(const std::vector<uint32_t>& indices)
+            : indices { indices }
+        {
+        }
+
+        void bind() override
+        {
+        }
+
+        uint32_t* data() override
+        {
+            return indices.data();
+        }
+
+        std::size_t get_indices_number() const override
+        {
+            return indices.size();
+        }
+
+        std::vector<uint32_t> indices {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Images are not decoded, only their headers are read to know how
+    // much memory RGBA8 textures would take.
+    static std::size_t get_image_bytes(const std::string_view path)
+    {
+        int width {}, height {}, channels {};
+        CHECK(stbi_info(std::string { path }.c_str(),
+                        &width,
+                        &height,
+                        &channels));
+
+        return static_cast<std::size_t>(width) * height * 4;
+    }
+
+    struct null_texture : public itexture
+    {
+        explicit null_texture(const std::uint32_t id)
+            : id { id }
+        {
+        }
+
+        void load(const std::string_view path) override
+        {
+            bytes = get_image_bytes(path);
+        }
+
+        void bind() override
+        {
+        }
+
+        std::size_t get_memory_size() const override
+        {
+            return bytes;
+        }
+
+        std::uint32_t id {};
+        std::size_t bytes {};
+    };
+
+    struct null_texture_array : public itexture_array
+    {
+        explicit null_texture_array(const std::uint32_t id)
+            : id { id }
+        {
+        }
+
+        void load(const std::vector<std::string_view>& paths) override
+        {
+            CHECK(!paths.empty());
+
+            layers_number = paths.size();
+            bytes = 0;
+
+            for (const std::string_view path : paths)
+            {
+                bytes += get_image_bytes(path);
+            }
+        }
+
+        void bind() override
+        {
+        }
+
+        std::size_t get_layers_number() const override
+        {
+            return layers_number;
+        }
+
+        std::size_t get_memory_size() const override
+        {
+            return bytes;
+        }
+
+        std::uint32_t id {};
+        std::size_t layers_number {};
+        std::size_t bytes {};
+    };
+
+    struct null_audio_buffer : public iaudio_buffer
+    {
+        explicit null_audio_buffer(std::size_t& sounds_played)
+            : sounds_played { sounds_played }
+        {
+        }
+
+        voice_id play(const running_mode, const voice_parameters&) override
+        {
+            sounds_played++;
+            return static_cast<voice_id>(sounds_played);
+        }
+
+        void stop() override
+        {
+        }
+
+        void stop(const voice_id) override
+        {
+        }
+
+        void set_gain(const float) override
+        {
+        }
+
+        void set_voice_parameters(const voice_id,
+                                  const voice_parameters&) override
+        {
+        }
+
+        // Samples are never decoded.
+        std::size_t get_memory_size() const override
+        {
+            return 0;
+        }
+
+        std::size_t& sounds_played;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    class engine_null final : public iengine
+    {
+    public:
+        void init() override;
+        bool process_input(event& event) override;
+        bool key_down(const enum keys key) override;
+        void imgui_new_frame() override;
+        void imgui_render() override;
+
+        void set_camera(const camera2d& camera) override;
+        camera2d get_camera() const noexcept override;
+
+        void render(ivertex_buffer* vertex_buffer,
+                    i_index_buffer* ebo,
+                    itexture* const texture,
+                    const glm::mediump_mat3& matrix) override;
+
+        void render(ivertex_buffer* vertex_buffer,
+                    i_index_buffer* ebo,
+                    itexture* const texture) override;
+
+        void render(ivertex_buffer* vertex_buffer,
+                    i_index_buffer* ebo,
+                    itexture_array* const texture_array) override;
+
+        void render(const std::vector<sprite_vertex>& vertices,
+                    const std::vector<uint32_t>& indices,
+                    itexture* const texture) override;
+
+        void render(const std::vector<vertex>& vertices,
+                    const std::vector<uint32_t>& indices,
+                    itexture_array* const texture_array) override;
+
+        void submit(const sprite_command& command) override;
+        void submit(const mesh_command& command) override;
+        void execute_render_queue() override;
+
+        ivertex_buffer* create_vertex_buffer(
+            const std::vector<triangle>& triangles) override;
+        ivertex_buffer* create_vertex_buffer(
+            const std::vector<vertex>& vertices) override;
+        ivertex_buffer* create_vertex_buffer(
+            const std::vector<sprite_vertex>& vertices) override;
+        ivertex_buffer* create_vertex_buffer(
+            const void* vertices,
+            const std::size_t vertices_number,
+            const vertex_layout& layout) override;
+        void destroy_vertex_buffer(ivertex_buffer* buffer) override;
+
+        i_index_buffer* create_ebo(
+            const std::vector<uint32_t>& indices) override;
+        void destroy_ebo(i_index_buffer* buffer) override;
+
+        itexture* create_texture(const std::string_view path) override;
+        void destroy_texture(const itexture* const texture) override;
+
+        itexture_array* create_texture_array(
+            const std::vector<std::string_view>& paths) override;
+        void destroy_texture_array(
+            const itexture_array* const texture_array) override;
+
+        iaudio_buffer* create_audio_buffer(
+            const std::string_view audio_file_name) override;
+        void destroy_audio_buffer(iaudio_buffer* buffer) override;
+
+        void set_voice_stealing(const voice_stealing) override
+        {
+        }
+
+        void uninit() override;
+        void imgui_uninit() override;
+        void swap_buffers() override;
+        std::pair<size_t, size_t> get_screen_resolution() const noexcept override;
+        render_stats get_render_stats() const noexcept override;
+
+        void set_layer_name(const std::uint8_t layer,
+                            const std::string_view name) override;
+        gpu_timings get_gpu_timings() const override;
+
+    private:
+        using queued_command = std::variant<sprite_command, mesh_command>;
+
+        // Sprite shader variants used by the SDL engine for queued
+        // commands (values are their feature masks).
+        enum class queue_program : std::uint8_t
+        {
+            sprite = 0,
+            texture_array = 1u << 1,
+            alpha_test = 1u << 2
+        };
+
+        static std::uint8_t get_queue_program(const blend_mode blend);
+
+        std::uint64_t get_sort_key(const queued_command& command) const;
+        void count_draw(const std::size_t vertices_number);
+
+        static constexpr std::size_t screen_width { 1280 };
+        static constexpr std::size_t screen_height { 720 };
+
+        camera2d m_camera {};
+
+        std::vector<queued_command> m_queued_commands {};
+        render_queue m_render_queue {};
+
+        // Texture ids play the role of GL texture names in sort keys.
+        std::uint32_t m_next_texture_id { 1 };
+        std::size_t m_texture_bytes {};
+
+        render_stats m_frame_stats {};
+        render_stats m_last_frame_stats {};
+    };
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    void engine_null::init()
+    {
+        m_camera = camera2d {
+            screen_width / 2.f,
+            screen_height / 2.f,
+            1.f,
+            0.f,
+            static_cast<float>(screen_width),
+            static_cast<float>(screen_height),
+        };
+
+        // Game systems build their windows with ImGui, so the context is
+        // needed even though nothing is drawn.
+        ImGui::CreateContext();
+
+        ImGuiIO& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2 { static_cast<float>(screen_width),
+                                  static_cast<float>(screen_height) };
+        io.IniFilename = nullptr;
+
+        unsigned char* pixels { nullptr };
+        int width {}, height {};
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+        m_texture_bytes += static_cast<std::size_t>(width) * height * 4;
+    }
+
+    bool engine_null::process_input(event&)
+    {
+        return false;
+    }
+
+    bool engine_null::key_down(const enum keys)
+    {
+        return false;
+    }
+
+    void engine_null::imgui_new_frame()
+    {
+        ImGui::GetIO().DeltaTime = 1.f / 60.f;
+        ImGui::NewFrame();
+    }
+
+    void engine_null::imgui_render()
+    {
+        ImGui::Render();
+
+        const ImDrawData* draw_data = ImGui::GetDrawData();
+
+        for (int i = 0; i < draw_data->CmdListsCount; i++)
+        {
+            for (const ImDrawCmd& cmd : draw_data->CmdLists[i]->CmdBuffer)
+            {
+                if (!cmd.UserCallback)
+                {
+                    count_draw(cmd.ElemCount);
+                }
+            }
+        }
+    }
+
+    void engine_null::set_camera(const camera2d& camera)
+    {
+        m_camera = camera;
+    }
+
+    camera2d engine_null::get_camera() const noexcept
+    {
+        return m_camera;
+    }
+
+    void engine_null::render(ivertex_buffer*,
+                             i_index_buffer* ebo,
+                             itexture* const texture,
+                             const glm::mediump_mat3&)
+    {
+        render(nullptr, ebo, texture);
+    }
+
+    void engine_null::render(ivertex_buffer*,
+                             i_index_buffer* ebo,
+                             itexture* const texture)
+    {
+        CHECK_NOTNULL(ebo);
+        CHECK_NOTNULL(texture);
+        count_draw(ebo->get_indices_number());
+    }
+
+    void engine_null::render(ivertex_buffer*,
+                             i_index_buffer* ebo,
+                             itexture_array* const texture_array)
+    {
+        CHECK_NOTNULL(ebo);
+        CHECK_NOTNULL(texture_array);
+        count_draw(ebo->get_indices_number());
+    }
+
+    void engine_null::render(const std::vector<sprite_vertex>&,
+                             const std::vector<uint32_t>& indices,
+                             itexture* const texture)
+    {
+        CHECK_NOTNULL(texture);
+        count_draw(indices.size());
+    }
+
+    void engine_null::render(const std::vector<vertex>&,
+                             const std::vector<uint32_t>& indices,
+                             itexture_array* const texture_array)
+    {
+        CHECK_NOTNULL(texture_array);
+        count_draw(indices.size());
+    }
+
+    void engine_null::submit(const sprite_command& command)
+    {
+        CHECK(command.texture || command.texture_array);
+        m_queued_commands.push_back(command);
+    }
+
+    void engine_null::submit(const mesh_command& command)
+    {
+        CHECK_NOTNULL(command.vertex_buffer);
+        CHECK_NOTNULL(command.ebo);
+        CHECK_NOTNULL(command.texture_array);
+        m_queued_commands.push_back(command);
+    }
+
+    std::uint8_t engine_null::get_queue_program(const blend_mode blend)
+    {
+        return static_cast<std::uint8_t>(blend == blend_mode::alpha_test
+                                             ? queue_program::alpha_test
+                                             : queue_program::sprite);
+    }
+
+    std::uint64_t engine_null::get_sort_key(const queued_command& command) const
+    {
+        sort_key_fields fields {};
+
+        if (const auto* mesh = std::get_if<mesh_command>(&command))
+        {
+            fields.layer = mesh->layer;
+            fields.translucent = is_translucent(mesh->blend);
+            fields.depth = mesh->depth;
+            fields.program = get_queue_program(mesh->blend)
+                | static_cast<std::uint8_t>(queue_program::texture_array);
+            fields.texture
+                = static_cast<null_texture_array*>(mesh->texture_array)->id;
+            return make_sort_key(fields);
+        }
+
+        const sprite_command& spr = std::get<sprite_command>(command);
+
+        fields.layer = spr.layer;
+        fields.translucent = is_translucent(spr.blend);
+        fields.depth = spr.depth;
+        fields.program = get_queue_program(spr.blend);
+
+        if (spr.texture_array)
+        {
+            fields.program |= static_cast<std::uint8_t>(queue_program::texture_array);
+            fields.texture
+                = static_cast<null_texture_array*>(spr.texture_array)->id;
+        }
+        else
+        {
+            fields.program |= static_cast<std::uint8_t>(queue_program::sprite);
+            fields.texture = static_cast<null_texture*>(spr.texture)->id;
+        }
+
+        return make_sort_key(fields);
+    }
+
+    void engine_null::execute_render_queue()
+    {
+        if (m_queued_commands.empty())
+        {
+            return;
+        }
+
+        for (std::size_t i = 0; i < m_queued_commands.size(); i++)
+        {
+            m_render_queue.push(get_sort_key(m_queued_commands[i]), i);
+        }
+
+        m_frame_stats.queue_state_changes_unsorted
+            += m_render_queue.count_state_changes();
+        m_render_queue.sort();
+        m_frame_stats.queue_state_changes_sorted
+            += m_render_queue.count_state_changes();
+
+        // Sprites are batched by the same rules as in the SDL engine:
+        // a batch ends when texture, blending, layer or depth change.
+        const sprite_command* batch { nullptr };
+        std::size_t batch_sprites {};
+
+        const auto flush_batch = [&] {
+            if (batch_sprites)
+            {
+                count_draw(batch_sprites * 6);
+            }
+
+            batch = nullptr;
+            batch_sprites = 0;
+        };
+
+        for (const render_queue::item& item : m_render_queue.get_items())
+        {
+            const queued_command& command = m_queued_commands[item.command];
+
+            if (const auto* mesh = std::get_if<mesh_command>(&command))
+            {
+                flush_batch();
+                count_draw(mesh->ebo->get_indices_number());
+                continue;
+            }
+
+            const sprite_command& spr = std::get<sprite_command>(command);
+
+            if (batch
+                && (spr.texture != batch->texture
+                    || spr.texture_array != batch->texture_array
+                    || spr.blend != batch->blend
+                    || spr.layer != batch->layer
+                    || spr.depth != batch->depth))
+            {
+                flush_batch();
+            }
+
+            batch = &spr;
+            batch_sprites++;
+        }
+
+        flush_batch();
+
+        m_render_queue.clear();
+        m_queued_commands.clear();
+    }
+
+    void engine_null::count_draw(const std::size_t vertices_number)
+    {
+        m_frame_stats.draw_calls++;
+        m_frame_stats.vertices += vertices_number;
+    }
+
+    ivertex_buffer* engine_null::create_vertex_buffer(
+        const std::vector<triangle>& triangles)
+    {
+        return new null_vertex_buffer { triangles.size() * 3 };
+    }
+
+    ivertex_buffer* engine_null::create_vertex_buffer(
+        const std::vector<vertex>& vertices)
+    {
+        return new null_vertex_buffer { vertices.size() };
+    }
+
+    ivertex_buffer* engine_null::create_vertex_buffer(
+        const std::vector<sprite_vertex>& vertices)
+    {
+        return new null_vertex_buffer { vertices.size() };
+    }
+
+    ivertex_buffer* engine_null::create_vertex_buffer(
+        const void* vertices,
+        const std::size_t vertices_number,
+        const vertex_layout& layout)
+    {
+        CHECK_NOTNULL(vertices);
+        CHECK(layout.stride > 0);
+        return new null_vertex_buffer { vertices_number };
+    }
+
+    void engine_null::destroy_vertex_buffer(ivertex_buffer* buffer)
+    {
+        CHECK_NOTNULL(buffer);
+        delete buffer;
+    }
+
+    i_index_buffer* engine_null::create_ebo(const std::vector<uint32_t>& indices)
+    {
+        return new null_index_buffer { indices };
+    }
+
+    void engine_null::destroy_ebo(i_index_buffer* buffer)
+    {
+        CHECK_NOTNULL(buffer);
+        delete buffer;
+    }
+
+    itexture* engine_null::create_texture(const std::string_view path)
+    {
+        null_texture* texture = new null_texture { m_next_texture_id++ };
+        texture->load(path);
+        m_texture_bytes += texture->bytes;
+        return texture;
+    }
+
+    void engine_null::destroy_texture(const itexture* const texture)
+    {
+        CHECK_NOTNULL(texture);
+        m_texture_bytes -= static_cast<const null_texture*>(texture)->bytes;
+        delete texture;
+    }
+
+    itexture_array* engine_null::create_texture_array(
+        const std::vector<std::string_view>& paths)
+    {
+        null_texture_array* texture_array
+            = new null_texture_array { m_next_texture_id++ };
+        texture_array->load(paths);
+        m_texture_bytes += texture_array->bytes;
+        return texture_array;
+    }
+
+    void engine_null::destroy_texture_array(
+        const itexture_array* const texture_array)
+    {
+        CHECK_NOTNULL(texture_array);
+        m_texture_bytes
+            -= static_cast<const null_texture_array*>(texture_array)->bytes;
+        delete texture_array;
+    }
+
+    iaudio_buffer* engine_null::create_audio_buffer(
+        const std::string_view audio_file_name)
+    {
+        CHECK(!audio_file_name.empty());
+        return new null_audio_buffer { m_frame_stats.sounds_played };
+    }
+
+    void engine_null::destroy_audio_buffer(iaudio_buffer* buffer)
+    {
+        CHECK_NOTNULL(buffer);
+        delete buffer;
+    }
+
+    void engine_null::uninit()
+    {
+        imgui_uninit();
+    }
+
+    void engine_null::imgui_uninit()
+    {
+        ImGui::DestroyContext();
+    }
+
+    void engine_null::swap_buffers()
+    {
+        execute_render_queue();
+
+        m_frame_stats.texture_bytes = m_texture_bytes;
+        m_last_frame_stats = m_frame_stats;
+        m_frame_stats = render_stats {};
+    }
+
+    std::pair<size_t, size_t>
+    engine_null::get_screen_resolution() const noexcept
+    {
+        return { screen_width, screen_height };
+    }
+
+    render_stats engine_null::get_render_stats() const noexcept
+    {
+        return m_last_frame_stats;
+    }
+
+    void engine_null::set_layer_name(const std::uint8_t, const std::string_view)
+    {
+    }
+
+    gpu_timings engine_null::get_gpu_timings() const
+    {
+        // Nothing is drawn, so there is nothing to time.
+        return gpu_timings {};
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    iengine* create_null_engine()
+    {
+        return new engine_null {};
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
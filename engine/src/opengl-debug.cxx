@@ -0,0 +1,367 @@
+#include "opengl-debug.hxx"
+
+#include "helper.hxx"
+
+#ifndef __ANDROID__
+/* clang-format off */
+#include <fmt/core.h>
+/* clang-format on */
+#else
+/* clang-format off */
+#include <android/log.h>
+/* clang-format on */
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Sites register themselves when they are reached for the first time.
+    static std::mutex sites_mutex {};
+    static gl_call_site* first_site { nullptr };
+
+    static std::string source_msg_enum_to_string(const GLenum source_msg);
+
+    static std::string type_msg_enum_to_string(const GLenum type_msg);
+
+    static std::string severity_msg_enum_to_string(const GLenum severity_msg);
+
+    static void print_gl_message(const std::string& message)
+    {
+#ifndef __ANDROID__
+        fmt::print("{}", message);
+#else
+        __android_log_print(ANDROID_LOG_ERROR, "ARCI", "%s", message.c_str());
+#endif
+    }
+
+    // https://registry.khronos.org/OpenGL-Refpages/gl4/html/glDebugMessageCallback.xhtml
+    [[maybe_unused]] static void APIENTRY opengl_message_callback(
+        GLenum source,
+        GLenum type,
+        GLuint id,
+        GLenum severity,
+        GLsizei length,
+        const GLchar* message,
+        [[maybe_unused]] const void* userParam)
+    {
+        if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+        {
+            return;
+        }
+
+        CHECK(length < GL_MAX_DEBUG_MESSAGE_LENGTH);
+
+        if (type == GL_DEBUG_TYPE_ERROR)
+        {
+            static gl_call_site debug_output_site { "GL debug output", 0 };
+            std::lock_guard<std::mutex> lock { sites_mutex };
+            debug_output_site.errors++;
+        }
+
+#ifndef __ANDROID__
+        fmt::print("Message id: {}\n", id);
+        fmt::print(source_msg_enum_to_string(source));
+        fmt::print(type_msg_enum_to_string(type));
+        fmt::print(severity_msg_enum_to_string(severity));
+        fmt::print(message);
+#else
+        const std::string src = source_msg_enum_to_string(source);
+        const std::string type_msg = type_msg_enum_to_string(type);
+        const std::string severity_msg = severity_msg_enum_to_string(severity);
+
+        __android_log_print(ANDROID_LOG_ERROR, "ARCI", "Message id: %u\n"
+                                                       "%s\n%s\n%s\n%s\n",
+                            id,
+                            src.c_str(),
+                            type_msg.c_str(),
+                            severity_msg.c_str(),
+                            message);
+#endif
+    }
+
+    static std::string source_msg_enum_to_string(const GLenum source_msg)
+    {
+        std::string result { "Message source: " };
+
+        switch (source_msg)
+        {
+        case GL_DEBUG_SOURCE_API:
+            result += "calls to the OpenGL API\n";
+            break;
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+            result += "calls to a window-system API\n";
+            break;
+        case GL_DEBUG_SOURCE_SHADER_COMPILER:
+            result += "a compiler for a shading language\n";
+            break;
+        case GL_DEBUG_SOURCE_THIRD_PARTY:
+            result += "a third party application associated with OpenGL\n";
+            break;
+        case GL_DEBUG_SOURCE_APPLICATION:
+            result += "a source application associated with OpenGL\n";
+            break;
+        case GL_DEBUG_SOURCE_OTHER:
+            result += "some other source\n";
+            break;
+        default:
+            result += "unknown source\n";
+            break;
+        }
+
+        return result;
+    }
+
+    static std::string type_msg_enum_to_string(const GLenum type_msg)
+    {
+        std::string result { "Message type: " };
+
+        switch (type_msg)
+        {
+        case GL_DEBUG_TYPE_ERROR:
+            result += "an error, typically from the API\n";
+            break;
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+            result += "some behavior marked deprecated has been used\n";
+            break;
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+            result += "something has invoked undefined behavior\n";
+            break;
+        case GL_DEBUG_TYPE_PORTABILITY:
+            result
+                += "some functionality the user relies upon is not portable\n";
+            break;
+        case GL_DEBUG_TYPE_PERFORMANCE:
+            result += "code has triggered possible performance issues\n";
+            break;
+        case GL_DEBUG_TYPE_MARKER:
+            result += "command stream annotation\n";
+            break;
+        case GL_DEBUG_TYPE_PUSH_GROUP:
+            result += "group pushing\n";
+            break;
+        case GL_DEBUG_TYPE_POP_GROUP:
+            result += "group popping\n";
+            break;
+        case GL_DEBUG_TYPE_OTHER:
+            result += "some other type\n";
+            break;
+        default:
+            result += "unknown type\n";
+            break;
+        }
+
+        return result;
+    }
+
+    static std::string severity_msg_enum_to_string(const GLenum severity_msg)
+    {
+        std::string result { "Message severity: " };
+
+        switch (severity_msg)
+        {
+        case GL_DEBUG_SEVERITY_HIGH:
+            result += "HIGH. All OpenGL Errors, shader compilation/linking"
+                      " errors, or highly-dangerous undefined behavior\n";
+            break;
+        case GL_DEBUG_SEVERITY_MEDIUM:
+            result += "MEDIUM. Major performance warnings, "
+                      "shader compilation/linking warnings, "
+                      "or the use of deprecated functionality\n";
+            break;
+        case GL_DEBUG_SEVERITY_LOW:
+            result += "LOW. Redundant state change performance warning, "
+                      "or unimportant undefined behavior\n";
+            break;
+        case GL_DEBUG_SEVERITY_NOTIFICATION:
+            result += "NOTIFICATION. Anything that isn't an error or"
+                      " performance issue\n";
+            break;
+        default:
+            result += "UNKNOWN\n";
+            break;
+        }
+
+        return result;
+    }
+
+    static std::string error_enum_to_string(const GLenum error)
+    {
+        switch (error)
+        {
+        case GL_INVALID_ENUM:
+            return "An unacceptable value is specified"
+                   " for an enumerated argument";
+        case GL_INVALID_VALUE:
+            return "A numeric argument is out of range";
+        case GL_INVALID_OPERATION:
+            return "The specified operation is not"
+                   " allowed in the current state";
+        case GL_INVALID_FRAMEBUFFER_OPERATION:
+            return "The framebuffer object is not complete";
+        case GL_OUT_OF_MEMORY:
+            return "There is not enough memory left to execute"
+                   " the command";
+        case GL_STACK_UNDERFLOW:
+            return "An attempt has been made to perform"
+                   " an operation that would cause an internal"
+                   " stack to underflow";
+        case GL_STACK_OVERFLOW:
+            return "An attempt has been made to perform"
+                   " an operation that would cause an internal"
+                   " stack to overflow";
+        default:
+            return "Undefined opengl error type";
+        }
+    }
+
+    static gl_diagnostics_tier get_requested_tier()
+    {
+        const char* requested = std::getenv("ARCI_GL_DIAGNOSTICS");
+
+        if (!requested)
+        {
+            return static_cast<gl_diagnostics_tier>(ARCI_GL_DIAGNOSTICS);
+        }
+
+        const std::string_view name { requested };
+
+        if (name == "off")
+        {
+            return gl_diagnostics_tier::off;
+        }
+        else if (name == "callback")
+        {
+            return gl_diagnostics_tier::debug_callback;
+        }
+        else if (name == "frame")
+        {
+            return gl_diagnostics_tier::per_frame;
+        }
+        else if (name == "call")
+        {
+            return gl_diagnostics_tier::per_call;
+        }
+
+        // A typo in the environment shouldn't stop the game.
+        print_gl_message("Unknown ARCI_GL_DIAGNOSTICS value "
+                         + std::string { name }
+                         + ", the compiled-in tier is used\n");
+        return static_cast<gl_diagnostics_tier>(ARCI_GL_DIAGNOSTICS);
+    }
+
+    void init_gl_diagnostics()
+    {
+        current_gl_diagnostics_tier = std::min(
+            get_requested_tier(),
+            static_cast<gl_diagnostics_tier>(ARCI_GL_DIAGNOSTICS));
+
+#if ARCI_GL_DIAGNOSTICS >= 1
+        if (current_gl_diagnostics_tier == gl_diagnostics_tier::off)
+        {
+            return;
+        }
+
+        glEnable(GL_DEBUG_OUTPUT);
+        opengl_check();
+
+        if (current_gl_diagnostics_tier == gl_diagnostics_tier::per_call)
+        {
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+            opengl_check();
+        }
+
+        glDebugMessageCallback(opengl_message_callback, nullptr);
+        opengl_check();
+        glDebugMessageControl(
+            GL_DONT_CARE,
+            GL_DONT_CARE,
+            GL_DONT_CARE,
+            0,
+            nullptr,
+            GL_TRUE);
+        opengl_check();
+#endif
+    }
+
+    gl_call_site::gl_call_site(const char* file, const int line)
+        : file { file }
+        , line { line }
+    {
+        std::lock_guard<std::mutex> lock { sites_mutex };
+        next = first_site;
+        first_site = this;
+    }
+
+    void check_gl_errors(gl_call_site& site)
+    {
+        for (GLenum error = glGetError(); error != GL_NO_ERROR;
+             error = glGetError())
+        {
+            std::size_t errors {};
+
+            {
+                std::lock_guard<std::mutex> lock { sites_mutex };
+                errors = ++site.errors;
+            }
+
+            if (errors == 1)
+            {
+                print_gl_message(std::string { site.file } + ":"
+                                 + std::to_string(site.line) + ": "
+                                 + error_enum_to_string(error) + "\n");
+            }
+        }
+    }
+
+    void print_gl_error_report()
+    {
+        std::lock_guard<std::mutex> lock { sites_mutex };
+
+        for (const gl_call_site* site = first_site; site; site = site->next)
+        {
+            if (site->errors)
+            {
+                print_gl_message(std::string { site->file } + ":"
+                                 + std::to_string(site->line) + ": "
+                                 + std::to_string(site->errors)
+                                 + " GL errors\n");
+            }
+        }
+    }
+
+    bool has_gl_extension(const std::string_view name)
+    {
+        GLint extensions_number {};
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensions_number);
+        opengl_check();
+
+        for (GLint i = 0; i < extensions_number; i++)
+        {
+            const auto* extension = reinterpret_cast<const char*>(
+                glGetStringi(GL_EXTENSIONS, i));
+            opengl_check();
+
+            if (extension && name == extension)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,268 @@
+#include "opengl-gpu-profiler.hxx"
+#include "opengl-debug.hxx"
+
+#include "helper.hxx"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // GL_EXT_disjoint_timer_query enums, glad is generated without
+    // extensions.
+    static constexpr GLenum time_elapsed_ext { 0x88BF };
+    static constexpr GLenum query_result_ext { 0x8866 };
+    static constexpr GLenum query_result_available_ext { 0x8867 };
+    static constexpr GLenum gpu_disjoint_ext { 0x8FBB };
+
+    opengl_gpu_profiler::opengl_gpu_profiler(GLADloadproc load)
+    {
+        CHECK_NOTNULL(load);
+
+        if (!has_gl_extension("GL_EXT_disjoint_timer_query"))
+        {
+            return;
+        }
+
+        m_gen_queries = reinterpret_cast<gen_queries_func>(
+            load("glGenQueriesEXT"));
+        m_delete_queries = reinterpret_cast<delete_queries_func>(
+            load("glDeleteQueriesEXT"));
+        m_begin_query = reinterpret_cast<begin_query_func>(
+            load("glBeginQueryEXT"));
+        m_end_query = reinterpret_cast<end_query_func>(
+            load("glEndQueryEXT"));
+        m_get_query_uiv = reinterpret_cast<get_query_uiv_func>(
+            load("glGetQueryObjectuivEXT"));
+
+        m_gpu_timer = m_gen_queries && m_delete_queries && m_begin_query
+            && m_end_query && m_get_query_uiv;
+    }
+
+    opengl_gpu_profiler::~opengl_gpu_profiler()
+    {
+        if (!m_gpu_timer)
+        {
+            return;
+        }
+
+        for (const frame& slot : m_frames)
+        {
+            if (!slot.queries.empty())
+            {
+                m_delete_queries(static_cast<GLsizei>(slot.queries.size()),
+                                 slot.queries.data());
+                opengl_check();
+            }
+        }
+    }
+
+    void opengl_gpu_profiler::begin_frame()
+    {
+        frame& slot = m_frames[m_frame_index];
+
+        if (slot.is_recorded)
+        {
+            collect(slot);
+        }
+
+        slot.passes.clear();
+        slot.is_recorded = false;
+    }
+
+    void opengl_gpu_profiler::end_frame()
+    {
+        CHECK(!m_pass_open);
+
+        m_frames[m_frame_index].is_recorded = true;
+        m_frame_index = (m_frame_index + 1) % frames_latency;
+    }
+
+    void opengl_gpu_profiler::begin_pass(const std::string_view name)
+    {
+        CHECK(!m_pass_open);
+        m_pass_open = true;
+
+        frame& slot = m_frames[m_frame_index];
+
+        pass new_pass { std::string { name } };
+
+        if (m_gpu_timer)
+        {
+            if (slot.passes.size() == slot.queries.size())
+            {
+                GLuint query {};
+                m_gen_queries(1, &query);
+                opengl_check();
+                slot.queries.push_back(query);
+            }
+
+            new_pass.query = slot.queries[slot.passes.size()];
+            m_begin_query(time_elapsed_ext, new_pass.query);
+            opengl_check();
+        }
+
+        new_pass.cpu_begin = std::chrono::steady_clock::now();
+        slot.passes.push_back(std::move(new_pass));
+    }
+
+    void opengl_gpu_profiler::end_pass()
+    {
+        CHECK(m_pass_open);
+        m_pass_open = false;
+
+        pass& current = m_frames[m_frame_index].passes.back();
+
+        const std::chrono::duration<float, std::milli> cpu_time
+            = std::chrono::steady_clock::now() - current.cpu_begin;
+        current.cpu_ms = cpu_time.count();
+
+        if (m_gpu_timer)
+        {
+            m_end_query(time_elapsed_ext);
+            opengl_check();
+        }
+    }
+
+    bool opengl_gpu_profiler::is_pass_open() const noexcept
+    {
+        return m_pass_open;
+    }
+
+    void opengl_gpu_profiler::collect(frame& slot)
+    {
+        if (slot.passes.empty())
+        {
+            return;
+        }
+
+        if (m_gpu_timer)
+        {
+            // Queries finish in order, so the last one is enough.
+            GLuint available {};
+            m_get_query_uiv(slot.passes.back().query,
+                            query_result_available_ext,
+                            &available);
+            opengl_check();
+
+            // Results of all pending queries are undefined after
+            // a disjoint event (e.g. GPU frequency change).
+            GLint disjoint {};
+            glGetIntegerv(gpu_disjoint_ext, &disjoint);
+            opengl_check();
+
+            if (!available || disjoint)
+            {
+                std::lock_guard<std::mutex> lock { m_history_mutex };
+                m_dropped_frames++;
+                return;
+            }
+        }
+
+        std::vector<std::pair<const std::string*, float>> frame_totals {};
+
+        for (const pass& done : slot.passes)
+        {
+            float ms { done.cpu_ms };
+
+            if (m_gpu_timer)
+            {
+                GLuint nanoseconds {};
+                m_get_query_uiv(done.query, query_result_ext, &nanoseconds);
+                opengl_check();
+                ms = nanoseconds / 1'000'000.f;
+            }
+
+            auto it = std::find_if(frame_totals.begin(),
+                                   frame_totals.end(),
+                                   [&done](const auto& total) {
+                                       return *total.first == done.name;
+                                   });
+
+            if (it == frame_totals.end())
+            {
+                frame_totals.emplace_back(&done.name, ms);
+            }
+            else
+            {
+                it->second += ms;
+            }
+        }
+
+        for (const auto& [name, ms] : frame_totals)
+        {
+            add_sample(*name, ms);
+        }
+    }
+
+    void opengl_gpu_profiler::add_sample(const std::string& name,
+                                         const float ms)
+    {
+        std::lock_guard<std::mutex> lock { m_history_mutex };
+
+        auto it = std::find_if(m_history.begin(),
+                               m_history.end(),
+                               [&name](const pass_history& history) {
+                                   return history.name == name;
+                               });
+
+        if (it == m_history.end())
+        {
+            m_history.push_back(pass_history { name });
+            it = std::prev(m_history.end());
+        }
+
+        it->samples.push_back(ms);
+
+        if (it->samples.size() > history_size)
+        {
+            it->samples.pop_front();
+        }
+    }
+
+    gpu_timings opengl_gpu_profiler::get_timings() const
+    {
+        gpu_timings timings {};
+        timings.is_gpu_timer = m_gpu_timer;
+
+        std::lock_guard<std::mutex> lock { m_history_mutex };
+
+        timings.dropped_frames = m_dropped_frames;
+
+        for (const pass_history& history : m_history)
+        {
+            std::vector<float> sorted { history.samples.begin(),
+                                        history.samples.end() };
+            std::sort(sorted.begin(), sorted.end());
+
+            const auto percentile = [&sorted](const float fraction) {
+                const auto index = static_cast<std::size_t>(
+                    fraction * (sorted.size() - 1) + 0.5f);
+                return sorted[index];
+            };
+
+            gpu_pass_timing timing { history.name };
+            timing.average_ms
+                = std::accumulate(sorted.begin(), sorted.end(), 0.f)
+                / sorted.size();
+            timing.median_ms = percentile(0.5f);
+            timing.p95_ms = percentile(0.95f);
+            timing.max_ms = sorted.back();
+
+            timings.passes.push_back(std::move(timing));
+        }
+
+        return timings;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,237 @@
+#include "opengl-program-cache.hxx"
+#include "opengl-debug.hxx"
+
+#include "helper.hxx"
+
+#include <SDL3/SDL.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Every cache file starts with this header followed by the binary.
+    struct program_binary_header
+    {
+        std::uint32_t magic {};
+        std::uint32_t version {};
+        std::uint64_t key {};
+        std::uint32_t format {};
+        std::uint32_t size {};
+    };
+
+    static constexpr std::uint32_t program_binary_magic { 0x42505241 }; // ARPB
+    static constexpr std::uint32_t program_binary_version { 1 };
+
+    // Binaries bigger than this are treated as corrupted files.
+    static constexpr std::uint32_t max_program_binary_size { 16u << 20 };
+
+    // 64-bit FNV-1a.
+    static std::uint64_t hash_string(const std::string_view data,
+                                     std::uint64_t hash = 14695981039346656037ull)
+    {
+        for (const char c : data)
+        {
+            hash ^= static_cast<std::uint8_t>(c);
+            hash *= 1099511628211ull;
+        }
+
+        return hash;
+    }
+
+    static std::string get_gl_string(const GLenum name)
+    {
+        const GLubyte* value = glGetString(name);
+        opengl_check();
+
+        if (!value)
+        {
+            return {};
+        }
+
+        return reinterpret_cast<const char*>(value);
+    }
+
+    opengl_program_cache::opengl_program_cache(std::string directory)
+        : m_directory { std::move(directory) }
+    {
+        GLint formats_number {};
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats_number);
+        opengl_check();
+
+        if (formats_number <= 0 || m_directory.empty())
+        {
+            return;
+        }
+
+        std::error_code error {};
+        std::filesystem::create_directories(m_directory, error);
+
+        if (error)
+        {
+            return;
+        }
+
+        m_driver_id = get_gl_string(GL_VENDOR);
+        m_driver_id += '\n';
+        m_driver_id += get_gl_string(GL_RENDERER);
+        m_driver_id += '\n';
+        m_driver_id += get_gl_string(GL_VERSION);
+
+        m_enabled = true;
+    }
+
+    bool opengl_program_cache::is_enabled() const noexcept
+    {
+        return m_enabled;
+    }
+
+    std::uint64_t opengl_program_cache::get_key(
+        const std::string_view sources) const
+    {
+        return hash_string(sources, hash_string(m_driver_id));
+    }
+
+    bool opengl_program_cache::load(const std::uint64_t key,
+                                    program_binary& binary)
+    {
+        if (!m_enabled)
+        {
+            return false;
+        }
+
+        std::ifstream file { get_file_path(key), std::ios::binary };
+
+        program_binary_header header {};
+
+        if (!file
+            || !file.read(reinterpret_cast<char*>(&header), sizeof(header))
+            || header.magic != program_binary_magic
+            || header.version != program_binary_version
+            || header.key != key
+            || header.size == 0
+            || header.size > max_program_binary_size)
+        {
+            m_statistics.misses++;
+            return false;
+        }
+
+        binary.format = header.format;
+        binary.data.resize(header.size);
+
+        if (!file.read(reinterpret_cast<char*>(binary.data.data()),
+                       header.size))
+        {
+            m_statistics.misses++;
+            return false;
+        }
+
+        m_statistics.hits++;
+        return true;
+    }
+
+    void opengl_program_cache::store(const std::uint64_t key,
+                                     const program_binary& binary)
+    {
+        if (!m_enabled || binary.data.empty()
+            || binary.data.size() > max_program_binary_size)
+        {
+            return;
+        }
+
+        const std::string path = get_file_path(key);
+
+        // Write to the temporary file first, so an interrupted write never
+        // leaves a truncated binary under the real name.
+        const std::string temporary_path = path + ".tmp";
+
+        {
+            std::ofstream file { temporary_path,
+                                 std::ios::binary | std::ios::trunc };
+
+            const program_binary_header header {
+                program_binary_magic,
+                program_binary_version,
+                key,
+                binary.format,
+                static_cast<std::uint32_t>(binary.data.size()),
+            };
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(binary.data.data()),
+                       static_cast<std::streamsize>(binary.data.size()));
+
+            if (!file)
+            {
+                return;
+            }
+        }
+
+        std::error_code error {};
+        std::filesystem::rename(temporary_path, path, error);
+    }
+
+    void opengl_program_cache::remove(const std::uint64_t key)
+    {
+        m_statistics.rejected++;
+
+        std::error_code error {};
+        std::filesystem::remove(get_file_path(key), error);
+    }
+
+    const opengl_program_cache::statistics&
+    opengl_program_cache::get_statistics() const noexcept
+    {
+        return m_statistics;
+    }
+
+    std::string opengl_program_cache::get_file_path(
+        const std::uint64_t key) const
+    {
+        std::ostringstream path {};
+        path << m_directory << '/' << std::hex << std::setw(16)
+             << std::setfill('0') << key << ".bin";
+        return path.str();
+    }
+
+    std::string get_default_program_cache_directory()
+    {
+        const char* requested = std::getenv("ARCI_SHADER_CACHE");
+
+        if (requested)
+        {
+            if (std::string_view { requested } == "off")
+            {
+                return {};
+            }
+
+            return requested;
+        }
+
+        char* pref_path = SDL_GetPrefPath("arci", "arcanoid");
+
+        if (!pref_path)
+        {
+            return {};
+        }
+
+        std::string directory { pref_path };
+        SDL_free(pref_path);
+        directory += "shader-cache";
+
+        return directory;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
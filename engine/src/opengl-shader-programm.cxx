@@ -1,4 +1,5 @@
 #include "opengl-shader-programm.hxx"
+#include "asset-pack.hxx"
 #include "opengl-debug.hxx"
 
 #include "helper.hxx"
@@ -32,22 +33,43 @@ namespace arci
         opengl_check();
     }
 
+    void opengl_shader_program::set_defines(std::string defines)
+    {
+        m_defines = std::move(defines);
+    }
+
     void opengl_shader_program::load_shader(
         const GLenum shader_type,
         std::string_view shader_name)
     {
-        GLuint shader_id = glCreateShader(shader_type);
-        opengl_check();
-
-        CHECK(shader_id);
-
 #ifndef __ANDROID__
         std::string path("engine/shaders/");
         path.append(shader_name);
-        const std::string shader_code_string = get_shader_code_from_file(path);
+        std::string shader_code = get_shader_code_from_file(path);
 #else
-        const std::string shader_code_string = get_shader_code_from_file(shader_name);
+        std::string shader_code = get_shader_code_from_file(shader_name);
 #endif
+        if (!m_defines.empty())
+        {
+            // `#version` should be the first line of the shader. `#line`
+            // keeps line numbers of compile errors matching the file.
+            const std::size_t version_end = shader_code.find('\n');
+            CHECK(version_end != std::string::npos);
+            shader_code.insert(version_end + 1, m_defines + "#line 2\n");
+        }
+
+        m_sources.push_back({ shader_type, std::move(shader_code) });
+    }
+
+    void opengl_shader_program::compile_shader(
+        const GLenum shader_type,
+        const std::string& shader_code_string)
+    {
+        GLuint shader_id = glCreateShader(shader_type);
+        opengl_check();
+
+        CHECK(shader_id);
+
         const char* shader_code = shader_code_string.data();
 
         glShaderSource(shader_id, 1, &shader_code, nullptr);
@@ -96,15 +118,42 @@ namespace arci
         opengl_check();
     }
 
+    GLuint opengl_shader_program::get_program_id() const noexcept
+    {
+        return m_program;
+    }
+
+    uniform_handle opengl_shader_program::get_uniform(
+        const std::string_view name) const
+    {
+        const auto iter = m_uniform_locations.find(shader_name_id(name));
+
+        if (iter == m_uniform_locations.end())
+        {
+            return uniform_handle {};
+        }
+
+        return uniform_handle { iter->second };
+    }
+
+    GLint opengl_shader_program::get_attribute_location(
+        const std::string_view name) const
+    {
+        const auto iter = m_attribute_locations.find(shader_name_id(name));
+
+        if (iter == m_attribute_locations.end())
+        {
+            return -1;
+        }
+
+        return iter->second;
+    }
+
     void opengl_shader_program::set_uniform(
-        const std::string_view matrix_attribute_name,
+        const uniform_handle handle,
         const glm::mediump_mat3& result_matrix)
     {
-        const GLint uniform_location = glGetUniformLocation(
-            m_program,
-            static_cast<const GLchar*>(matrix_attribute_name.data()));
-        opengl_check();
-        CHECK(uniform_location != -1);
+        CHECK(handle.is_valid());
 
         float m[9] = {
             result_matrix[0][0],
@@ -118,41 +167,172 @@ namespace arci
             result_matrix[2][2],
         };
 
-        glUniformMatrix3fv(uniform_location, 1, GL_FALSE, m);
+        glUniformMatrix3fv(handle.location, 1, GL_FALSE, m);
         opengl_check();
     }
 
     void opengl_shader_program::set_uniform(
-        const std::string_view texture_attribute_name)
+        const uniform_handle handle,
+        const GLint texture_unit)
     {
-        const GLint location = glGetUniformLocation(
-            m_program,
-            texture_attribute_name.data());
+        CHECK(handle.is_valid());
+
+        glUniform1i(handle.location, texture_unit);
         opengl_check();
+    }
 
-        CHECK(location != -1);
+    void opengl_shader_program::set_uniform(const uniform_handle handle,
+                                            const GLfloat value)
+    {
+        CHECK(handle.is_valid());
 
-        const GLint texture_unit { 0 };
-        glActiveTexture(GL_TEXTURE0 + texture_unit);
+        glProgramUniform1f(m_program, handle.location, value);
         opengl_check();
-        glUniform1i(location, 0 + texture_unit);
+    }
+
+    bool opengl_shader_program::bind_uniform_block(
+        const std::string_view block_name,
+        const GLuint binding_point)
+    {
+        const GLuint block_index = glGetUniformBlockIndex(
+            m_program,
+            std::string { block_name }.c_str());
         opengl_check();
+
+        if (block_index == GL_INVALID_INDEX)
+        {
+            return false;
+        }
+
+        glUniformBlockBinding(m_program, block_index, binding_point);
+        opengl_check();
+
+        return true;
     }
 
-    void opengl_shader_program::prepare_program()
+    void opengl_shader_program::prepare_program(opengl_program_cache* cache)
     {
+        m_program = glCreateProgram();
+        opengl_check();
+        CHECK(m_program);
+
+        std::uint64_t cache_key {};
+
+        if (cache && cache->is_enabled())
+        {
+            std::string sources {};
+
+            for (const shader_source& source : m_sources)
+            {
+                sources += std::to_string(source.type);
+                sources += '\n';
+                sources += source.code;
+            }
+
+            cache_key = cache->get_key(sources);
+
+            if (load_program_binary(*cache, cache_key))
+            {
+                reflect_program();
+                return;
+            }
+        }
+
+        for (const shader_source& source : m_sources)
+        {
+            compile_shader(source.type, source.code);
+        }
+
         attach_shaders();
+
+        if (cache && cache->is_enabled())
+        {
+            glProgramParameteri(m_program,
+                                GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+                                GL_TRUE);
+            opengl_check();
+        }
+
         link_program();
         validate_program();
-        CHECK(m_program);
+        reflect_program();
+
+        if (cache && cache->is_enabled())
+        {
+            store_program_binary(*cache, cache_key);
+        }
     }
 
-    void opengl_shader_program::attach_shaders()
+    bool opengl_shader_program::load_program_binary(
+        opengl_program_cache& cache,
+        const std::uint64_t key)
     {
-        m_program = glCreateProgram();
+        opengl_program_cache::program_binary binary {};
+
+        if (!cache.load(key, binary))
+        {
+            return false;
+        }
+
+        // Errors of earlier calls are reported here, as the ones left
+        // after glProgramBinary are cleared.
+        opengl_check_frame();
+
+        glProgramBinary(m_program,
+                        binary.format,
+                        binary.data.data(),
+                        static_cast<GLsizei>(binary.data.size()));
+
+        // Rejected binary is a valid outcome (e.g. the driver was updated
+        // without changing its version string, so the format is unknown
+        // now), link status tells everything.
+        while (glGetError() != GL_NO_ERROR)
+        {
+        }
+
+        GLint linked {};
+        glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
         opengl_check();
-        CHECK(m_program);
 
+        if (!linked)
+        {
+            cache.remove(key);
+            return false;
+        }
+
+        return true;
+    }
+
+    void opengl_shader_program::store_program_binary(
+        opengl_program_cache& cache,
+        const std::uint64_t key) const
+    {
+        GLint binary_length {};
+        glGetProgramiv(m_program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+        opengl_check();
+
+        if (binary_length <= 0)
+        {
+            return;
+        }
+
+        opengl_program_cache::program_binary binary {};
+        binary.data.resize(static_cast<std::size_t>(binary_length));
+
+        GLsizei written {};
+        glGetProgramBinary(m_program,
+                           binary_length,
+                           &written,
+                           &binary.format,
+                           binary.data.data());
+        opengl_check();
+
+        binary.data.resize(static_cast<std::size_t>(written));
+        cache.store(key, binary);
+    }
+
+    void opengl_shader_program::attach_shaders()
+    {
         std::for_each(
             m_shaders.begin(),
             m_shaders.end(),
@@ -235,9 +415,116 @@ namespace arci
         }
     }
 
+    void opengl_shader_program::reflect_program()
+    {
+        m_uniform_locations.clear();
+        m_attribute_locations.clear();
+
+        // Array uniforms are reported as `name[0]`, store them as `name`.
+        auto strip_array_suffix = [](std::string& name) {
+            const std::size_t bracket = name.find('[');
+            if (bracket != std::string::npos)
+            {
+                name.resize(bracket);
+            }
+        };
+
+        GLint max_name_length {};
+        glGetProgramiv(m_program,
+                       GL_ACTIVE_UNIFORM_MAX_LENGTH,
+                       &max_name_length);
+        opengl_check();
+
+        GLint attribute_max_name_length {};
+        glGetProgramiv(m_program,
+                       GL_ACTIVE_ATTRIBUTE_MAX_LENGTH,
+                       &attribute_max_name_length);
+        opengl_check();
+
+        std::string name {};
+        name.resize(std::max(max_name_length, attribute_max_name_length) + 1);
+
+        GLint uniforms_number {};
+        glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &uniforms_number);
+        opengl_check();
+
+        for (GLint i = 0; i < uniforms_number; i++)
+        {
+            GLsizei length {};
+            GLint size {};
+            GLenum type {};
+            glGetActiveUniform(m_program,
+                               i,
+                               static_cast<GLsizei>(name.size()),
+                               &length,
+                               &size,
+                               &type,
+                               name.data());
+            opengl_check();
+
+            std::string uniform_name { name.data(),
+                                       static_cast<std::size_t>(length) };
+            strip_array_suffix(uniform_name);
+
+            // Uniforms from uniform blocks have no location.
+            const GLint location = glGetUniformLocation(m_program,
+                                                        uniform_name.c_str());
+            opengl_check();
+
+            if (location == -1)
+            {
+                continue;
+            }
+
+            const auto [iter, inserted] = m_uniform_locations.insert(
+                { shader_name_id(uniform_name), location });
+            CHECK(inserted);
+        }
+
+        GLint attributes_number {};
+        glGetProgramiv(m_program, GL_ACTIVE_ATTRIBUTES, &attributes_number);
+        opengl_check();
+
+        for (GLint i = 0; i < attributes_number; i++)
+        {
+            GLsizei length {};
+            GLint size {};
+            GLenum type {};
+            glGetActiveAttrib(m_program,
+                              i,
+                              static_cast<GLsizei>(name.size()),
+                              &length,
+                              &size,
+                              &type,
+                              name.data());
+            opengl_check();
+
+            std::string attribute_name { name.data(),
+                                         static_cast<std::size_t>(length) };
+            strip_array_suffix(attribute_name);
+
+            const GLint location = glGetAttribLocation(m_program,
+                                                       attribute_name.c_str());
+            opengl_check();
+
+            const auto [iter, inserted] = m_attribute_locations.insert(
+                { shader_name_id(attribute_name), location });
+            CHECK(inserted);
+        }
+    }
+
     std::string opengl_shader_program::get_shader_code_from_file(
         const std::string_view path) const
     {
+        // Shaders are embedded into the binary (see res/CMakeLists.txt),
+        // so the file is only a fallback.
+        const asset_span asset = find_asset(path);
+
+        if (!asset.empty())
+        {
+            return { reinterpret_cast<const char*>(asset.data), asset.size };
+        }
+
         std::string shader_code {};
 
         SDL_RWops* rwop = SDL_RWFromFile(path.data(), "rb");
@@ -0,0 +1,80 @@
+#include "opengl-shader-variants.hxx"
+
+#include "helper.hxx"
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    opengl_shader_variants::opengl_shader_variants(
+        std::string vertex_shader_name,
+        std::string fragment_shader_name,
+        std::vector<std::string> feature_defines,
+        opengl_program_cache* cache,
+        setup_callback setup)
+        : m_vertex_shader_name { std::move(vertex_shader_name) }
+        , m_fragment_shader_name { std::move(fragment_shader_name) }
+        , m_feature_defines { std::move(feature_defines) }
+        , m_cache { cache }
+        , m_setup { std::move(setup) }
+    {
+        CHECK(m_feature_defines.size() < sizeof(shader_features) * 8);
+    }
+
+    opengl_shader_program& opengl_shader_variants::get(
+        const shader_features features)
+    {
+        const auto iter = m_programs.find(features);
+
+        if (iter != m_programs.end())
+        {
+            return *iter->second;
+        }
+
+        CHECK((features >> m_feature_defines.size()) == 0);
+
+        auto program = std::make_unique<opengl_shader_program>();
+        program->set_defines(get_defines(features));
+        program->load_shader(GL_VERTEX_SHADER, m_vertex_shader_name);
+        program->load_shader(GL_FRAGMENT_SHADER, m_fragment_shader_name);
+        program->prepare_program(m_cache);
+
+        if (m_setup)
+        {
+            m_setup(*program, features);
+        }
+
+        return *m_programs.emplace(features, std::move(program)).first->second;
+    }
+
+    std::size_t opengl_shader_variants::get_compiled_number() const noexcept
+    {
+        return m_programs.size();
+    }
+
+    std::string opengl_shader_variants::get_defines(
+        const shader_features features) const
+    {
+        std::string defines {};
+
+        for (std::size_t i = 0; i < m_feature_defines.size(); i++)
+        {
+            if (features & (1u << i))
+            {
+                defines += "#define ";
+                defines += m_feature_defines[i];
+                defines += '\n';
+            }
+        }
+
+        return defines;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,257 @@
+#include "opengl-state-cache.hxx"
+#include "opengl-debug.hxx"
+
+#include "helper.hxx"
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    void opengl_state_cache::use_program(const GLuint program)
+    {
+        if (update(m_program, program))
+        {
+            glUseProgram(program);
+            opengl_check();
+        }
+    }
+
+    void opengl_state_cache::bind_texture(const GLuint unit,
+                                          const GLenum target,
+                                          const GLuint texture)
+    {
+        CHECK(unit < max_texture_units);
+
+        GLuint& bound_texture = texture_binding(m_texture_units[unit], target);
+
+        if (bound_texture == texture)
+        {
+            m_statistics.calls_avoided++;
+            return;
+        }
+
+        if (update(m_active_texture_unit, unit))
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            opengl_check();
+        }
+
+        bound_texture = texture;
+        m_statistics.calls_issued++;
+        glBindTexture(target, texture);
+        opengl_check();
+    }
+
+    void opengl_state_cache::bind_vertex_array(const GLuint vao)
+    {
+        if (update(m_vertex_array, vao))
+        {
+            // Element array buffer binding belongs to the VAO.
+            m_element_array_buffer = unknown;
+
+            glBindVertexArray(vao);
+            opengl_check();
+        }
+    }
+
+    void opengl_state_cache::bind_buffer(const GLenum target,
+                                         const GLuint buffer)
+    {
+        GLuint* cached { nullptr };
+
+        switch (target)
+        {
+        case GL_ARRAY_BUFFER:
+            cached = &m_array_buffer;
+            break;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            cached = &m_element_array_buffer;
+            break;
+        case GL_UNIFORM_BUFFER:
+            cached = &m_uniform_buffer;
+            break;
+        default:
+            break;
+        }
+
+        if (cached && !update(*cached, buffer))
+        {
+            return;
+        }
+
+        if (!cached)
+        {
+            m_statistics.calls_issued++;
+        }
+
+        glBindBuffer(target, buffer);
+        opengl_check();
+    }
+
+    void opengl_state_cache::set_blend(const bool enabled)
+    {
+        if (update(m_blend_enabled, enabled ? GL_TRUE : GL_FALSE))
+        {
+            if (enabled)
+            {
+                glEnable(GL_BLEND);
+            }
+            else
+            {
+                glDisable(GL_BLEND);
+            }
+            opengl_check();
+        }
+    }
+
+    void opengl_state_cache::set_blend_func(const GLenum src_factor,
+                                            const GLenum dst_factor)
+    {
+        if (m_blend_src_factor == src_factor
+            && m_blend_dst_factor == dst_factor)
+        {
+            m_statistics.calls_avoided++;
+            return;
+        }
+
+        m_blend_src_factor = src_factor;
+        m_blend_dst_factor = dst_factor;
+        m_statistics.calls_issued++;
+
+        glBlendFunc(src_factor, dst_factor);
+        opengl_check();
+    }
+
+    void opengl_state_cache::set_depth_test(const bool enabled)
+    {
+        if (update(m_depth_test_enabled, enabled ? GL_TRUE : GL_FALSE))
+        {
+            if (enabled)
+            {
+                glEnable(GL_DEPTH_TEST);
+            }
+            else
+            {
+                glDisable(GL_DEPTH_TEST);
+            }
+            opengl_check();
+        }
+    }
+
+    void opengl_state_cache::set_depth_mask(const bool enabled)
+    {
+        if (update(m_depth_mask, enabled ? GL_TRUE : GL_FALSE))
+        {
+            glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+            opengl_check();
+        }
+    }
+
+    void opengl_state_cache::delete_texture(const GLuint texture)
+    {
+        for (texture_unit& unit : m_texture_units)
+        {
+            if (unit.texture_2d == texture)
+            {
+                unit.texture_2d = 0;
+            }
+
+            if (unit.texture_2d_array == texture)
+            {
+                unit.texture_2d_array = 0;
+            }
+        }
+
+        glDeleteTextures(1, &texture);
+        opengl_check();
+    }
+
+    void opengl_state_cache::delete_vertex_array(const GLuint vao)
+    {
+        if (m_vertex_array == vao)
+        {
+            m_vertex_array = 0;
+            m_element_array_buffer = unknown;
+        }
+
+        glDeleteVertexArrays(1, &vao);
+        opengl_check();
+    }
+
+    void opengl_state_cache::delete_buffer(const GLuint buffer)
+    {
+        for (GLuint* cached : { &m_array_buffer,
+                                &m_element_array_buffer,
+                                &m_uniform_buffer })
+        {
+            if (*cached == buffer)
+            {
+                *cached = 0;
+            }
+        }
+
+        glDeleteBuffers(1, &buffer);
+        opengl_check();
+    }
+
+    void opengl_state_cache::invalidate()
+    {
+        m_program = unknown;
+        m_active_texture_unit = unknown;
+        m_texture_units.fill(texture_unit {});
+        m_vertex_array = unknown;
+        m_array_buffer = unknown;
+        m_element_array_buffer = unknown;
+        m_uniform_buffer = unknown;
+        m_blend_enabled = unknown;
+        m_blend_src_factor = unknown_enum;
+        m_blend_dst_factor = unknown_enum;
+        m_depth_test_enabled = unknown;
+        m_depth_mask = unknown;
+    }
+
+    const opengl_state_cache::statistics&
+    opengl_state_cache::get_statistics() const noexcept
+    {
+        return m_statistics;
+    }
+
+    void opengl_state_cache::reset_statistics() noexcept
+    {
+        m_statistics = statistics {};
+    }
+
+    GLuint& opengl_state_cache::texture_binding(texture_unit& unit,
+                                                const GLenum target)
+    {
+        CHECK(target == GL_TEXTURE_2D || target == GL_TEXTURE_2D_ARRAY);
+
+        if (target == GL_TEXTURE_2D_ARRAY)
+        {
+            return unit.texture_2d_array;
+        }
+
+        return unit.texture_2d;
+    }
+
+    bool opengl_state_cache::update(GLuint& cached, const GLuint value) noexcept
+    {
+        if (cached == value)
+        {
+            m_statistics.calls_avoided++;
+            return false;
+        }
+
+        cached = value;
+        m_statistics.calls_issued++;
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
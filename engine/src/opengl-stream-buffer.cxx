@@ -0,0 +1,177 @@
+#include "opengl-stream-buffer.hxx"
+#include "opengl-debug.hxx"
+#include "opengl-state-cache.hxx"
+
+#include "helper.hxx"
+
+#include <algorithm>
+#include <cstring>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // The buffer is only bound to GL_COPY_WRITE_BUFFER for writing, so
+    // neither GL_ARRAY_BUFFER nor element array binding of the current VAO
+    // is touched.
+    static constexpr GLenum stream_target { GL_COPY_WRITE_BUFFER };
+
+    opengl_stream_buffer::opengl_stream_buffer(
+        opengl_state_cache& state_cache,
+        const std::size_t frame_capacity)
+        : m_state_cache { state_cache }
+    {
+        CHECK(frame_capacity > 0);
+
+        glGenBuffers(1, &m_buffer_id);
+        opengl_check();
+
+        allocate_storage(frame_capacity);
+    }
+
+    opengl_stream_buffer::~opengl_stream_buffer()
+    {
+        delete_fences();
+        m_state_cache.delete_buffer(m_buffer_id);
+    }
+
+    std::size_t opengl_stream_buffer::push(const void* data,
+                                           const std::size_t size,
+                                           const std::size_t alignment)
+    {
+        CHECK(alignment > 0);
+
+        const auto align_up = [alignment](const std::size_t value) {
+            return (value + alignment - 1) / alignment * alignment;
+        };
+
+        const std::size_t region_begin = m_region * m_frame_capacity;
+        std::size_t offset = align_up(region_begin + m_cursor);
+
+        if (offset + size > region_begin + m_frame_capacity)
+        {
+            allocate_storage(std::max(m_frame_capacity * 2, size + alignment));
+            offset = 0;
+        }
+
+        m_state_cache.bind_buffer(stream_target, m_buffer_id);
+
+        void* destination = glMapBufferRange(
+            stream_target,
+            offset,
+            size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT
+                | GL_MAP_UNSYNCHRONIZED_BIT);
+        opengl_check();
+        CHECK_NOTNULL(destination);
+
+        std::memcpy(destination, data, size);
+
+        CHECK(glUnmapBuffer(stream_target) == GL_TRUE);
+        opengl_check();
+
+        m_cursor = offset + size - m_region * m_frame_capacity;
+
+        return offset;
+    }
+
+    void opengl_stream_buffer::reserve(const std::size_t size)
+    {
+        if (m_cursor + size > m_frame_capacity)
+        {
+            allocate_storage(std::max(m_frame_capacity * 2, size));
+        }
+    }
+
+    void opengl_stream_buffer::end_frame()
+    {
+        if (m_cursor != 0)
+        {
+            m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            opengl_check();
+        }
+
+        m_region = (m_region + 1) % frames_in_flight;
+        m_cursor = 0;
+
+        wait_for_region(m_region);
+    }
+
+    GLuint opengl_stream_buffer::get_buffer_id() const noexcept
+    {
+        return m_buffer_id;
+    }
+
+    void opengl_stream_buffer::allocate_storage(const std::size_t frame_capacity)
+    {
+        // New storage is not used by the GPU yet, old one is kept alive
+        // by the driver until pending draws are finished.
+        delete_fences();
+
+        m_frame_capacity = frame_capacity;
+        m_region = 0;
+        m_cursor = 0;
+
+        m_state_cache.bind_buffer(stream_target, m_buffer_id);
+
+        glBufferData(stream_target,
+                     m_frame_capacity * frames_in_flight,
+                     nullptr,
+                     GL_STREAM_DRAW);
+        opengl_check();
+    }
+
+    void opengl_stream_buffer::wait_for_region(const std::size_t region)
+    {
+        GLsync& fence = m_fences[region];
+
+        if (!fence)
+        {
+            return;
+        }
+
+        constexpr GLuint64 timeout_ns { 1'000'000 };
+        GLbitfield flags { 0 };
+
+        for (;;)
+        {
+            const GLenum status = glClientWaitSync(fence, flags, timeout_ns);
+            opengl_check();
+            CHECK(status != GL_WAIT_FAILED);
+
+            if (status == GL_ALREADY_SIGNALED
+                || status == GL_CONDITION_SATISFIED)
+            {
+                break;
+            }
+
+            // Make sure the fence gets to the GPU, or we may wait forever.
+            flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        }
+
+        glDeleteSync(fence);
+        opengl_check();
+        fence = nullptr;
+    }
+
+    void opengl_stream_buffer::delete_fences()
+    {
+        for (GLsync& fence : m_fences)
+        {
+            if (fence)
+            {
+                glDeleteSync(fence);
+                opengl_check();
+                fence = nullptr;
+            }
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,76 @@
+#include "opengl-uniform-buffer.hxx"
+#include "opengl-debug.hxx"
+#include "opengl-state-cache.hxx"
+
+#include "helper.hxx"
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Camera changes are rare, a few updates per frame fit without
+    // growing the stream.
+    static constexpr std::size_t updates_per_frame { 8 };
+
+    static std::size_t get_uniform_buffer_alignment()
+    {
+        GLint alignment {};
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        opengl_check();
+        CHECK(alignment > 0);
+
+        return static_cast<std::size_t>(alignment);
+    }
+
+    opengl_uniform_buffer::opengl_uniform_buffer(
+        opengl_state_cache& state_cache,
+        const GLuint binding_point,
+        const std::size_t size)
+        : m_state_cache { state_cache }
+        , m_binding_point { binding_point }
+        , m_size { size }
+        , m_alignment { get_uniform_buffer_alignment() }
+        , m_stream { state_cache,
+                     (size + m_alignment - 1) / m_alignment * m_alignment
+                         * updates_per_frame }
+    {
+    }
+
+    opengl_uniform_buffer::~opengl_uniform_buffer() = default;
+
+    void opengl_uniform_buffer::update(const void* data, const std::size_t size)
+    {
+        CHECK(size <= m_size);
+
+        const std::size_t offset = m_stream.push(data, size, m_alignment);
+
+        // glBindBufferRange() binds the generic binding point too, keep
+        // the state cache in sync with it.
+        m_state_cache.bind_buffer(GL_UNIFORM_BUFFER, m_stream.get_buffer_id());
+
+        glBindBufferRange(GL_UNIFORM_BUFFER,
+                          m_binding_point,
+                          m_stream.get_buffer_id(),
+                          static_cast<GLintptr>(offset),
+                          static_cast<GLsizeiptr>(size));
+        opengl_check();
+    }
+
+    void opengl_uniform_buffer::end_frame()
+    {
+        m_stream.end_frame();
+    }
+
+    GLuint opengl_uniform_buffer::get_binding_point() const noexcept
+    {
+        return m_binding_point;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,76 @@
+#include "opengl-upload-queue.hxx"
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    void opengl_upload_queue::push(upload new_upload)
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        m_uploads.push_back(std::move(new_upload));
+    }
+
+    std::size_t opengl_upload_queue::execute(
+        const std::chrono::microseconds budget)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + budget;
+        std::size_t executed {};
+
+        do
+        {
+            upload current = pop();
+
+            if (!current)
+            {
+                break;
+            }
+
+            current();
+            executed++;
+        } while (std::chrono::steady_clock::now() < deadline);
+
+        return executed;
+    }
+
+    std::size_t opengl_upload_queue::execute_all()
+    {
+        std::size_t executed {};
+
+        for (upload current = pop(); current; current = pop())
+        {
+            current();
+            executed++;
+        }
+
+        return executed;
+    }
+
+    void opengl_upload_queue::clear()
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+        m_uploads.clear();
+    }
+
+    opengl_upload_queue::upload opengl_upload_queue::pop()
+    {
+        std::lock_guard<std::mutex> lock { m_mutex };
+
+        if (m_uploads.empty())
+        {
+            return {};
+        }
+
+        upload front = std::move(m_uploads.front());
+        m_uploads.pop_front();
+
+        return front;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
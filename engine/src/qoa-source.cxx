@@ -0,0 +1,241 @@
+#include "asset-pack.hxx"
+#include "audio-stream.hxx"
+#include "qoa.hxx"
+
+#include "helper.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Decodes one frame at a time, so a source holds the compressed
+    // frame and its samples only.
+    class qoa_source final : public audio_source
+    {
+    public:
+        explicit qoa_source(SDL_RWops* rwop)
+            : m_rwop { rwop }
+        {
+        }
+
+        ~qoa_source()
+        {
+            CHECK(!m_rwop->close(m_rwop));
+        }
+
+        qoa_source(const qoa_source&) = delete;
+        qoa_source(qoa_source&&) = delete;
+        qoa_source& operator=(const qoa_source&) = delete;
+        qoa_source& operator=(qoa_source&&) = delete;
+
+        // Reads the file header and the format of the first frame.
+        bool read_header();
+
+        std::size_t read(std::uint8_t* data, const std::size_t size) override
+        {
+            const std::size_t frame_size = sizeof(std::int16_t) * channels;
+            std::size_t bytes_read {};
+
+            while (size - bytes_read >= frame_size)
+            {
+                if (m_next_sample == m_decoded_samples && !decode_frame())
+                {
+                    break;
+                }
+
+                const std::size_t samples
+                    = std::min((size - bytes_read) / frame_size,
+                               m_decoded_samples - m_next_sample);
+
+                std::memcpy(data + bytes_read,
+                            m_samples.data() + m_next_sample * channels,
+                            samples * frame_size);
+
+                m_next_sample += samples;
+                bytes_read += samples * frame_size;
+            }
+
+            return bytes_read;
+        }
+
+        void rewind() override
+        {
+            CHECK(m_rwop->seek(m_rwop, qoa_file_header_size, SDL_RW_SEEK_SET)
+                  != -1);
+            m_decoded_samples = 0;
+            m_next_sample = 0;
+            m_samples_left = m_samples_total;
+        }
+
+        std::size_t get_size() const override
+        {
+            return m_samples_total * channels * sizeof(std::int16_t);
+        }
+
+    private:
+        // Returns false at the end of the file or on a broken frame.
+        bool decode_frame();
+
+        SDL_RWops* m_rwop { nullptr };
+        std::size_t m_samples_total {};
+        std::size_t m_samples_left {};
+
+        std::vector<std::uint8_t> m_frame {};
+        // Interleaved samples of the last decoded frame.
+        std::vector<std::int16_t> m_samples {};
+        std::size_t m_decoded_samples {};
+        std::size_t m_next_sample {};
+    };
+
+    bool qoa_source::read_header()
+    {
+        std::uint8_t header[qoa_file_header_size + qoa_frame_header_size] {};
+
+        if (m_rwop->read(m_rwop, header, sizeof(header))
+            != static_cast<Sint64>(sizeof(header)))
+        {
+            return false;
+        }
+
+        const std::uint64_t file_header = read_qoa_u64(header);
+        const std::uint64_t frame_header = read_qoa_u64(header + 8);
+
+        m_samples_total = file_header & 0xffffffff;
+        channels = static_cast<std::uint8_t>(frame_header >> 56);
+        freq = static_cast<int>((frame_header >> 32) & 0xffffff);
+        format = SDL_AUDIO_S16LSB;
+
+        // Streaming encoders don't know the number of samples and write
+        // 0, such files are not supported.
+        if (file_header >> 32 != qoa_magic || m_samples_total == 0
+            || channels == 0 || channels > qoa_channels_max || freq == 0)
+        {
+            return false;
+        }
+
+        m_frame.resize(get_qoa_frame_size(channels, qoa_frame_samples));
+        m_samples.resize(qoa_frame_samples * channels);
+
+        rewind();
+
+        return true;
+    }
+
+    bool qoa_source::decode_frame()
+    {
+        if (m_samples_left == 0
+            || m_rwop->read(m_rwop, m_frame.data(), qoa_frame_header_size)
+                != static_cast<Sint64>(qoa_frame_header_size))
+        {
+            return false;
+        }
+
+        const std::uint64_t frame_header = read_qoa_u64(m_frame.data());
+        const std::size_t frame_channels = frame_header >> 56;
+        const int frame_freq = static_cast<int>((frame_header >> 32) & 0xffffff);
+        const std::size_t samples = (frame_header >> 16) & 0xffff;
+        const std::size_t frame_size = frame_header & 0xffff;
+
+        // Every frame of a file has the same format.
+        if (frame_channels != channels || frame_freq != freq || samples == 0
+            || samples > qoa_frame_samples || samples > m_samples_left
+            || frame_size != get_qoa_frame_size(channels, samples))
+        {
+            return false;
+        }
+
+        const Sint64 rest = static_cast<Sint64>(frame_size - qoa_frame_header_size);
+
+        if (m_rwop->read(m_rwop, m_frame.data() + qoa_frame_header_size, rest)
+            != rest)
+        {
+            return false;
+        }
+
+        const std::uint8_t* bytes = m_frame.data() + qoa_frame_header_size;
+        std::array<qoa_lms, qoa_channels_max> lms {};
+
+        for (std::size_t c = 0; c < channels; c++)
+        {
+            std::uint64_t history = read_qoa_u64(bytes);
+            std::uint64_t weights = read_qoa_u64(bytes + 8);
+            bytes += 16;
+
+            for (std::size_t i = 0; i < 4; i++)
+            {
+                lms[c].history[i] = static_cast<std::int16_t>(history >> 48);
+                lms[c].weights[i] = static_cast<std::int16_t>(weights >> 48);
+                history <<= 16;
+                weights <<= 16;
+            }
+        }
+
+        for (std::size_t first = 0; first < samples; first += qoa_slice_samples)
+        {
+            const std::size_t last = std::min(first + qoa_slice_samples, samples);
+
+            for (std::size_t c = 0; c < channels; c++)
+            {
+                std::uint64_t slice = read_qoa_u64(bytes);
+                bytes += 8;
+
+                const auto& dequantized = qoa_dequantized[slice >> 60];
+                slice <<= 4;
+
+                for (std::size_t i = first; i < last; i++)
+                {
+                    const int residual = dequantized[slice >> 61];
+                    const int sample
+                        = clamp_qoa_sample(lms[c].predict() + residual);
+
+                    m_samples[i * channels + c]
+                        = static_cast<std::int16_t>(sample);
+
+                    lms[c].update(sample, residual);
+                    slice <<= 3;
+                }
+            }
+        }
+
+        m_samples_left -= samples;
+        m_decoded_samples = samples;
+        m_next_sample = 0;
+
+        return true;
+    }
+
+    std::unique_ptr<audio_source> open_qoa_source(const std::string_view path)
+    {
+        const asset_span asset = find_asset(path);
+
+        SDL_RWops* rwop = asset.empty()
+            ? SDL_RWFromFile(std::string { path }.c_str(), "rb")
+            : SDL_RWFromConstMem(asset.data, asset.size);
+
+        if (!rwop)
+        {
+            return nullptr;
+        }
+
+        auto source = std::make_unique<qoa_source>(rwop);
+
+        if (!source->read_header())
+        {
+            return nullptr;
+        }
+
+        return source;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
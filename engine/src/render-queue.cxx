@@ -0,0 +1,150 @@
+#include "render-queue.hxx"
+
+#include "helper.hxx"
+
+#include <algorithm>
+#include <array>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    constexpr std::uint64_t depth_bits { 24 };
+    constexpr std::uint64_t texture_bits { 24 };
+    constexpr std::uint64_t program_bits { 7 };
+    constexpr std::uint64_t layer_bits { 8 };
+
+    constexpr std::uint64_t depth_shift { 0 };
+    constexpr std::uint64_t texture_shift { depth_shift + depth_bits };
+    constexpr std::uint64_t program_shift { texture_shift + texture_bits };
+    constexpr std::uint64_t layer_shift { program_shift + program_bits };
+    constexpr std::uint64_t translucent_shift { layer_shift + layer_bits };
+
+    // Everything what is drawn with the same program and texture.
+    constexpr std::uint64_t state_mask {
+        ((std::uint64_t { 1 } << (program_bits + texture_bits)) - 1)
+        << texture_shift
+    };
+
+    std::uint64_t make_sort_key(const sort_key_fields& fields)
+    {
+        constexpr std::uint64_t max_depth { (1u << depth_bits) - 1 };
+        constexpr std::uint64_t max_layer { (1u << layer_bits) - 1 };
+
+        CHECK(fields.program < (1u << program_bits));
+
+        const float depth = std::clamp(fields.depth, 0.f, 1.f);
+        auto quantized_depth = static_cast<std::uint64_t>(depth * max_depth);
+        std::uint64_t layer { fields.layer };
+
+        // Opaque commands go front-to-back to let early depth test reject
+        // hidden fragments, translucent ones go back-to-front to blend
+        // correctly.
+        if (fields.translucent)
+        {
+            quantized_depth = max_depth - quantized_depth;
+        }
+        else
+        {
+            layer = max_layer - layer;
+        }
+
+        return std::uint64_t { fields.translucent } << translucent_shift
+            | layer << layer_shift
+            | std::uint64_t { fields.program } << program_shift
+            | (std::uint64_t { fields.texture } & ((1u << texture_bits) - 1))
+            << texture_shift
+            | quantized_depth << depth_shift;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    void render_queue::push(const std::uint64_t key,
+                            const std::uint32_t command)
+    {
+        m_items.push_back(item { key, command });
+    }
+
+    void render_queue::sort()
+    {
+        if (m_items.size() < 2)
+        {
+            return;
+        }
+
+        // Bits which differ between keys, bytes without them are skipped.
+        std::uint64_t differing_bits {};
+        for (const item& it : m_items)
+        {
+            differing_bits |= it.key ^ m_items.front().key;
+        }
+
+        m_scratch.resize(m_items.size());
+
+        for (std::uint32_t shift = 0; shift < 64; shift += 8)
+        {
+            if (((differing_bits >> shift) & 0xff) == 0)
+            {
+                continue;
+            }
+
+            std::array<std::size_t, 256> offsets {};
+
+            for (const item& it : m_items)
+            {
+                offsets[(it.key >> shift) & 0xff]++;
+            }
+
+            std::size_t sum {};
+            for (std::size_t& offset : offsets)
+            {
+                const std::size_t count = offset;
+                offset = sum;
+                sum += count;
+            }
+
+            for (const item& it : m_items)
+            {
+                m_scratch[offsets[(it.key >> shift) & 0xff]++] = it;
+            }
+
+            m_items.swap(m_scratch);
+        }
+    }
+
+    void render_queue::clear()
+    {
+        m_items.clear();
+    }
+
+    const std::vector<render_queue::item>&
+    render_queue::get_items() const noexcept
+    {
+        return m_items;
+    }
+
+    std::size_t render_queue::count_state_changes() const noexcept
+    {
+        std::size_t changes {};
+
+        for (std::size_t i = 0; i < m_items.size(); i++)
+        {
+            if (i == 0
+                || (m_items[i].key & state_mask)
+                    != (m_items[i - 1].key & state_mask))
+            {
+                changes++;
+            }
+        }
+
+        return changes;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
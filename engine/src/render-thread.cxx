@@ -0,0 +1,169 @@
+#include "render-thread.hxx"
+
+#include "helper.hxx"
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    render_thread::~render_thread()
+    {
+        // stop() should be called while the GL context is still alive.
+        CHECK(!m_worker.joinable());
+    }
+
+    void render_thread::start(const bool threaded, command on_start)
+    {
+        CHECK(!m_worker.joinable());
+
+        m_threaded = threaded;
+        m_stopping = false;
+
+        if (!m_threaded)
+        {
+            m_frame_start = std::chrono::steady_clock::now();
+            on_start();
+            return;
+        }
+
+        m_worker = std::thread { [this, on_start = std::move(on_start)] {
+            on_start();
+            run();
+        } };
+    }
+
+    void render_thread::stop(command on_stop)
+    {
+        record(std::move(on_stop));
+
+        if (!m_threaded)
+        {
+            return;
+        }
+
+        submit_frame();
+
+        {
+            std::lock_guard<std::mutex> lock { m_mutex };
+            m_stopping = true;
+        }
+
+        m_frame_submitted.notify_one();
+        m_worker.join();
+    }
+
+    void render_thread::record(command cmd)
+    {
+        if (!m_threaded)
+        {
+            cmd();
+            return;
+        }
+
+        m_recording.push_back(std::move(cmd));
+    }
+
+    void render_thread::submit_frame()
+    {
+        if (!m_threaded)
+        {
+            m_frame_start = std::chrono::steady_clock::now();
+            return;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock { m_mutex };
+
+            m_frame_executed.wait(lock, [this] {
+                return m_pending.size() < frames_in_flight;
+            });
+
+            m_pending.push_back(std::move(m_recording));
+            m_recording.clear();
+
+            if (!m_free_frames.empty())
+            {
+                m_recording = std::move(m_free_frames.back());
+                m_free_frames.pop_back();
+            }
+        }
+
+        m_frame_submitted.notify_one();
+    }
+
+    void render_thread::flush()
+    {
+        if (!m_threaded)
+        {
+            return;
+        }
+
+        submit_frame();
+
+        std::unique_lock<std::mutex> lock { m_mutex };
+        m_frame_executed.wait(lock, [this] { return m_pending.empty(); });
+    }
+
+    bool render_thread::is_threaded() const noexcept
+    {
+        return m_threaded;
+    }
+
+    std::chrono::steady_clock::time_point
+    render_thread::get_frame_start() const noexcept
+    {
+        return m_frame_start;
+    }
+
+    void render_thread::run()
+    {
+        for (;;)
+        {
+            frame* current { nullptr };
+
+            {
+                std::unique_lock<std::mutex> lock { m_mutex };
+
+                m_frame_submitted.wait(lock, [this] {
+                    return !m_pending.empty() || m_stopping;
+                });
+
+                if (m_pending.empty())
+                {
+                    return;
+                }
+
+                // References to deque elements survive push_back().
+                current = &m_pending.front();
+            }
+
+            m_frame_start = std::chrono::steady_clock::now();
+
+            for (command& cmd : *current)
+            {
+                cmd();
+            }
+
+            {
+                std::lock_guard<std::mutex> lock { m_mutex };
+
+                frame executed = std::move(m_pending.front());
+                m_pending.pop_front();
+
+                // Release resources captured by commands right away.
+                executed.clear();
+                m_free_frames.push_back(std::move(executed));
+            }
+
+            m_frame_executed.notify_all();
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,279 @@
+#include "resource-manager.hxx"
+
+#include "helper.hxx"
+
+#include <filesystem>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    // Files may live in Android assets, which the filesystem can't see,
+    // so paths are normalized lexically ("res/./a.png" and
+    // "res/../res/a.png" are both "res/a.png") without touching the disk.
+    static std::string get_resource_key(const std::string_view path)
+    {
+        return std::filesystem::path { path }.lexically_normal().generic_string();
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    template <typename T>
+    bool resource_manager::resource_pool<T>::find(const std::string& key,
+                                                  resource_handle<T>& handle)
+    {
+        const auto it = m_indices.find(key);
+
+        if (it == m_indices.end())
+        {
+            return false;
+        }
+
+        slot& found = m_slots[it->second];
+        found.references++;
+        handle = { it->second, found.generation };
+
+        return true;
+    }
+
+    template <typename T>
+    resource_handle<T> resource_manager::resource_pool<T>::insert(
+        const std::string& key,
+        T* resource)
+    {
+        CHECK_NOTNULL(resource);
+
+        std::uint32_t index {};
+
+        if (!m_free_slots.empty())
+        {
+            index = m_free_slots.back();
+            m_free_slots.pop_back();
+        }
+        else
+        {
+            index = static_cast<std::uint32_t>(m_slots.size());
+            m_slots.emplace_back();
+        }
+
+        slot& new_slot = m_slots[index];
+        new_slot.resource = resource;
+        new_slot.references = 1;
+        new_slot.key = key;
+
+        const auto [it, inserted] = m_indices.insert({ key, index });
+        CHECK(inserted);
+
+        return { index, new_slot.generation };
+    }
+
+    template <typename T>
+    T* resource_manager::resource_pool<T>::get(
+        const resource_handle<T> handle) const
+    {
+        const slot* found = get_slot(handle);
+        return found ? found->resource : nullptr;
+    }
+
+    template <typename T>
+    T* resource_manager::resource_pool<T>::release(resource_handle<T>& handle)
+    {
+        CHECK_NOTNULL(get_slot(handle));
+
+        slot& released = m_slots[handle.index];
+        handle = {};
+
+        if (--released.references > 0)
+        {
+            return nullptr;
+        }
+
+        T* resource = released.resource;
+
+        m_indices.erase(released.key);
+        released.resource = nullptr;
+        released.key.clear();
+
+        // Skip 0 on wrap around, it marks invalid handles.
+        if (++released.generation == 0)
+        {
+            released.generation = 1;
+        }
+
+        m_free_slots.push_back(
+            static_cast<std::uint32_t>(&released - m_slots.data()));
+
+        return resource;
+    }
+
+    template <typename T>
+    resource_usage resource_manager::resource_pool<T>::get_usage() const
+    {
+        resource_usage usage {};
+
+        for (const slot& current : m_slots)
+        {
+            if (current.resource)
+            {
+                usage.resources++;
+                usage.references += current.references;
+                usage.bytes += current.resource->get_memory_size();
+            }
+        }
+
+        return usage;
+    }
+
+    template <typename T>
+    const typename resource_manager::resource_pool<T>::slot*
+    resource_manager::resource_pool<T>::get_slot(
+        const resource_handle<T> handle) const
+    {
+        if (!handle.is_valid() || handle.index >= m_slots.size())
+        {
+            return nullptr;
+        }
+
+        const slot& found = m_slots[handle.index];
+
+        if (found.generation != handle.generation || !found.resource)
+        {
+            return nullptr;
+        }
+
+        return &found;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    resource_manager::resource_manager(iengine* engine)
+        : m_engine { engine }
+    {
+        CHECK_NOTNULL(m_engine);
+    }
+
+    resource_manager::~resource_manager()
+    {
+        CHECK(m_textures.get_usage().resources == 0);
+        CHECK(m_texture_arrays.get_usage().resources == 0);
+        CHECK(m_sounds.get_usage().resources == 0);
+    }
+
+    texture_handle resource_manager::acquire_texture(const std::string_view path)
+    {
+        const std::string key = get_resource_key(path);
+        texture_handle handle {};
+
+        if (!m_textures.find(key, handle))
+        {
+            handle = m_textures.insert(key, m_engine->create_texture(key));
+        }
+
+        return handle;
+    }
+
+    texture_array_handle resource_manager::acquire_texture_array(
+        const std::vector<std::string_view>& paths)
+    {
+        // Same layers in the same order make the same array.
+        std::vector<std::string> layer_keys {};
+        std::string key {};
+
+        for (const std::string_view path : paths)
+        {
+            layer_keys.push_back(get_resource_key(path));
+            key += layer_keys.back();
+            key += '\n';
+        }
+
+        texture_array_handle handle {};
+
+        if (!m_texture_arrays.find(key, handle))
+        {
+            const std::vector<std::string_view> layer_paths {
+                layer_keys.begin(), layer_keys.end()
+            };
+
+            handle = m_texture_arrays.insert(
+                key, m_engine->create_texture_array(layer_paths));
+        }
+
+        return handle;
+    }
+
+    sound_handle resource_manager::acquire_sound(const std::string_view path)
+    {
+        const std::string key = get_resource_key(path);
+        sound_handle handle {};
+
+        if (!m_sounds.find(key, handle))
+        {
+            handle = m_sounds.insert(key, m_engine->create_audio_buffer(key));
+        }
+
+        return handle;
+    }
+
+    itexture* resource_manager::get(const texture_handle handle) const
+    {
+        return m_textures.get(handle);
+    }
+
+    itexture_array* resource_manager::get(
+        const texture_array_handle handle) const
+    {
+        return m_texture_arrays.get(handle);
+    }
+
+    iaudio_buffer* resource_manager::get(const sound_handle handle) const
+    {
+        return m_sounds.get(handle);
+    }
+
+    void resource_manager::release(texture_handle& handle)
+    {
+        if (itexture* texture = m_textures.release(handle))
+        {
+            m_engine->destroy_texture(texture);
+        }
+    }
+
+    void resource_manager::release(texture_array_handle& handle)
+    {
+        if (itexture_array* texture_array = m_texture_arrays.release(handle))
+        {
+            m_engine->destroy_texture_array(texture_array);
+        }
+    }
+
+    void resource_manager::release(sound_handle& handle)
+    {
+        if (iaudio_buffer* sound = m_sounds.release(handle))
+        {
+            m_engine->destroy_audio_buffer(sound);
+        }
+    }
+
+    resource_usage resource_manager::get_usage(const resource_type type) const
+    {
+        switch (type)
+        {
+        case resource_type::texture:
+            return m_textures.get_usage();
+        case resource_type::texture_array:
+            return m_texture_arrays.get_usage();
+        case resource_type::sound:
+            return m_sounds.get_usage();
+        }
+
+        return {};
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
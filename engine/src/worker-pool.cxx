@@ -0,0 +1,104 @@
+#include "worker-pool.hxx"
+
+#include "helper.hxx"
+
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace arci
+{
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+    worker_pool::worker_pool(const std::size_t threads_number)
+    {
+        const std::size_t number = std::max<std::size_t>(threads_number, 1);
+
+        for (std::size_t i = 0; i < number; i++)
+        {
+            m_threads.emplace_back([this] { run(); });
+        }
+    }
+
+    worker_pool::~worker_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock { m_mutex };
+            m_stopping = true;
+            m_tasks.clear();
+        }
+
+        m_task_submitted.notify_all();
+
+        for (std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    void worker_pool::submit(task new_task)
+    {
+        {
+            std::lock_guard<std::mutex> lock { m_mutex };
+            CHECK(!m_stopping);
+            m_tasks.push_back(std::move(new_task));
+        }
+
+        m_task_submitted.notify_one();
+    }
+
+    void worker_pool::wait_idle()
+    {
+        std::unique_lock<std::mutex> lock { m_mutex };
+
+        m_task_finished.wait(lock, [this] {
+            return m_tasks.empty() && m_running_tasks == 0;
+        });
+    }
+
+    std::size_t worker_pool::get_default_threads_number()
+    {
+        const std::size_t cores = std::thread::hardware_concurrency();
+        return cores > 2 ? cores - 2 : 1;
+    }
+
+    void worker_pool::run()
+    {
+        for (;;)
+        {
+            task current_task {};
+
+            {
+                std::unique_lock<std::mutex> lock { m_mutex };
+
+                m_task_submitted.wait(lock, [this] {
+                    return m_stopping || !m_tasks.empty();
+                });
+
+                if (m_stopping)
+                {
+                    return;
+                }
+
+                current_task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+                m_running_tasks++;
+            }
+
+            current_task();
+
+            {
+                std::lock_guard<std::mutex> lock { m_mutex };
+                m_running_tasks--;
+            }
+
+            m_task_finished.notify_all();
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////////
+
+} // namespace arci
+
+///////////////////////////////////////////////////////////////////////////////
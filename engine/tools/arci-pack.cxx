@@ -0,0 +1,168 @@
+// Packs asset files into one archive the engine maps into memory (see
+// asset-pack.hxx for the layout).
+//
+// Usage: arci-pack <output> <name> <file> [<name> <file> ...]
+//
+// `name` is the path the engine asks the file by, e.g. "res/ball.png".
+
+#include "asset-pack.hxx"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct input_file
+    {
+        std::string name {};
+        std::string path {};
+    };
+
+    bool read_file(const std::string& path, std::vector<char>& content)
+    {
+        std::ifstream file { path, std::ios::binary };
+
+        if (!file)
+        {
+            return false;
+        }
+
+        content.assign(std::istreambuf_iterator<char> { file },
+                       std::istreambuf_iterator<char> {});
+
+        return !file.bad();
+    }
+
+    void pad_to(std::vector<char>& pack, const std::size_t alignment)
+    {
+        pack.resize((pack.size() + alignment - 1) / alignment * alignment);
+    }
+
+    template <typename T>
+    void write_at(std::vector<char>& pack, const std::size_t offset, const T& value)
+    {
+        std::copy_n(reinterpret_cast<const char*>(&value),
+                    sizeof(T),
+                    pack.begin() + offset);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc % 2 != 0)
+    {
+        fmt::print(stderr,
+                   "Usage: arci-pack <output> <name> <file> "
+                   "[<name> <file> ...]\n");
+        return 1;
+    }
+
+    std::vector<input_file> inputs {};
+
+    for (int i = 2; i < argc; i += 2)
+    {
+        inputs.push_back({ argv[i], argv[i + 1] });
+    }
+
+    // Same inputs always give the same pack.
+    std::sort(inputs.begin(),
+              inputs.end(),
+              [](const input_file& a, const input_file& b) {
+                  return a.name < b.name;
+              });
+
+    const auto duplicate = std::adjacent_find(
+        inputs.begin(),
+        inputs.end(),
+        [](const input_file& a, const input_file& b) {
+            return a.name == b.name;
+        });
+
+    if (duplicate != inputs.end())
+    {
+        fmt::print(stderr, "Duplicate entry {}\n", duplicate->name);
+        return 1;
+    }
+
+    std::vector<char> pack(sizeof(arci::asset_pack_header));
+    std::vector<arci::asset_pack_entry> entries {};
+
+    for (const input_file& input : inputs)
+    {
+        std::vector<char> content {};
+
+        if (!read_file(input.path, content))
+        {
+            fmt::print(stderr, "Error on reading {}\n", input.path);
+            return 1;
+        }
+
+        pad_to(pack, arci::asset_pack_alignment);
+
+        arci::asset_pack_entry entry {};
+        entry.offset = pack.size();
+        entry.size = content.size();
+        entries.push_back(entry);
+
+        pack.insert(pack.end(), content.begin(), content.end());
+    }
+
+    pad_to(pack, alignof(arci::asset_pack_entry));
+
+    arci::asset_pack_header header {};
+    header.version = arci::asset_pack_version;
+    header.entries_number = static_cast<std::uint32_t>(entries.size());
+    header.index_offset = pack.size();
+
+    pack.resize(pack.size() + entries.size() * sizeof(arci::asset_pack_entry));
+
+    for (std::size_t i = 0; i < inputs.size(); i++)
+    {
+        entries[i].name_offset = static_cast<std::uint32_t>(pack.size());
+        entries[i].name_size = static_cast<std::uint32_t>(inputs[i].name.size());
+        pack.insert(pack.end(), inputs[i].name.begin(), inputs[i].name.end());
+
+        write_at(pack,
+                 header.index_offset + i * sizeof(arci::asset_pack_entry),
+                 entries[i]);
+    }
+
+    write_at(pack, 0, header);
+
+    // Written next to the output first, so an interrupted build never
+    // leaves a truncated pack behind.
+    const std::string output { argv[1] };
+    const std::string temporary_output { output + ".tmp" };
+
+    {
+        std::ofstream file { temporary_output, std::ios::binary };
+        file.write(pack.data(), static_cast<std::streamsize>(pack.size()));
+
+        if (!file)
+        {
+            fmt::print(stderr, "Error on writing {}\n", temporary_output);
+            return 1;
+        }
+    }
+
+    std::remove(output.c_str());
+
+    if (std::rename(temporary_output.c_str(), output.c_str()) != 0)
+    {
+        fmt::print(stderr, "Error on writing {}\n", output);
+        return 1;
+    }
+
+    fmt::print("Packed {} files into {} ({} bytes)\n",
+               inputs.size(),
+               output,
+               pack.size());
+
+    return 0;
+}
@@ -0,0 +1,325 @@
+// Compresses a 16-bit PCM WAVE file to QOA (see qoa.hxx for the format),
+// about 5 times smaller than the WAVE file.
+//
+// Usage: arci-qoa <input.wav> <output.qoa>
+
+#include "qoa.hxx"
+
+#include <fmt/core.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct wav_file
+    {
+        std::size_t channels {};
+        std::uint32_t freq {};
+        // Interleaved.
+        std::vector<std::int16_t> samples {};
+    };
+
+    bool read_file(const std::string& path, std::vector<char>& content)
+    {
+        std::ifstream file { path, std::ios::binary };
+
+        if (!file)
+        {
+            return false;
+        }
+
+        content.assign(std::istreambuf_iterator<char> { file },
+                       std::istreambuf_iterator<char> {});
+
+        return !file.bad();
+    }
+
+    // WAVE data is little-endian, as all platforms we run on.
+    template <typename T>
+    T get_value(const char* bytes)
+    {
+        T value {};
+        std::memcpy(&value, bytes, sizeof(T));
+        return value;
+    }
+
+    bool parse_wav(const std::vector<char>& content, wav_file& wav)
+    {
+        if (content.size() < 12 || std::memcmp(content.data(), "RIFF", 4) != 0
+            || std::memcmp(content.data() + 8, "WAVE", 4) != 0)
+        {
+            return false;
+        }
+
+        bool format_found { false };
+        std::size_t offset { 12 };
+
+        while (content.size() - offset >= 8)
+        {
+            const char* chunk = content.data() + offset;
+            const std::size_t chunk_size = get_value<std::uint32_t>(chunk + 4);
+            const std::size_t size
+                = std::min(chunk_size, content.size() - offset - 8);
+
+            if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 16)
+            {
+                const auto encoding = get_value<std::uint16_t>(chunk + 8);
+                const auto bits = get_value<std::uint16_t>(chunk + 22);
+
+                wav.channels = get_value<std::uint16_t>(chunk + 10);
+                wav.freq = get_value<std::uint32_t>(chunk + 12);
+
+                constexpr std::uint16_t pcm { 1 };
+                constexpr std::uint16_t extensible { 0xFFFE };
+
+                if ((encoding != pcm && encoding != extensible) || bits != 16
+                    || wav.channels == 0
+                    || wav.channels > arci::qoa_channels_max
+                    || wav.freq == 0 || wav.freq > 0xffffff)
+                {
+                    return false;
+                }
+
+                format_found = true;
+            }
+            else if (std::memcmp(chunk, "data", 4) == 0 && format_found)
+            {
+                const std::size_t frame_size = 2 * wav.channels;
+                wav.samples.resize(size / frame_size * wav.channels);
+                std::memcpy(wav.samples.data(),
+                            chunk + 8,
+                            wav.samples.size() * sizeof(std::int16_t));
+                return true;
+            }
+
+            offset += 8 + size + (size & 1);
+        }
+
+        return false;
+    }
+
+    void write_u64(std::vector<std::uint8_t>& output, const std::uint64_t value)
+    {
+        for (int shift = 56; shift >= 0; shift -= 8)
+        {
+            output.push_back(static_cast<std::uint8_t>(value >> shift));
+        }
+    }
+
+    std::uint64_t pack_s16(const std::array<int, 4>& values)
+    {
+        std::uint64_t packed {};
+
+        for (const int value : values)
+        {
+            packed = packed << 16 | static_cast<std::uint16_t>(value);
+        }
+
+        return packed;
+    }
+
+    // Quantized value (0..7) of a scaled residual (-8..8).
+    constexpr std::array<int, 17> quantized_residuals {
+        7, 7, 7, 5, 5, 3, 3, 1, 0, 0, 2, 2, 4, 4, 6, 6, 6
+    };
+
+    // Division by the scalefactor rounded away from zero, as the
+    // dequantization table is.
+    int divide(const int value, const std::size_t scalefactor_index)
+    {
+        const int scalefactor = arci::qoa_scalefactors[scalefactor_index];
+        const std::int64_t reciprocal
+            = ((1 << 16) + scalefactor - 1) / scalefactor;
+        const int quotient
+            = static_cast<int>((value * reciprocal + (1 << 15)) >> 16);
+
+        return quotient + ((value > 0) - (value < 0))
+            - ((quotient > 0) - (quotient < 0));
+    }
+
+    // Tries every scalefactor for a slice and keeps the one with the
+    // smallest error.
+    std::uint64_t encode_slice(const std::int16_t* samples,
+                               const std::size_t stride,
+                               const std::size_t samples_number,
+                               arci::qoa_lms& lms)
+    {
+        std::uint64_t best_error { std::numeric_limits<std::uint64_t>::max() };
+        std::uint64_t best_slice {};
+        arci::qoa_lms best_lms {};
+
+        for (std::size_t s = 0; s < arci::qoa_scalefactors.size(); s++)
+        {
+            arci::qoa_lms current_lms = lms;
+            std::uint64_t slice = s;
+            std::uint64_t error {};
+
+            for (std::size_t i = 0; i < samples_number && error < best_error;
+                 i++)
+            {
+                const int sample = samples[i * stride];
+                const int predicted = current_lms.predict();
+                const int scaled
+                    = std::clamp(divide(sample - predicted, s), -8, 8);
+                const int quantized = quantized_residuals[scaled + 8];
+                const int dequantized = arci::qoa_dequantized[s][quantized];
+                const int reconstructed
+                    = arci::clamp_qoa_sample(predicted + dequantized);
+
+                const std::int64_t difference = sample - reconstructed;
+                error += static_cast<std::uint64_t>(difference * difference);
+
+                current_lms.update(reconstructed, dequantized);
+                slice = slice << 3 | static_cast<std::uint64_t>(quantized);
+            }
+
+            // Large weights make the predictor unstable and don't fit
+            // into 16 bits of the frame header.
+            std::uint64_t weights_power {};
+
+            for (const int weight : current_lms.weights)
+            {
+                weights_power += static_cast<std::uint64_t>(
+                    static_cast<std::int64_t>(weight) * weight);
+            }
+
+            if (weights_power > 0x2fffffff)
+            {
+                error += weights_power - 0x2fffffff;
+            }
+
+            if (error < best_error)
+            {
+                best_error = error;
+                best_slice = slice;
+                best_lms = current_lms;
+            }
+        }
+
+        lms = best_lms;
+
+        // A short last slice is padded with zero residuals.
+        return best_slice << (arci::qoa_slice_samples - samples_number) * 3;
+    }
+
+    std::vector<std::uint8_t> encode(const wav_file& wav)
+    {
+        const std::size_t channels = wav.channels;
+        const std::size_t samples_total = wav.samples.size() / channels;
+
+        std::vector<std::uint8_t> output {};
+        write_u64(output,
+                  static_cast<std::uint64_t>(arci::qoa_magic) << 32
+                      | samples_total);
+
+        std::vector<arci::qoa_lms> lms(channels);
+
+        for (arci::qoa_lms& channel_lms : lms)
+        {
+            channel_lms.weights = { 0, 0, -(1 << 13), 1 << 14 };
+        }
+
+        for (std::size_t first = 0; first < samples_total;
+             first += arci::qoa_frame_samples)
+        {
+            const std::size_t samples
+                = std::min(arci::qoa_frame_samples, samples_total - first);
+
+            write_u64(output,
+                      static_cast<std::uint64_t>(channels) << 56
+                          | static_cast<std::uint64_t>(wav.freq) << 32
+                          | samples << 16
+                          | arci::get_qoa_frame_size(channels, samples));
+
+            for (const arci::qoa_lms& channel_lms : lms)
+            {
+                write_u64(output, pack_s16(channel_lms.history));
+                write_u64(output, pack_s16(channel_lms.weights));
+            }
+
+            for (std::size_t slice = 0; slice < samples;
+                 slice += arci::qoa_slice_samples)
+            {
+                const std::size_t slice_samples
+                    = std::min(arci::qoa_slice_samples, samples - slice);
+
+                for (std::size_t c = 0; c < channels; c++)
+                {
+                    write_u64(output,
+                              encode_slice(wav.samples.data()
+                                               + (first + slice) * channels + c,
+                                           channels,
+                                           slice_samples,
+                                           lms[c]));
+                }
+            }
+        }
+
+        return output;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        fmt::print(stderr, "Usage: arci-qoa <input.wav> <output.qoa>\n");
+        return 1;
+    }
+
+    const std::string input { argv[1] };
+    std::vector<char> content {};
+    wav_file wav {};
+
+    if (!read_file(input, content))
+    {
+        fmt::print(stderr, "Error on reading {}\n", input);
+        return 1;
+    }
+
+    if (!parse_wav(content, wav))
+    {
+        fmt::print(stderr, "{} is not a 16-bit PCM WAVE file\n", input);
+        return 1;
+    }
+
+    const std::vector<std::uint8_t> qoa = encode(wav);
+
+    // Written next to the output first, as arci-pack does.
+    const std::string output { argv[2] };
+    const std::string temporary_output { output + ".tmp" };
+
+    {
+        std::ofstream file { temporary_output, std::ios::binary };
+        file.write(reinterpret_cast<const char*>(qoa.data()),
+                   static_cast<std::streamsize>(qoa.size()));
+
+        if (!file)
+        {
+            fmt::print(stderr, "Error on writing {}\n", temporary_output);
+            return 1;
+        }
+    }
+
+    std::remove(output.c_str());
+
+    if (std::rename(temporary_output.c_str(), output.c_str()) != 0)
+    {
+        fmt::print(stderr, "Error on writing {}\n", output);
+        return 1;
+    }
+
+    fmt::print("Compressed {} to {} ({} -> {} bytes)\n",
+               input,
+               output,
+               content.size(),
+               qoa.size());
+
+    return 0;
+}
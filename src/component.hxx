@@ -17,9 +17,24 @@ namespace arcanoid
         float height {};
     };
 
+    // Layers are drawn from the lowest to the highest one.
+    enum class draw_layer : std::uint8_t
+    {
+        background,
+        bricks,
+        actors
+    };
+
     struct sprite
     {
         arci::itexture* texture { nullptr };
+
+        // Used instead of `texture` for sprites of a same-sized family.
+        arci::itexture_array* texture_array { nullptr };
+        std::uint32_t texture_layer {};
+
+        draw_layer layer { draw_layer::actors };
+        arci::blend_mode blend { arci::blend_mode::alpha };
     };
 
     struct transform2d
@@ -28,6 +43,12 @@ namespace arcanoid
         float speed_y { 0.f };
     };
 
+    // Entity is drawn as a part of the static mesh (e.g. brick field)
+    // instead of being streamed by the sprite system every frame.
+    struct static_geometry
+    {
+    };
+
     struct key_inputs
     {
     };
@@ -7,6 +7,7 @@ namespace arcanoid
         positions.erase(id);
         bounds.erase(id);
         sprites.erase(id);
+        static_geometries.erase(id);
         transformations.erase(id);
         inputs.erase(id);
         collidable_entities.erase(id);
@@ -13,6 +13,7 @@ namespace arcanoid
         std::unordered_map<entity, position> positions {};
         std::unordered_map<entity, bound> bounds {};
         std::unordered_map<entity, sprite> sprites {};
+        std::unordered_map<entity, static_geometry> static_geometries {};
         std::unordered_map<entity, transform2d> transformations {};
         std::unordered_map<entity, key_inputs> inputs {};
         std::unordered_map<entity, collision> collidable_entities {};
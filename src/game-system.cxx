@@ -15,56 +15,175 @@ namespace arcanoid
         {
             if (a_coordinator.sprites.count(i)
                 && a_coordinator.positions.count(i)
-                && a_coordinator.bounds.count(i))
+                && a_coordinator.bounds.count(i)
+                && !a_coordinator.static_geometries.count(i))
             {
                 const position& top_left = a_coordinator.positions.at(i);
-                arci::itexture* texture = a_coordinator.sprites.at(i).texture;
-                arci::CHECK_NOTNULL(texture);
+                const sprite& spr = a_coordinator.sprites.at(i);
 
                 const auto [w, h] = a_coordinator.bounds.at(i);
 
-                // Translate from world to ndc coordinates.
-                auto from_world_to_ndc = [this](const position& world_pos) {
-                    return position { -1.f + world_pos.x * 2.f / screen_width,
-                                      1.f - world_pos.y * 2 / screen_height };
-                };
+                arci::CHECK(spr.texture || spr.texture_array);
+
+                // Positions stay in world units, camera transforms them
+                // to NDC on GPU. Engine sorts and batches the sprites.
+                arci::sprite_command command {};
+                command.x = top_left.x;
+                command.y = top_left.y;
+                command.width = w;
+                command.height = h;
+                command.texture = spr.texture;
+                command.texture_array = spr.texture_array;
+                command.texture_layer = spr.texture_layer;
+                command.layer = static_cast<std::uint8_t>(spr.layer);
+                command.blend = spr.blend;
+
+                engine->submit(command);
+            }
+        }
+    }
+
+    // Quad of the sprite in world units, `z` holds the texture array layer.
+    static std::array<arci::vertex, 4> make_brick_quad(const position& top_left,
+                                                       const bound& b,
+                                                       const std::uint32_t layer)
+    {
+        const float z = static_cast<float>(layer);
+
+        return {
+            arci::vertex { top_left.x, top_left.y, z, 0.f, 0.f, 0.f, 1.f, 0.f, 1.f },
+            arci::vertex { top_left.x + b.width, top_left.y, z, 0.f, 0.f, 0.f, 1.f, 1.f, 1.f },
+            arci::vertex { top_left.x + b.width, top_left.y + b.height, z, 0.f, 0.f, 0.f, 1.f, 1.f, 0.f },
+            arci::vertex { top_left.x, top_left.y + b.height, z, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f },
+        };
+    }
+
+    void brick_field_system::build(arci::iengine* engine,
+                                   const coordinator& a_coordinator)
+    {
+        destroy(engine);
+
+        std::vector<arci::vertex> vertices {};
+        std::vector<std::uint32_t> indices {};
+
+        for (entity i = 1; i <= entities_number; i++)
+        {
+            if (!a_coordinator.static_geometries.count(i)
+                || !a_coordinator.sprites.count(i))
+            {
+                continue;
+            }
 
-                position top_right_ndc {
-                    from_world_to_ndc({ top_left.x + w, top_left.y })
-                };
+            const sprite& spr = a_coordinator.sprites.at(i);
+
+            // The whole field is drawn with one texture array.
+            arci::CHECK_NOTNULL(spr.texture_array);
+            arci::CHECK(!m_texture_array || m_texture_array == spr.texture_array);
+            m_texture_array = spr.texture_array;
+
+            const auto quad = make_brick_quad(a_coordinator.positions.at(i),
+                                              a_coordinator.bounds.at(i),
+                                              spr.texture_layer);
+
+            const auto first = static_cast<std::uint32_t>(vertices.size());
+            vertices.insert(vertices.end(), quad.begin(), quad.end());
+            indices.insert(indices.end(),
+                           { first, first + 1, first + 2, first, first + 3, first + 2 });
+
+            m_quads.push_back(brick_quad { i, spr.texture_layer, true });
+        }
 
-                position bottom_right_ndc {
-                    from_world_to_ndc({ top_left.x + w,
-                                        top_left.y + h })
-                };
+        if (m_quads.empty())
+        {
+            return;
+        }
 
-                position bottom_left_ndc {
-                    from_world_to_ndc({ top_left.x, top_left.y + h })
-                };
+        m_vertex_buffer = engine->create_vertex_buffer(vertices);
+        m_index_buffer = engine->create_ebo(indices);
+        arci::CHECK_NOTNULL(m_vertex_buffer);
+        arci::CHECK_NOTNULL(m_index_buffer);
+    }
 
-                position top_left_ndc = from_world_to_ndc(top_left);
+    void brick_field_system::update(const coordinator& a_coordinator)
+    {
+        for (std::size_t quad_index = 0; quad_index < m_quads.size(); quad_index++)
+        {
+            brick_quad& quad = m_quads[quad_index];
 
-                std::vector<arci::vertex> vertices {
-                    { top_left_ndc.x, top_left_ndc.y, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f, 1.f },
-                    { top_right_ndc.x, top_right_ndc.y, 1.f, 0.f, 0.f, 0.f, 1.f, 1.f, 1.f },
-                    { bottom_right_ndc.x, bottom_right_ndc.y, 1.f, 0.f, 0.f, 0.f, 1.f, 1.f, 0.f },
-                    { bottom_left_ndc.x, bottom_left_ndc.y, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f },
-                };
+            if (!quad.is_alive)
+            {
+                continue;
+            }
 
-                std::vector<std::uint32_t> indices { 0, 1, 2, 0, 3, 2 };
+            // Brick is destroyed: collapse its quad to a point, so it
+            // produces no fragments.
+            if (!a_coordinator.sprites.count(quad.id))
+            {
+                quad.is_alive = false;
+                patch_quad(quad_index, std::array<arci::vertex, 4> {});
+                continue;
+            }
 
-                arci::ivertex_buffer* vbo = engine->create_vertex_buffer(vertices);
-                arci::i_index_buffer* ebo = engine->create_ebo(indices);
-                arci::CHECK_NOTNULL(vbo);
-                arci::CHECK_NOTNULL(ebo);
+            const sprite& spr = a_coordinator.sprites.at(quad.id);
 
-                engine->render(vbo, ebo, texture);
-                engine->destroy_vertex_buffer(vbo);
-                engine->destroy_ebo(ebo);
+            if (spr.texture_layer != quad.texture_layer)
+            {
+                quad.texture_layer = spr.texture_layer;
+                patch_quad(quad_index,
+                           make_brick_quad(a_coordinator.positions.at(quad.id),
+                                           a_coordinator.bounds.at(quad.id),
+                                           spr.texture_layer));
             }
         }
     }
 
+    void brick_field_system::render(arci::iengine* engine)
+    {
+        if (!m_vertex_buffer)
+        {
+            return;
+        }
+
+        arci::mesh_command command {};
+        command.vertex_buffer = m_vertex_buffer;
+        command.ebo = m_index_buffer;
+        command.texture_array = m_texture_array;
+        command.layer = static_cast<std::uint8_t>(draw_layer::bricks);
+        // Bricks are solid, but for about 2% of the pixels on the rim
+        // which are a bit translucent. Drawn in the opaque pass, they
+        // hide the background behind them from shading.
+        command.blend = arci::blend_mode::alpha_test;
+
+        engine->submit(command);
+    }
+
+    void brick_field_system::destroy(arci::iengine* engine)
+    {
+        if (m_vertex_buffer)
+        {
+            engine->destroy_vertex_buffer(m_vertex_buffer);
+            m_vertex_buffer = nullptr;
+        }
+
+        if (m_index_buffer)
+        {
+            engine->destroy_ebo(m_index_buffer);
+            m_index_buffer = nullptr;
+        }
+
+        m_texture_array = nullptr;
+        m_quads.clear();
+    }
+
+    void brick_field_system::patch_quad(
+        const std::size_t quad_index,
+        const std::array<arci::vertex, 4>& vertices)
+    {
+        m_vertex_buffer->update(quad_index * vertices.size(),
+                                vertices.data(),
+                                vertices.size());
+    }
+
     void transform_system::update(coordinator& a_coordinator, const float dt)
     {
         for (entity i = 1; i <= entities_number; i++)
@@ -251,8 +370,11 @@ namespace arcanoid
 
         if (new_left_x < 0.f || new_right_x > screen_width)
         {
+            // Heard from the side of the wall.
+            arci::voice_parameters hit {};
+            hit.pan = new_left_x < 0.f ? -0.8f : 0.8f;
             a_coordinator.sounds["hit_ball"]->play(
-                arci::iaudio_buffer::running_mode::once);
+                arci::iaudio_buffer::running_mode::once, hit);
             tr.speed_x *= -1.f;
         }
 
@@ -467,6 +589,66 @@ namespace arcanoid
         }
     }
 
+    void stats_overlay_system::render(arci::iengine* engine)
+    {
+        const arci::render_stats stats = engine->get_render_stats();
+
+        ImGui::SetNextWindowPos(ImVec2(10.f, 10.f), ImGuiCond_Always);
+        ImGui::SetNextWindowBgAlpha(0.5f);
+
+        ImGuiWindowFlags window_flags = 0;
+        window_flags |= ImGuiWindowFlags_NoDecoration;
+        window_flags |= ImGuiWindowFlags_AlwaysAutoResize;
+        window_flags |= ImGuiWindowFlags_NoInputs;
+
+        ImGui::Begin("Render stats", nullptr, window_flags);
+
+        ImGui::Text("Draw calls: %zu", stats.draw_calls);
+        ImGui::Text("Queue state changes: %zu (unsorted %zu)",
+                    stats.queue_state_changes_sorted,
+                    stats.queue_state_changes_unsorted);
+        ImGui::Text("GL state calls: %zu issued, %zu avoided",
+                    stats.state_calls_issued,
+                    stats.state_calls_avoided);
+
+        ImGui::End();
+    }
+
+    void gpu_profiler_overlay_system::render(arci::iengine* engine,
+                                             const std::size_t width)
+    {
+        const arci::gpu_timings timings = engine->get_gpu_timings();
+
+        ImGui::SetNextWindowPos(ImVec2(width - 10.f, 10.f),
+                                ImGuiCond_Always,
+                                ImVec2(1.f, 0.f));
+        ImGui::SetNextWindowBgAlpha(0.5f);
+
+        ImGuiWindowFlags window_flags = 0;
+        window_flags |= ImGuiWindowFlags_NoDecoration;
+        window_flags |= ImGuiWindowFlags_AlwaysAutoResize;
+        window_flags |= ImGuiWindowFlags_NoInputs;
+
+        ImGui::Begin("GPU profiler", nullptr, window_flags);
+
+        ImGui::Text("%s timer, %zu frames dropped",
+                    timings.is_gpu_timer ? "GPU" : "CPU",
+                    timings.dropped_frames);
+        ImGui::Text("pass: avg / p50 / p95 / max, ms");
+
+        for (const arci::gpu_pass_timing& pass : timings.passes)
+        {
+            ImGui::Text("%s: %.3f / %.3f / %.3f / %.3f",
+                        pass.name.c_str(),
+                        pass.average_ms,
+                        pass.median_ms,
+                        pass.p95_ms,
+                        pass.max_ms);
+        }
+
+        ImGui::End();
+    }
+
     void game_over_system::update(
         coordinator& a_coordinator,
         game_status& status,
@@ -482,12 +664,9 @@ namespace arcanoid
         }
     }
 
-    void game_over_system::render(arci::iengine* engine,
-                                  const std::size_t width,
+    void game_over_system::render(const std::size_t width,
                                   const std::size_t height)
     {
-        engine->imgui_new_frame();
-
         const ImGuiViewport* main_viewport = ImGui::GetMainViewport();
         ImGui::SetNextWindowPos(ImVec2(main_viewport->WorkPos.x,
                                        main_viewport->WorkPos.y),
@@ -513,17 +692,12 @@ namespace arcanoid
         ImGui::PopStyleColor();
 
         ImGui::End();
-
-        engine->imgui_render();
     }
 
-    void menu_system::render(arci::iengine* engine,
-                             game_status& status,
+    void menu_system::render(game_status& status,
                              std::size_t width,
                              const std::size_t height)
     {
-        engine->imgui_new_frame();
-
         const ImGuiViewport* main_viewport = ImGui::GetMainViewport();
         ImGui::SetNextWindowPos(ImVec2(main_viewport->WorkPos.x,
                                        main_viewport->WorkPos.y),
@@ -582,7 +756,5 @@ namespace arcanoid
         ImGui::PopStyleColor();
 
         ImGui::End();
-
-        engine->imgui_render();
     }
 }
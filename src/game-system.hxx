@@ -9,9 +9,33 @@ namespace arcanoid
     {
         void render(arci::iengine* engine,
                     coordinator& a_coordinator);
+    };
+
+    // All bricks live in one GPU-resident mesh, which is built once at
+    // level load and drawn with a single draw call. Only quads of bricks
+    // which were destroyed or changed their texture layer are patched.
+    struct brick_field_system
+    {
+        void build(arci::iengine* engine, const coordinator& a_coordinator);
+        void update(const coordinator& a_coordinator);
+        void render(arci::iengine* engine);
+        void destroy(arci::iengine* engine);
 
-        std::size_t screen_width {};
-        std::size_t screen_height {};
+    private:
+        struct brick_quad
+        {
+            entity id {};
+            std::uint32_t texture_layer {};
+            bool is_alive { true };
+        };
+
+        void patch_quad(const std::size_t quad_index,
+                        const std::array<arci::vertex, 4>& vertices);
+
+        std::vector<brick_quad> m_quads {};
+        arci::ivertex_buffer* m_vertex_buffer { nullptr };
+        arci::i_index_buffer* m_index_buffer { nullptr };
+        arci::itexture_array* m_texture_array { nullptr };
     };
 
     struct transform_system
@@ -83,15 +107,33 @@ namespace arcanoid
                     game_status& status,
                     const std::size_t screen_height);
 
-        void render(arci::iengine* engine,
-                    std::size_t width,
-                    const std::size_t height);
+        void render(std::size_t width, const std::size_t height);
+    };
+
+    // Statistics of the last frame in the corner of the screen.
+    struct stats_overlay_system
+    {
+        void render(arci::iengine* engine);
+
+#ifndef NDEBUG
+        bool is_visible { true };
+#else
+        bool is_visible { false };
+#endif
+    };
+
+    // Rolling GPU time of the render passes in the top right corner,
+    // toggled by F3.
+    struct gpu_profiler_overlay_system
+    {
+        void render(arci::iengine* engine, const std::size_t width);
+
+        bool is_visible { false };
     };
 
     struct menu_system
     {
-        void render(arci::iengine* engine,
-                    game_status& status,
+        void render(game_status& status,
                     std::size_t width,
                     const std::size_t height);
     };
@@ -1,14 +1,23 @@
 #include "game.hxx"
 #include "helper.hxx"
 
+#include <algorithm>
 #include <chrono>
+#include <utility>
 
 namespace arcanoid
 {
+    game::game(const game_options& options)
+        : m_options { options }
+    {
+    }
+
     void game::main_loop()
     {
         on_init();
 
+        const auto start_time = std::chrono::steady_clock::now();
+
         bool loop_continue { true };
 
         while (loop_continue)
@@ -23,11 +32,76 @@ namespace arcanoid
                 break;
             }
 
-            const float frame_delta = m_frame_timer.getFrameDeltaTime();
+            // Fixed step keeps benchmark runs repeatable.
+            const float frame_delta = m_options.frames_limit
+                ? 1.f / 60.f
+                : m_frame_timer.getFrameDeltaTime();
             on_update(frame_delta);
 
             on_render();
+
+            const arci::render_stats stats = m_engine->get_render_stats();
+            m_run_stats.draw_calls += stats.draw_calls;
+            m_run_stats.vertices += stats.vertices;
+            m_run_stats.sounds_played += stats.sounds_played;
+            m_run_stats.texture_bytes = stats.texture_bytes;
+            m_run_stats.submit_time_ms += stats.submit_time_ms;
+            m_max_submit_time_ms = std::max(m_max_submit_time_ms,
+                                            stats.submit_time_ms);
+            m_frames++;
+
+            if (m_options.frames_limit && m_frames >= m_options.frames_limit)
+            {
+                loop_continue = false;
+            }
+        }
+
+        if (m_options.frames_limit)
+        {
+            const std::chrono::duration<double> elapsed
+                = std::chrono::steady_clock::now() - start_time;
+            print_run_report(elapsed.count());
+        }
+    }
+
+    void game::print_run_report(const double seconds) const
+    {
+#ifndef __ANDROID__
+        const double frames = static_cast<double>(m_frames);
+
+        fmt::print("frames: {}\n"
+                   "time: {:.3f} s ({:.4f} ms per frame)\n"
+                   "draw calls per frame: {:.1f}\n"
+                   "vertices per frame: {:.1f}\n"
+                   "texture bytes: {}\n"
+                   "sounds played: {}\n"
+                   "GL submit time per frame: {:.4f} ms (max {:.4f} ms)\n",
+                   m_frames,
+                   seconds,
+                   seconds * 1000.0 / frames,
+                   m_run_stats.draw_calls / frames,
+                   m_run_stats.vertices / frames,
+                   m_run_stats.texture_bytes,
+                   m_run_stats.sounds_played,
+                   m_run_stats.submit_time_ms / frames,
+                   m_max_submit_time_ms);
+
+        for (const auto& [name, type] :
+             { std::pair { "textures", arci::resource_type::texture },
+               std::pair { "texture arrays",
+                           arci::resource_type::texture_array },
+               std::pair { "sounds", arci::resource_type::sound } })
+        {
+            const arci::resource_usage usage = m_resources->get_usage(type);
+            fmt::print("{}: {} loaded, {} references, {} bytes\n",
+                       name,
+                       usage.resources,
+                       usage.references,
+                       usage.bytes);
         }
+#else
+        static_cast<void>(seconds);
+#endif
     }
 
     void game::on_event()
@@ -41,6 +115,12 @@ namespace arcanoid
                 break;
             }
 
+            if (event.key_info == arci::key_event::profiler_button_pressed)
+            {
+                m_gpu_profiler_overlay_system.is_visible
+                    = !m_gpu_profiler_overlay_system.is_visible;
+            }
+
             if (m_status == game_status::game)
             {
                 m_input_system.event = event;
@@ -70,48 +150,76 @@ namespace arcanoid
 
     void game::on_render()
     {
+        // All ImGui windows of the frame are drawn on top of the game.
+        m_engine->imgui_new_frame();
+
         if (m_status == game_status::game_over)
         {
-            m_game_over_system.render(m_engine.get(),
-                                      m_screen_w,
-                                      m_screen_h);
+            m_game_over_system.render(m_screen_w, m_screen_h);
         }
         else if (m_status == game_status::main_menu)
         {
-            m_menu_system.render(m_engine.get(),
-                                 m_status,
+            m_menu_system.render(m_status,
                                  m_screen_w,
                                  m_screen_h);
         }
         else
         {
+            m_brick_field_system.update(m_coordinator);
             m_sprite_system.render(m_engine.get(), m_coordinator);
+            m_brick_field_system.render(m_engine.get());
+            m_engine->execute_render_queue();
+
+            if (m_stats_overlay_system.is_visible)
+            {
+                m_stats_overlay_system.render(m_engine.get());
+            }
         }
 
+        if (m_gpu_profiler_overlay_system.is_visible)
+        {
+            m_gpu_profiler_overlay_system.render(m_engine.get(), m_screen_w);
+        }
+
+        m_engine->imgui_render();
         m_engine->swap_buffers();
     }
 
     void game::on_init()
     {
         m_engine = std::unique_ptr<arci::iengine, void (*)(arci::iengine*)> {
-            arci::engine_create(),
+            arci::engine_create(m_options.backend),
             arci::engine_destroy
         };
 
         m_engine->init();
+        m_resources = std::make_unique<arci::resource_manager>(m_engine.get());
+
+        m_engine->set_layer_name(
+            static_cast<std::uint8_t>(draw_layer::background), "background");
+        m_engine->set_layer_name(
+            static_cast<std::uint8_t>(draw_layer::bricks), "bricks");
+        m_engine->set_layer_name(
+            static_cast<std::uint8_t>(draw_layer::actors), "actors");
+
+        // Nobody is going to click through the menu.
+        if (m_options.backend != arci::engine_backend::sdl)
+        {
+            m_status = game_status::game;
+        }
 
         const auto [w, h] = m_engine->get_screen_resolution();
         m_screen_w = w;
         m_screen_h = h;
-        m_sprite_system.screen_width = w;
-        m_sprite_system.screen_height = h;
 
-        arci::iaudio_buffer* background_sound
-            = m_engine->create_audio_buffer("res/music.wav");
-        arci::iaudio_buffer* hit_ball_sound
-            = m_engine->create_audio_buffer("res/hit.wav");
-        m_coordinator.sounds.insert({ "background", background_sound });
-        m_coordinator.sounds.insert({ "hit_ball", hit_ball_sound });
+        for (const auto& [name, path] :
+             { std::pair { "background", "res/music.wav" },
+               std::pair { "hit_ball", "res/hit.wav" } })
+        {
+            const arci::sound_handle sound = m_resources->acquire_sound(path);
+            m_sounds.push_back(sound);
+            m_coordinator.sounds.insert({ name, m_resources->get(sound) });
+        }
 
         m_coordinator.sounds["background"]->play(
             arci::iaudio_buffer::running_mode::for_ever);
@@ -122,17 +230,37 @@ namespace arcanoid
 
     game::~game()
     {
-        for (auto texture : m_textures)
+        m_brick_field_system.destroy(m_engine.get());
+
+        for (arci::texture_handle& texture : m_textures)
         {
-            m_engine->destroy_texture(texture);
+            m_resources->release(texture);
         }
 
-        m_engine->uninit();
+        for (arci::texture_array_handle& texture_array : m_texture_arrays)
+        {
+            m_resources->release(texture_array);
+        }
 
-        for (auto [_, audio_buffer] : m_coordinator.sounds)
+        m_coordinator.sounds.clear();
+
+        // Sounds go while the device still plays, the music stream stops
+        // reading the asset pack before the engine unmounts it.
+        for (arci::sound_handle& sound : m_sounds)
         {
-            m_engine->destroy_audio_buffer(audio_buffer);
+            m_resources->release(sound);
         }
+
+        m_engine->uninit();
+
+        m_resources.reset();
+    }
+
+    arci::texture_handle game::acquire_texture(const std::string_view path)
+    {
+        const arci::texture_handle texture = m_resources->acquire_texture(path);
+        m_textures.push_back(texture);
+        return texture;
     }
 
     void game::init_world()
@@ -141,16 +269,34 @@ namespace arcanoid
         init_bricks();
         init_ball();
         init_platform();
+
+        m_brick_field_system.build(m_engine.get(), m_coordinator);
     }
 
     void game::init_bricks()
     {
-        arci::itexture* yellow_brick_texture
-            = m_engine->create_texture("res/yellow_brick.png");
-        arci::CHECK_NOTNULL(yellow_brick_texture);
-        m_textures.push_back(yellow_brick_texture);
-
+        // All bricks have the same size, so they share one texture array
+        // and every row of bricks just picks its own layer.
+        const arci::texture_array_handle bricks_handle
+            = m_resources->acquire_texture_array({
+                "res/yellow_brick.png",
+                "res/orange_brick.png",
+                "res/red_brick.png",
+                "res/marron_brick.png",
+                "res/purple_brick.png",
+                "res/blue_brick.png",
+                "res/dark_blue_brick.png",
+            });
+        m_texture_arrays.push_back(bricks_handle);
+
+        arci::itexture_array* bricks_texture = m_resources->get(bricks_handle);
+        arci::CHECK_NOTNULL(bricks_texture);
+
+        const std::size_t layers_number = bricks_texture->get_layers_number();
+
+        // Every row has its own colour, one layer of the array each.
         constexpr int num_bricks_w { 9 }, num_bricks_h { 7 };
+        arci::CHECK(layers_number == static_cast<std::size_t>(num_bricks_h));
 
         const float brick_width {
             static_cast<float>(m_screen_w) / num_bricks_w
@@ -178,7 +324,10 @@ namespace arcanoid
                     = m_coordinator.bounds.insert({ brick, brick_bound });
                 arci::CHECK(bound_inserted);
 
-                sprite brick_sprite { yellow_brick_texture };
+                sprite brick_sprite {};
+                brick_sprite.texture_array = bricks_texture;
+                brick_sprite.texture_layer = i % layers_number;
+                brick_sprite.layer = draw_layer::bricks;
                 const auto [it3, sprite_inserted]
                     = m_coordinator.sprites.insert({ brick, brick_sprite });
                 arci::CHECK(sprite_inserted);
@@ -188,6 +337,11 @@ namespace arcanoid
                     = m_coordinator.collidable_entities.insert(
                         { brick, collision_component });
                 arci::CHECK(collision_inserted);
+
+                const auto [it5, static_inserted]
+                    = m_coordinator.static_geometries.insert(
+                        { brick, static_geometry {} });
+                arci::CHECK(static_inserted);
             }
         }
     }
@@ -197,9 +351,8 @@ namespace arcanoid
         entity background = create_entity();
 
         arci::itexture* background_texture
-            = m_engine->create_texture("res/background1.png");
+            = m_resources->get(acquire_texture("res/background1.png"));
         arci::CHECK_NOTNULL(background_texture);
-        m_textures.push_back(background_texture);
 
         position pos { 0.f, 0.f };
 
@@ -215,6 +368,10 @@ namespace arcanoid
         arci::CHECK(bound_inserted);
 
         sprite spr { background_texture };
+        spr.layer = draw_layer::background;
+        // Background has no transparent pixels, so it does not need
+        // blending, which is expensive for a full-screen quad.
+        spr.blend = arci::blend_mode::opaque;
         const auto [it3, sprite_inserted]
             = m_coordinator.sprites.insert({ background, spr });
         arci::CHECK(sprite_inserted);
@@ -225,9 +382,8 @@ namespace arcanoid
         entity ball = create_entity();
 
         arci::itexture* texture
-            = m_engine->create_texture("res/ball.png");
+            = m_resources->get(acquire_texture("res/ball.png"));
         arci::CHECK_NOTNULL(texture);
-        m_textures.push_back(texture);
 
         const float ball_width { m_screen_w / 45.f };
         const float ball_height { m_screen_w / 45.f };
@@ -273,9 +429,8 @@ namespace arcanoid
         entity platform = create_entity();
 
         arci::itexture* texture
-            = m_engine->create_texture("res/platform1.png");
+            = m_resources->get(acquire_texture("res/platform1.png"));
         arci::CHECK_NOTNULL(texture);
-        m_textures.push_back(texture);
 
         const float platform_width { m_screen_w / 6.f };
         const float platform_height { m_screen_w / 35.f };
@@ -292,6 +447,9 @@ namespace arcanoid
         arci::CHECK(pos_inserted);
 
         sprite spr { texture };
+        // Pixels around the platform shape are clear, the rest is solid
+        // as in bricks (see brick_field_system::render).
+        spr.blend = arci::blend_mode::alpha_test;
         const auto [it2, sprite_inserted]
             = m_coordinator.sprites.insert({ platform, spr });
         arci::CHECK(sprite_inserted);
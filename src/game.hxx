@@ -5,6 +5,7 @@
 #include "engine.hxx"
 #include "entity.hxx"
 #include "game-system.hxx"
+#include "resource-manager.hxx"
 
 #include "FrameTimer.hxx"
 
@@ -12,9 +13,18 @@
 
 namespace arcanoid
 {
+    struct game_options
+    {
+        arci::engine_backend backend { arci::get_default_engine_backend() };
+        // Stop after this number of frames with fixed time step and print
+        // frame statistics, 0 means play until quit.
+        std::size_t frames_limit {};
+    };
+
     class game final
     {
     public:
+        explicit game(const game_options& options = game_options {});
         void main_loop();
         ~game();
 
@@ -30,20 +40,36 @@ namespace arcanoid
         void init_platform();
         void init_background();
 
-        std::vector<arci::itexture*> m_textures {};
+        void print_run_report(const double seconds) const;
+
+        arci::texture_handle acquire_texture(const std::string_view path);
+
+        std::vector<arci::texture_handle> m_textures {};
+        std::vector<arci::texture_array_handle> m_texture_arrays {};
+        std::vector<arci::sound_handle> m_sounds {};
 
         cFrameTimer m_frame_timer;
         coordinator m_coordinator {};
         input_system m_input_system {};
         sprite_system m_sprite_system {};
+        brick_field_system m_brick_field_system {};
         transform_system m_transform_system {};
         collision_system m_collision_system {};
         game_over_system m_game_over_system {};
         menu_system m_menu_system {};
+        stats_overlay_system m_stats_overlay_system {};
+        gpu_profiler_overlay_system m_gpu_profiler_overlay_system {};
 
         std::unique_ptr<arci::iengine,
                         void (*)(arci::iengine*)>
             m_engine { nullptr, nullptr };
+        std::unique_ptr<arci::resource_manager> m_resources {};
+        game_options m_options {};
+        // Render statistics summed over all frames of the run.
+        arci::render_stats m_run_stats {};
+        std::size_t m_frames {};
+        float m_max_submit_time_ms {};
+
         std::size_t m_screen_w {};
         std::size_t m_screen_h {};
         game_status m_status { game_status::main_menu };
@@ -1,5 +1,69 @@
 #include "game.hxx"
 
+#include <fmt/core.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <string_view>
+
+// Command line options:
+//   --engine=NAME   sdl, null or offscreen (see ARCI_ENGINE variable)
+//   --frames=N      stop after N frames (N > 0) and print frame statistics
+[[noreturn]] static void exit_with_usage(const std::string_view arg)
+{
+    fmt::print(stderr,
+               "Invalid option {}\n"
+               "Usage: arcanoid [--engine=sdl|null|offscreen] [--frames=N]\n",
+               arg);
+    std::exit(EXIT_FAILURE);
+}
+
+static arcanoid::game_options parse_options(int argc, char* argv[])
+{
+    arcanoid::game_options options {};
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg { argv[i] };
+
+        if (arg == "--engine=null")
+        {
+            options.backend = arci::engine_backend::null;
+        }
+        else if (arg == "--engine=offscreen")
+        {
+            options.backend = arci::engine_backend::offscreen;
+        }
+        else if (arg == "--engine=sdl")
+        {
+            options.backend = arci::engine_backend::sdl;
+        }
+        else if (arg.substr(0, 9) == "--engine=")
+        {
+            // Falling back to a window on a headless machine is worse
+            // than stopping.
+            exit_with_usage(arg);
+        }
+        else if (arg.substr(0, 9) == "--frames=")
+        {
+            const char* value = argv[i] + 9;
+            char* end { nullptr };
+            const unsigned long frames = std::strtoul(value, &end, 10);
+
+            // 0 would mean no limit, strtoul also takes signs and spaces.
+            if (!std::isdigit(static_cast<unsigned char>(*value)) || *end
+                || frames == 0)
+            {
+                exit_with_usage(arg);
+            }
+
+            options.frames_limit = frames;
+        }
+    }
+
+    return options;
+}
+
 #ifdef __ANDROID__
 // IMPORTANT NOTE: we should define visibility default and
 // replace `main` with `SDL_main`, otherwise there will be
@@ -8,12 +72,12 @@
 // https://github.com/urho3d/Urho3D/issues/2267
 // And also this:
 // https://github.com/libsdl-org/SDL/issues/2989
-extern "C" __attribute__((visibility("default"))) int SDL_main(int /*argc*/, char* /*argv*/[])
+extern "C" __attribute__((visibility("default"))) int SDL_main(int argc, char* argv[])
 #else
-int main(int /*argc*/, char* /*argv*/[])
+int main(int argc, char* argv[])
 #endif
 {
-    arcanoid::game arcanoid {};
+    arcanoid::game arcanoid { parse_options(argc, argv) };
     arcanoid.main_loop();
     return EXIT_SUCCESS;
 }